@@ -1,6 +1,12 @@
 #ifndef __PROJECT2_H__
 #define __PROJECT2_H__
 
+#include <linux/types.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
+#include <linux/random.h>
+#include <linux/sched.h>
+
 /**
 * @brief Enum for the tests to be carried out.
 */
@@ -8,19 +14,272 @@ typedef enum project2_ds_type_t {
 	PROJECT2_LIST = 0x0,
 	PROJECT2_QUEUE,
 	PROJECT2_MAP,
-	PROJECT2_RBTREE
+	PROJECT2_RBTREE,
+	PROJECT2_SARRAY,
+	PROJECT2_RCU_LIST,
+	PROJECT2_LLIST,
+	PROJECT2_PCPU_QUEUE,
+	PROJECT2_RING,
+	PROJECT2_TQUEUE,
+	PROJECT2_XARRAY,
+	PROJECT2_RBTREE_CACHED,
+	PROJECT2_OSTREE,
+	PROJECT2_RBTREE_LATCH,
+	PROJECT2_EYTZINGER,
+	PROJECT2_SBTREE,
+	PROJECT2_HTABLE,
+	PROJECT2_RHASHTABLE,
+	PROJECT2_ULIST,
+	PROJECT2_NR_TYPES
 } project2_ds_type;
 
+/**
+* @brief Synchronization wrapped around a handle shared by several threads
+*/
+typedef enum project2_sync_t {
+	PROJECT2_SYNC_NONE = 0x0,
+	PROJECT2_SYNC_SPIN,
+	PROJECT2_SYNC_RWLOCK,
+	PROJECT2_SYNC_MUTEX,
+	PROJECT2_NR_SYNCS
+} project2_sync;
+
+/**
+* @brief Benchmarks which can be selected for a run
+*/
+typedef enum project2_bench_t {
+	PROJECT2_BENCH_SUITE = 0x0,
+	PROJECT2_BENCH_READERS,
+	PROJECT2_BENCH_INGEST,
+	PROJECT2_BENCH_DRAIN,
+	PROJECT2_BENCH_IDMAP,
+	PROJECT2_BENCH_HOLD,
+	PROJECT2_BENCH_OSTAT,
+	PROJECT2_BENCH_BUILD,
+	PROJECT2_BENCH_ITER,
+	PROJECT2_NR_BENCHES
+} project2_bench;
+
+/**
+* @brief lookup modifies the context, so it can not run concurrently with
+*		other lookups under a read lock
+*/
+#define PROJECT2_HANDLE_LOOKUP_WRITES 0x1
+
+/**
+* @brief Every op synchronizes internally, so threads may share the handle
+*		without any PROJECT2_SYNC_* lock
+*/
+#define PROJECT2_HANDLE_THREAD_SAFE 0x2
+
+/**
+* @brief add_batch may run on any number of threads at once, next to a
+*		single thread running remove_batch
+*/
+#define PROJECT2_HANDLE_MULTI_PRODUCER 0x4
+
+/**
+* @brief Size of the buffer keeping the report of the last run
+*/
+#define PROJECT2_REPORT_SIZE (64 * 1024)
+
+
+/**
+* @brief Number of log2 buckets in a latency histogram
+*/
+#define PROJECT2_HIST_BUCKETS 64
+
+/**
+* @brief Log2 latency histogram, bucket b holds samples in [2^(b-1), 2^b) ns
+*/
+typedef struct project2_hist_t {
+	u64 buckets[PROJECT2_HIST_BUCKETS]; /*Samples per log2 bucket */
+	u64 count; /*Number of samples recorded */
+	u64 sum_ns; /*Sum of all the samples */
+	u64 max_ns; /*Largest sample seen */
+} project2_hist;
+
+struct perf_event;
+
+/**
+* @brief Counter of the cache misses of the calling thread
+*/
+typedef struct project2_llc_t {
+	struct perf_event *event; /*NULL if the PMU offers no such counter */
+} project2_llc;
+
+/**
+* @brief Allocator used for the nodes of the list and rbtree
+*/
+typedef enum project2_alloc_mode_t {
+	PROJECT2_ALLOC_KMALLOC = 0x0,
+	PROJECT2_ALLOC_SLAB,
+	PROJECT2_ALLOC_BULK
+} project2_alloc_mode;
+
+/**
+* @brief How the id maps (map, xarray) hand out ids to add
+*/
+typedef enum project2_id_mode_t {
+	PROJECT2_ID_DENSE = 0x0, /*Lowest free id in [0, size) */
+	PROJECT2_ID_CYCLIC, /*Next id after the last one, up to INT_MAX */
+	PROJECT2_ID_SPARSE, /*Every key is its own id */
+	PROJECT2_NR_ID_MODES
+} project2_id_mode;
+
+/**
+* @brief Number of objects moved per kmem_cache bulk call
+*/
+#define PROJECT2_POOL_BATCH 32
+
+/**
+* @brief Node allocator of one data structure
+*/
+typedef struct project2_pool_t {
+	const char *name; /*Name of the dedicated kmem_cache */
+	size_t size; /*Size of one node */
+	size_t align; /*Alignment of one node, the natural one of its type */
+	struct kmem_cache *cache; /*Dedicated cache, NULL before init */
+} project2_pool;
+
+/**
+* @brief Stack of nodes which are allocated or freed in bulk
+*/
+typedef struct project2_pool_batch_t {
+	project2_pool *pool; /*Pool owning the nodes */
+	int nr; /*Number of nodes on the stack */
+	void *objs[PROJECT2_POOL_BATCH]; /*Nodes to be handed out or freed */
+} project2_pool_batch;
+
+/**
+* @brief Initializer for a pool holding nodes of type
+*/
+#define PROJECT2_POOL_INIT(pool_name, type) \
+	{ .name = pool_name, .size = sizeof(type), \
+	  .align = __alignof__(type), .cache = NULL }
+
+/**
+* @brief Initializer for a bulk batch of the pool
+*/
+#define PROJECT2_POOL_BATCH_INIT(pool_ptr) \
+	{ .pool = pool_ptr, .nr = 0 }
+
+/**
+* @brief Key distributions offered by the workload generator
+*/
+typedef enum project2_dist_t {
+	PROJECT2_DIST_UNIQUE = 0x0,
+	PROJECT2_DIST_UNIFORM,
+	PROJECT2_DIST_SEQUENTIAL,
+	PROJECT2_DIST_REVERSE,
+	PROJECT2_DIST_ZIPF,
+	PROJECT2_DIST_HOTSET,
+	PROJECT2_DIST_SAWTOOTH,
+	PROJECT2_NR_DISTS
+} project2_dist;
+
+/**
+* @brief Operations of a mixed workload
+*/
+typedef enum project2_op_t {
+	PROJECT2_OP_INSERT = 0x0,
+	PROJECT2_OP_LOOKUP,
+	PROJECT2_OP_DELETE,
+	PROJECT2_NR_OPS
+} project2_op;
+
+/**
+* @brief Parameters of the workload generator
+*/
+typedef struct project2_workload_params_t {
+	project2_dist dist; /*Distribution of the keys */
+	int zipf_theta; /*Zipfian skew in hundredths, 1..99 */
+	int hot_keys_pct; /*Share of the key range which is hot */
+	int hot_ops_pct; /*Share of the accesses going to the hot keys */
+	int saw_period; /*Number of keys per tooth of the sawtooth */
+	int op_pct[PROJECT2_NR_OPS]; /*Share of every op, summing to 100 */
+	u64 seed; /*Seed of the generator, 0 for a random one */
+} project2_workload_params;
+
+/**
+* @brief Pre-generated workload, kept outside of the timed regions
+*/
+typedef struct project2_workload_t {
+	int *keys; /*Keys of the workload */
+	u8 *ops; /*project2_op of every key */
+	int nr; /*Number of keys and ops */
+	int range; /*Keys are drawn from [0, range) */
+	u64 seed; /*Seed which reproduces the workload */
+	struct rnd_state rnd; /*Generator state after the workload */
+} project2_workload;
+
+/**
+* @brief Configuration of one benchmark run, set through debugfs
+*/
+typedef struct project2_config_t {
+	int type; /*project2_ds_type or PROJECT2_NR_TYPES for all of them */
+	int size; /*Number of integers to be inserted */
+	int batch; /*Batch size compared by the batch test, 0 to skip it */
+	int dist; /*project2_dist of the keys */
+	int threads; /*Number of threads running the benchmark */
+	int cpu; /*CPU the run is bound to, -1 for any */
+	int sync; /*project2_sync wrapped around the handle by the threads */
+	int bench; /*project2_bench to be run */
+} project2_config;
+
+/**
+* @brief Source of distinct keys in [0, range) without rejection retries.
+*
+* A full period LCG modulo the next power of two visits every state once,
+* the output is scrambled by a bijection and values above range are skipped.
+*/
+typedef struct project2_keyseq_t {
+	u32 state; /*Current state of the LCG */
+	u32 mult; /*Multiplier, 1 modulo 4 for a full period */
+	u32 inc; /*Increment, odd for a full period */
+	u32 mask; /*Power of two modulus minus one */
+	u32 shift; /*Shift of the xorshift scrambling */
+	u32 range; /*Keys are drawn from [0, range) */
+} project2_keyseq;
 
 /**
 * @brief Function Pointer table to carry out the test.
+*
+* add inserts the size keys of the pre-generated workload in order.
+* The histogram passed to add, remove and iterate records one sample per
+* element and may be NULL when per element timing is not wanted.
+*
+* add_batch inserts nr keys and returns 0 or an error code. remove_batch
+* removes up to nr elements in the natural order of the data structure
+* (oldest first for list and queue, smallest key first for map and rbtree),
+* stores them in keys and returns how many were removed or an error code.
+* The batch operations are optional and NULL when not implemented.
+*
+* lookup returns true if key is present. It is optional as well; the map is
+* looked up by id, which is the key for elements inserted by add_batch.
+*
+* remove_range erases every key in [start, end] and returns how many were
+* erased or an error code. It is optional and only offered by ordered
+* structures.
 */
 typedef struct project2_handle_t {
 	int (*init) (int size, void **context);
-	int (*add) (void *context, int size);
-	int (*remove) (void *context);
-	void (*iterate) (void *context);
+	int (*add) (void *context, const int *keys, int size, project2_hist *hist);
+	int (*remove) (void *context, project2_hist *hist);
+	void (*iterate) (void *context, project2_hist *hist);
 	void (*deinit) (void *context);
+	int (*add_batch) (void *context, const int *keys, int nr);
+	int (*remove_batch) (void *context, int *keys, int nr);
+	bool (*lookup) (void *context, int key);
+	int (*remove_range) (void *context, int start, int end);
+	int (*peek_min) (void *context, int *key);
+	int (*pop_min) (void *context, int *key);
+	int (*rank) (void *context, int key);
+	int (*select) (void *context, int k, int *key);
+	int (*build) (void *context, const int *keys, int nr);
+	void (*report) (void *context); /*Prints figures of the structure itself */
+	s64 (*sum) (void *context); /*Adds up every value, without any trace */
+	unsigned int flags; /*PROJECT2_HANDLE_* properties of the type */
 	void *context;
 } project2_handle;
 
@@ -42,17 +301,35 @@ typedef struct project2_ds_handle_t {
 #define PROJECT2_GENERATE_HANDLE_ARRAY(type) \
 	{project2_get_##type##_handle,  project2_free_##type##_handle, #type}
 
+/**
+* @brief Registers the optional operation op of type in the handle
+*
+* @param type Type of the test
+* @param op Name of the operation, implemented as op_type
+*/
+#define PROJECT2_HANDLE_OP(type, op) ((*handle)->op = op##_##type)
+
+/**
+* @brief Sets PROJECT2_HANDLE_* properties of type in the handle
+*
+* @param type Type of the test
+* @param bits PROJECT2_HANDLE_* flags
+*/
+#define PROJECT2_HANDLE_FLAGS(type, bits) ((*handle)->flags |= (bits))
+
 /**
 * @brief Generates the handlw functions for the tests
 *
 * @param type Type of the test
+* @param ... PROJECT2_HANDLE_OP and PROJECT2_HANDLE_FLAGS entries for the
+*		optional operations
 *
 * @return 0 for success or -ENOMEM in failure.
 */
-#define PROJECT2_GENERATE_HANDLE(type) 										\
+#define PROJECT2_GENERATE_HANDLE(type, ...) 								\
 	int project2_get_##type##_handle(project2_handle **handle) 				\
 	{ 																		\
-		*handle = kmalloc (sizeof(project2_handle), GFP_KERNEL); 			\
+		*handle = kzalloc (sizeof(project2_handle), GFP_KERNEL); 			\
 		if (*handle == NULL) { 												\
 			printk (KERN_INFO "memory allocation for" #type "handle failed\n");\
 			return -ENOMEM; 												\
@@ -62,6 +339,7 @@ typedef struct project2_ds_handle_t {
 		(*handle)->remove = remove_##type; 									\
 		(*handle)->iterate = show_##type; 									\
 		(*handle)->deinit = deinit_##type; 									\
+		__VA_ARGS__; 														\
 		return 0; 															\
 	} 																		\
 																			\
@@ -86,24 +364,627 @@ PROJECT2_GENERATE_HANDLE_PROTOTYPE(list);
 PROJECT2_GENERATE_HANDLE_PROTOTYPE(queue);
 PROJECT2_GENERATE_HANDLE_PROTOTYPE(map);
 PROJECT2_GENERATE_HANDLE_PROTOTYPE(rbtree);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(sarray);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(rculist);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(llist);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(pcpu_queue);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(ring);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(tqueue);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(xarray);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(rbtree_cached);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(ostree);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(rbtree_latch);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(eytzinger);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(sbtree);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(htable);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(rhashtable);
+PROJECT2_GENERATE_HANDLE_PROTOTYPE(ulist);
+
+/**
+* @brief Returns the ceiling power 2 for the given size
+*
+* @param size Size to be processed
+*
+* @return Ceiling power 2 for the input size or -EINVAL on overflow
+*/
+int project2_queue_size(int size);
+
+
+/**
+* @brief Allocation flags of the per element operations, GFP_ATOMIC while
+*		they run under a spinlock
+*/
+extern gfp_t project2_gfp;
+
+/**
+* @brief Id allocation of the id maps created from now on
+*/
+extern project2_id_mode project2_id_alloc;
+
+/**
+* @brief Allocator used by the pools, one of project2_alloc_mode
+*/
+extern project2_alloc_mode project2_pool_mode;
+
+/**
+* @brief Pools of the data structures, registered in project2_alloc.c
+*/
+extern project2_pool project2_list_pool;
+extern project2_pool project2_rbtree_pool;
+extern project2_pool project2_llist_pool;
+extern project2_pool project2_ostree_pool;
+extern project2_pool project2_htable_pool;
+extern project2_pool project2_ulist_pool;
+
+/**
+* @brief Creates the dedicated kmem_cache of every pool
+*
+* @return 0 for success or -ENOMEM in failure.
+*/
+int project2_pools_create(void);
+
+/**
+* @brief Destroys the dedicated kmem_cache of every pool
+*/
+void project2_pools_destroy(void);
+
+/**
+* @brief Allocates one node from the pool
+*
+* @param pool Pool to allocate from
+* @param gfp Allocation flags
+*
+* @return Node or NULL on failure
+*/
+void *project2_pool_alloc(project2_pool *pool, gfp_t gfp);
+
+/**
+* @brief Returns one node to the pool
+*
+* @param pool Pool the node was allocated from
+* @param obj Node to be freed
+*/
+void project2_pool_free(project2_pool *pool, void *obj);
+
+/**
+* @brief Allocates one node, refilling the batch in bulk if needed
+*
+* @param batch Batch of the pool
+* @param gfp Allocation flags
+*
+* @return Node or NULL on failure
+*/
+void *project2_pool_get(project2_pool_batch *batch, gfp_t gfp);
+
+/**
+* @brief Frees one node, the free is deferred to a bulk free if needed
+*
+* @param batch Batch of the pool
+* @param obj Node to be freed
+*/
+void project2_pool_put(project2_pool_batch *batch, void *obj);
+
+/**
+* @brief Frees every node left on the batch
+*
+* @param batch Batch of the pool
+*/
+void project2_pool_flush(project2_pool_batch *batch);
+
+/**
+* @brief Compares alloc/free cost and footprint of every pool per allocator
+*
+* @param size Number of nodes allocated for the comparison
+*/
+void project2_pools_report(int size);
+
+/**
+* @brief Returns the key range used for size elements, which is
+*		size*4 unless that overflows
+*
+* @param size Number of elements to be inserted
+*
+* @return Upper bound (EXCLUSIVE) of the keys
+*/
+int project2_key_range(int size);
+
+/**
+* @brief Starts a sequence of distinct keys in [0, range)
+*
+* @param seq Sequence to be initialized
+* @param range Upper bound (EXCLUSIVE) of the keys
+* @param rnd Random state drawing the parameters of the sequence
+*/
+void project2_keyseq_init(project2_keyseq *seq, u32 range,
+						struct rnd_state *rnd);
+
+/**
+* @brief Returns the next key of the sequence, distinct from the previous
+*		ones until the range is exhausted
+*
+* @param seq Sequence initialized by project2_keyseq_init
+*
+* @return Key in [0, range)
+*/
+int project2_keyseq_next(project2_keyseq *seq);
+
+/**
+* @brief Comparison callback for sorting the integer keys
+*
+* @param a First key
+* @param b Second key
+*
+* @return Negative, zero or positive as a is below, equal to or above b
+*/
+int project2_cmp_int(const void *a, const void *b);
+
+/**
+* @brief Default parameters of the workload generator
+*/
+extern project2_workload_params project2_wl_params;
+
+/**
+* @brief Looks up a distribution by name
+*
+* @param name Name of the distribution
+*
+* @return project2_dist or -EINVAL if the name is unknown
+*/
+int project2_dist_parse(const char *name);
+
+/**
+* @brief Returns the name of a distribution
+*
+* @param dist Distribution
+*
+* @return Name of the distribution
+*/
+const char *project2_dist_name(project2_dist dist);
+
+/**
+* @brief Pre-generates nr keys in [0, range) and their ops
+*
+* @param wl Workload to be filled, released with project2_workload_free
+* @param params Parameters of the generator
+* @param nr Number of keys
+* @param range Upper bound (EXCLUSIVE) of the keys
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_workload_generate(project2_workload *wl,
+			const project2_workload_params *params, int nr, int range);
+
+/**
+* @brief Releases the buffers of the workload
+*
+* @param wl Workload to be released
+*/
+void project2_workload_free(project2_workload *wl);
+
+/**
+* @brief Prints the parameters which reproduce the workload
+*
+* @param wl Workload generated by project2_workload_generate
+* @param params Parameters it was generated with
+*/
+void project2_workload_print(const project2_workload *wl,
+			const project2_workload_params *params);
+
+/**
+* @brief Every how many elements the data structures log one element.
+*		0 disables the per element trace.
+*/
+extern int project2_trace_interval;
+
+/**
+* @brief Checks whether the element at index has to be logged
+*
+* @param index Position of the element in the current loop
+*
+* @return true if the element is part of the sampled trace
+*/
+static inline bool project2_trace_enabled(unsigned long index)
+{
+	return project2_trace_interval &&
+			!(index % project2_trace_interval);
+}
+
+/**
+* @brief Logs the element at index if it is part of the sampled trace
+*
+* @param index Position of the element in the current loop
+* @param fmt printk format for the element
+*/
+#define PROJECT2_TRACE(index, fmt, ...) 						\
+	do { 													\
+		if (project2_trace_enabled(index)) 					\
+			printk(KERN_INFO fmt, ##__VA_ARGS__); 			\
+	} while (0)
+
+/**
+* @brief Number of elements a long loop runs between resched points
+*/
+#define PROJECT2_RESCHED_INTERVAL 1024
+
+/**
+* @brief Set on module unload to cancel the run in flight
+*/
+extern bool project2_stop;
+
+/**
+* @brief Resched point of the long loops, yields the CPU every
+*		PROJECT2_RESCHED_INTERVAL elements. The first element never
+*		yields so single element calls are safe in atomic context.
+*
+* Loops which allocate return -EINTR once the run is cancelled, loops
+* which free keep going so that nothing is leaked.
+*
+* @param index Position of the element in the current loop
+*
+* @return true if the run has been cancelled
+*/
+static inline bool project2_yield(unsigned long index)
+{
+	if (!index || (index % PROJECT2_RESCHED_INTERVAL))
+		return false;
+
+	cond_resched();
+
+	return READ_ONCE(project2_stop);
+}
+
+/**
+* @brief Starts fn on the runner kthread, bound to cfg->cpu if set
+*
+* @param fn Benchmark to be run
+* @param cfg Configuration of the run, copied by the runner
+*
+* @return 0 for success, -EBUSY if a run is in flight or appropriate
+*		error code on failure.
+*/
+int project2_runner_start(int (*fn)(const project2_config *cfg),
+					const project2_config *cfg);
+
+/**
+* @brief Cancels the run in flight and waits for the runner to exit
+*/
+void project2_runner_stop(void);
+
+/**
+* @brief Gets the handle of type without a context, to query its ops
+*
+* @param type Type of the test.
+* @param handle Receives the handle.
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+int project2_handle_get(project2_ds_type type, project2_handle **handle);
+
+/**
+* @brief Frees the handle returned by project2_handle_get
+*
+* @param type Type of the test.
+* @param handle Handle to be freed.
+*/
+void project2_handle_put(project2_ds_type type, project2_handle *handle);
+
+/**
+* @brief Gets the handle of type and initializes its context
+*
+* @param type Type of the test to be run.
+* @param size Number of integers to be inserted.
+* @param handle Receives the initialized handle.
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+int project2_handle_open(project2_ds_type type, int size,
+						project2_handle **handle);
+
+/**
+* @brief Deinitializes the context and frees the handle of type
+*
+* @param type Type of the test which was run.
+* @param handle Handle returned by project2_handle_open.
+*/
+void project2_handle_close(project2_ds_type type, project2_handle *handle);
+
+/**
+* @brief Inserts size keys through add_batch in PROJECT2_MAX_BATCH chunks
+*
+* @param handle Handle of the data structure
+* @param keys Keys to be inserted
+* @param size Number of keys
+*
+* @return 0 for success, keys already present are not an error, or
+*		appropriate error code on failure.
+*/
+int project2_handle_fill(project2_handle *handle, const int *keys, int size);
+
+/**
+* @brief Applies one op of a mixed workload to the handle
+*
+* Inserts of a present key succeed. Deletes erase the key where
+* remove_range is offered and pop the oldest/smallest key otherwise.
+*
+* @param handle Handle of the data structure
+* @param op project2_op to be applied
+* @param key Key of the op
+*
+* @return 0 or positive for success, -EOPNOTSUPP if the handle has no
+*		lookup or appropriate error code on failure.
+*/
+int project2_apply_op(project2_handle *handle, int op, int key);
+
+/**
+* @brief Looks up a synchronization by name
+*
+* @param name Name of the synchronization
+*
+* @return project2_sync or -EINVAL if the name is unknown
+*/
+int project2_sync_parse(const char *name);
+
+/**
+* @brief Returns the name of a synchronization
+*
+* @param sync project2_sync
+*
+* @return Name of the synchronization
+*/
+const char *project2_sync_name(int sync);
+
+/**
+* @brief Hammers one shared instance of the selected types from 1 up to
+*		cfg->threads kthreads pinned one per CPU
+*
+* @param cfg Configuration of the run
+* @param params Parameters of the workload
+* @param nr_ops Number of ops shared by the threads of every step
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_concurrent_run(const project2_config *cfg,
+		const project2_workload_params *params, int nr_ops);
+
+/**
+* @brief Scales the lookup threads of one shared instance from 1 up to
+*		cfg->threads - 1 next to a single writer thread
+*
+* @param cfg Configuration of the run
+* @param params Parameters of the workload
+* @param nr_ops Number of lookups of every reader
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_readers_run(const project2_config *cfg,
+		const project2_workload_params *params, int nr_ops);
+
+/**
+* @brief Pushes from 1 up to cfg->threads producer threads into one shared
+*		instance while a single consumer drains it in batches
+*
+* @param cfg Configuration of the run
+* @param params Parameters of the workload
+* @param nr_ops Number of pushes shared by the producers of every step
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_ingest_run(const project2_config *cfg,
+		const project2_workload_params *params, int nr_ops);
+
+/**
+* @brief Fills one shared instance from 1 up to cfg->threads producers and
+*		times a consumer on the first CPU draining it afterwards
+*
+* @param cfg Configuration of the run
+* @param params Parameters of the workload
+* @param nr_ops Number of pushes shared by the producers of every step
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_drain_run(const project2_config *cfg,
+		const project2_workload_params *params, int nr_ops);
+
+/**
+* @brief Looks up a benchmark by name
+*
+* @param name Name of the benchmark
+*
+* @return project2_bench or -EINVAL if the name is unknown
+*/
+int project2_bench_parse(const char *name);
+
+/**
+* @brief Returns the name of a benchmark
+*
+* @param bench project2_bench
+*
+* @return Name of the benchmark
+*/
+const char *project2_bench_name(int bench);
+
+/**
+* @brief Checks the configuration of a run
+*
+* @param cfg Configuration of the run
+*
+* @return 0 if cfg can be run or appropriate error code.
+*/
+int project2_config_check(const project2_config *cfg);
+
+/**
+* @brief Clears all the samples of the histogram
+*
+* @param hist Histogram to be cleared
+*/
+void project2_hist_init(project2_hist *hist);
 
 /**
-* @brief Returns a random integer from 0 to (size/size*4) based on size
+* @brief Records one latency sample in the histogram
 *
-* @param size Seed for defining boundary conditions
+* @param hist Histogram to be updated
+* @param ns Latency of the operation in nanoseconds
+*/
+void project2_hist_add(project2_hist *hist, u64 ns);
+
+/**
+* @brief Returns the latency below which permille of the samples fall
+*
+* @param hist Histogram to be queried
+* @param permille Percentile in tenths of a percent (500 for p50)
+*
+* @return Upper bound of the matching bucket in nanoseconds
+*/
+u64 project2_hist_percentile(const project2_hist *hist, int permille);
+
+/**
+* @brief Adds the samples of src to dst
+*
+* @param dst Histogram receiving the samples
+* @param src Histogram to be merged
+*/
+void project2_hist_merge(project2_hist *dst, const project2_hist *src);
+
+/**
+* @brief Prints the column titles for project2_hist_print
+*/
+void project2_hist_print_header(void);
+
+/**
+* @brief Prints one summary row for the histogram
+*
+* @param type Name of the data structure
+* @param phase Name of the phase which was timed
+* @param hist Per element samples of the phase
+* @param total_ns Wall time of the entire phase
+*/
+void project2_hist_print(const char *type, const char *phase,
+				const project2_hist *hist, u64 total_ns);
+
+/**
+* @brief Starts counting the last level cache misses of the calling thread
+*
+* @param llc Counter to be opened
+*
+* @return 0 for success or appropriate error code if the counter is not
+*		available, project2_llc_read then returns 0.
+*/
+int project2_llc_open(project2_llc *llc);
+
+/**
+* @brief Reads the number of misses counted since project2_llc_open
+*
+* @param llc Counter opened by project2_llc_open
+*
+* @return Number of misses, 0 without a counter
+*/
+u64 project2_llc_read(project2_llc *llc);
+
+/**
+* @brief Releases the counter
+*
+* @param llc Counter opened by project2_llc_open
+*/
+void project2_llc_close(project2_llc *llc);
+
+/**
+* @brief Clears the report of the previous run
+*/
+void project2_report_reset(void);
+
+/**
+* @brief Logs one line of the report and appends it to the report buffer
+*
+* @param fmt printf style format without the log level
+*/
+__printf(1, 2) void project2_report(const char *fmt, ...);
+
+/**
+* @brief Copies the report of the last run to user space
+*
+* @param buf User buffer
+* @param count Size of the user buffer
+* @param ppos Position in the report
+*
+* @return Number of bytes copied or appropriate error code on failure.
+*/
+ssize_t project2_report_read(char __user *buf, size_t count, loff_t *ppos);
+
+/**
+* @brief Looks up a data structure by name, "all" selects every one
+*
+* @param name Name of the data structure
+*
+* @return project2_ds_type, PROJECT2_NR_TYPES for all or -EINVAL
+*/
+int project2_type_parse(const char *name);
+
+/**
+* @brief Returns the name of a data structure
+*
+* @param type project2_ds_type or PROJECT2_NR_TYPES for all of them
+*
+* @return Name of the data structure
+*/
+const char *project2_type_name(int type);
+
+/**
+* @brief Runs the benchmark described by cfg, the report of the run
+*		replaces the previous one.
+*
+* @param cfg Configuration of the run
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_run(const project2_config *cfg);
+
+/**
+* @brief Creates the debugfs control directory
+*
+* @param cfg Initial configuration offered for the runs
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_debugfs_init(const project2_config *cfg);
+
+/**
+* @brief Removes the debugfs control directory
+*/
+void project2_debugfs_exit(void);
+
+/**
+* @brief Starts timing an operation if a histogram is attached
+*
+* @param hist Histogram which will receive the sample, may be NULL
+*
+* @return Start timestamp to be passed to project2_time_end
+*/
+static inline u64 project2_time_start(project2_hist *hist)
+{
+	return hist ? ktime_get_ns() : 0;
+}
+
+/**
+* @brief Records the time elapsed since project2_time_start
 *
-* @return Random Integer
+* @param hist Histogram which receives the sample, may be NULL
+* @param start Timestamp returned by project2_time_start
 */
-int project2_get_next_integer(int size);
+static inline void project2_time_end(project2_hist *hist, u64 start)
+{
+	if (hist)
+		project2_hist_add(hist, ktime_get_ns() - start);
+}
 
 
 /**
 * @brief Executes all list functions in 1 function
 *
+* @param keys Keys to be inserted
 * @param size Number of integers to be inserted
 *
 * @return 0 for success or appropriate error code on failure.
 */
-int project2_list_standalone(int size);
+int project2_list_standalone(const int *keys, int size);
 
 #endif
@@ -0,0 +1,270 @@
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include "project2.h"
+
+/**
+* @brief Allocator used by the pools, one of project2_alloc_mode
+*/
+project2_alloc_mode project2_pool_mode = PROJECT2_ALLOC_KMALLOC;
+
+/**
+* @brief Allocation flags of the per element operations
+*/
+gfp_t project2_gfp = GFP_KERNEL;
+
+/**
+* @brief Id allocation of the id maps, read when they are initialized
+*/
+project2_id_mode project2_id_alloc = PROJECT2_ID_DENSE;
+
+/**
+* @brief Every pool which gets a dedicated kmem_cache
+*/
+static project2_pool *pools[] = {
+	&project2_list_pool,
+	&project2_rbtree_pool,
+	&project2_llist_pool,
+	&project2_ostree_pool,
+	&project2_htable_pool,
+	&project2_ulist_pool
+};
+
+/**
+* @brief Names of the allocators indexed by project2_alloc_mode
+*/
+static const char * const alloc_names[] = {
+	"kmalloc",
+	"slab",
+	"slab_bulk"
+};
+
+/**
+* @brief Creates the dedicated kmem_cache of every pool
+*
+* @return 0 for success or -ENOMEM in failure.
+*/
+int project2_pools_create(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(pools); i++) {
+		// Natural alignment only, so that small nodes are packed back
+		// to back while cache line aligned nodes stay on their line.
+		pools[i]->cache = kmem_cache_create(pools[i]->name,
+					pools[i]->size, pools[i]->align, 0, NULL);
+
+		if (pools[i]->cache == NULL) {
+			printk (KERN_INFO "kmem_cache creation for %s failed\n",
+					pools[i]->name);
+			project2_pools_destroy();
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+/**
+* @brief Destroys the dedicated kmem_cache of every pool
+*/
+void project2_pools_destroy(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(pools); i++) {
+		if (pools[i]->cache) {
+			kmem_cache_destroy(pools[i]->cache);
+			pools[i]->cache = NULL;
+		}
+	}
+}
+
+/**
+* @brief Allocates one node from the pool
+*
+* @param pool Pool to allocate from
+* @param gfp Allocation flags
+*
+* @return Node or NULL on failure
+*/
+void *project2_pool_alloc(project2_pool *pool, gfp_t gfp)
+{
+	if (project2_pool_mode == PROJECT2_ALLOC_KMALLOC)
+		return kmalloc(pool->size, gfp);
+
+	return kmem_cache_alloc(pool->cache, gfp);
+}
+
+/**
+* @brief Returns one node to the pool
+*
+* @param pool Pool the node was allocated from
+* @param obj Node to be freed
+*/
+void project2_pool_free(project2_pool *pool, void *obj)
+{
+	if (project2_pool_mode == PROJECT2_ALLOC_KMALLOC)
+		kfree(obj);
+	else
+		kmem_cache_free(pool->cache, obj);
+}
+
+/**
+* @brief Allocates one node, refilling the batch in bulk if needed
+*
+* @param batch Batch of the pool
+* @param gfp Allocation flags
+*
+* @return Node or NULL on failure
+*/
+void *project2_pool_get(project2_pool_batch *batch, gfp_t gfp)
+{
+	if (project2_pool_mode != PROJECT2_ALLOC_BULK)
+		return project2_pool_alloc(batch->pool, gfp);
+
+	if (!batch->nr) {
+		batch->nr = kmem_cache_alloc_bulk(batch->pool->cache, gfp,
+							PROJECT2_POOL_BATCH, batch->objs);
+		if (!batch->nr)
+			return NULL;
+	}
+
+	return batch->objs[--batch->nr];
+}
+
+/**
+* @brief Frees one node, the free is deferred to a bulk free if needed
+*
+* @param batch Batch of the pool
+* @param obj Node to be freed
+*/
+void project2_pool_put(project2_pool_batch *batch, void *obj)
+{
+	if (project2_pool_mode != PROJECT2_ALLOC_BULK) {
+		project2_pool_free(batch->pool, obj);
+		return;
+	}
+
+	batch->objs[batch->nr++] = obj;
+
+	if (batch->nr == PROJECT2_POOL_BATCH)
+		project2_pool_flush(batch);
+}
+
+/**
+* @brief Frees every node left on the batch
+*
+* @param batch Batch of the pool
+*/
+void project2_pool_flush(project2_pool_batch *batch)
+{
+	if (!batch->nr)
+		return;
+
+	kmem_cache_free_bulk(batch->pool->cache, batch->nr, batch->objs);
+	batch->nr = 0;
+}
+
+/**
+* @brief Times size allocations and frees of the pool through the
+*		same path the data structures use.
+*
+* @param pool Pool to be measured
+* @param objs Scratch array for size nodes
+* @param size Number of nodes to allocate
+* @param alloc_ns Receives the time of all the allocations
+* @param free_ns Receives the time of all the frees
+* @param obj_size Receives the bytes taken by one node
+*
+* @return 0 for success or -ENOMEM in failure.
+*/
+static int __measure_pool(project2_pool *pool, void **objs, int size,
+				u64 *alloc_ns, u64 *free_ns, size_t *obj_size)
+{
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(pool);
+	int ret = 0;
+	int nr;
+	u64 start;
+
+	start = ktime_get_ns();
+	for (nr = 0; nr < size; nr++) {
+		objs[nr] = project2_pool_get(&batch, GFP_KERNEL);
+		if (objs[nr] == NULL) {
+			ret = -ENOMEM;
+			break;
+		}
+	}
+	project2_pool_flush(&batch);
+	*alloc_ns = ktime_get_ns() - start;
+
+	if (nr && project2_pool_mode == PROJECT2_ALLOC_KMALLOC)
+		*obj_size = ksize(objs[0]);
+	else
+		*obj_size = kmem_cache_size(pool->cache);
+
+	start = ktime_get_ns();
+	while (nr--)
+		project2_pool_put(&batch, objs[nr]);
+	project2_pool_flush(&batch);
+	*free_ns = ktime_get_ns() - start;
+
+	return ret;
+}
+
+/**
+* @brief Compares alloc/free cost and footprint of every pool per allocator
+*
+* @param size Number of nodes allocated for the comparison
+*/
+void project2_pools_report(int size)
+{
+	project2_alloc_mode saved_mode = project2_pool_mode;
+	project2_alloc_mode mode;
+	void **objs;
+	size_t obj_size;
+	u64 alloc_ns;
+	u64 free_ns;
+	int i;
+
+	objs = kvmalloc_array(size, sizeof(void *), GFP_KERNEL);
+	if (objs == NULL) {
+		printk (KERN_INFO "memory allocation for pool report failed\n");
+		return;
+	}
+
+	project2_report("##################################\n");
+	project2_report("Allocator summary for %d nodes\n", size);
+	project2_report("%-16s %-10s %8s %8s %10s %12s\n", "POOL", "ALLOC",
+			"NS/ALLOC", "NS/FREE", "BYTES/OBJ", "FOOTPRINT");
+
+	for (i = 0; i < ARRAY_SIZE(pools); i++) {
+		for (mode = PROJECT2_ALLOC_KMALLOC; mode <= PROJECT2_ALLOC_BULK;
+				mode++) {
+			project2_pool_mode = mode;
+
+			if (__measure_pool(pools[i], objs, size, &alloc_ns,
+						&free_ns, &obj_size)) {
+				project2_report("%-16s %-10s failed\n",
+						pools[i]->name, alloc_names[mode]);
+				continue;
+			}
+
+			project2_report("%-16s %-10s %8llu %8llu %10zu %12llu\n",
+					pools[i]->name, alloc_names[mode],
+					div_u64(alloc_ns, size), div_u64(free_ns, size),
+					obj_size, (u64)obj_size * size);
+		}
+	}
+
+	project2_report("##################################\n");
+
+	project2_pool_mode = saved_mode;
+
+	kvfree(objs);
+}
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 node allocators for the data structures\n");
@@ -0,0 +1,1159 @@
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
+#include <linux/jiffies.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/cpumask.h>
+#include <linux/atomic.h>
+#include <linux/mm.h>
+#include "project2.h"
+
+/**
+* @brief Number of ops the writer of the reader scaling test cycles through
+*/
+#define PROJECT2_WRITER_OPS 4096
+
+/**
+* @brief Number of elements the consumer of the ingest test drains per call
+*/
+#define PROJECT2_DRAIN_BATCH 256
+
+/**
+* @brief Names of the synchronizations indexed by project2_sync
+*/
+static const char * const sync_names[] = {
+	"none",
+	"spin",
+	"rwlock",
+	"mutex"
+};
+
+/**
+* @brief Handle shared by the threads of one step of the sweep
+*/
+typedef struct project2_shared_t {
+	project2_handle *handle; /*Handle hammered by every thread */
+	project2_sync sync; /*Synchronization wrapped around its ops */
+	spinlock_t spin; /*Lock of PROJECT2_SYNC_SPIN */
+	rwlock_t rw; /*Lock of PROJECT2_SYNC_RWLOCK */
+	struct mutex mutex; /*Lock of PROJECT2_SYNC_MUTEX */
+	struct completion start; /*Releases all the threads at once */
+	atomic_t running; /*Threads which have not finished their ops */
+	struct completion done; /*Completed once running drops to 0 */
+	atomic_t alive; /*Threads which have not finished their body */
+	struct completion exited; /*Completed once alive drops to 0 */
+	bool abort; /*Set if the step is torn down before it started */
+} project2_shared;
+
+/**
+* @brief One thread of the sweep and its results
+*/
+typedef struct project2_worker_t {
+	struct task_struct *task; /*kthread of the worker */
+	project2_shared *shared; /*Handle and locks shared by the workers */
+	const int *keys; /*Keys of the ops of this worker */
+	const u8 *ops; /*project2_op of every key */
+	int nr; /*Number of ops of this worker */
+	bool loop; /*Cycles through the ops until the other threads are done */
+	bool consumer; /*Drains the handle instead of applying ops */
+	bool after; /*Starts once the other threads are done */
+	int cpu; /*CPU the worker is bound to, -1 for the next online one */
+	int done; /*Number of ops which were applied */
+	int ret; /*First error of the ops */
+	u64 start_ns; /*Time the first op started */
+	u64 end_ns; /*Time the last op ended */
+	project2_hist hist; /*Per op latency, lock wait included */
+} project2_worker;
+
+/**
+* @brief Aggregated results of a range of workers
+*/
+typedef struct project2_step_t {
+	project2_hist total; /*Latency of the ops of all the workers */
+	u64 ops; /*Number of ops which were applied */
+	u64 elapsed_ns; /*Time from the first start to the last end */
+	u64 worst_p99; /*Largest p99 of a single worker */
+} project2_step;
+
+/**
+* @brief Looks up a synchronization by name
+*
+* @param name Name of the synchronization
+*
+* @return project2_sync or -EINVAL if the name is unknown
+*/
+int project2_sync_parse(const char *name)
+{
+	int sync;
+
+	for (sync = 0; sync < PROJECT2_NR_SYNCS; sync++)
+		if (sysfs_streq(name, sync_names[sync]))
+			return sync;
+
+	return -EINVAL;
+}
+
+/**
+* @brief Returns the name of a synchronization
+*
+* @param sync project2_sync
+*
+* @return Name of the synchronization
+*/
+const char *project2_sync_name(int sync)
+{
+	if (sync < 0 || sync >= PROJECT2_NR_SYNCS)
+		return "invalid";
+
+	return sync_names[sync];
+}
+
+/**
+* @brief Takes the synchronization of the shared handle
+*
+* @param shared Handle and locks shared by the workers
+* @param read Set if the op only reads the context
+*/
+static void __lock(project2_shared *shared, bool read)
+{
+	switch (shared->sync) {
+	case PROJECT2_SYNC_SPIN:
+		spin_lock(&shared->spin);
+		break;
+
+	case PROJECT2_SYNC_RWLOCK:
+		if (read)
+			read_lock(&shared->rw);
+		else
+			write_lock(&shared->rw);
+		break;
+
+	case PROJECT2_SYNC_MUTEX:
+		mutex_lock(&shared->mutex);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/**
+* @brief Releases the synchronization taken by __lock
+*
+* @param shared Handle and locks shared by the workers
+* @param read Value passed to __lock
+*/
+static void __unlock(project2_shared *shared, bool read)
+{
+	switch (shared->sync) {
+	case PROJECT2_SYNC_SPIN:
+		spin_unlock(&shared->spin);
+		break;
+
+	case PROJECT2_SYNC_RWLOCK:
+		if (read)
+			read_unlock(&shared->rw);
+		else
+			write_unlock(&shared->rw);
+		break;
+
+	case PROJECT2_SYNC_MUTEX:
+		mutex_unlock(&shared->mutex);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/**
+* @brief Applies one op under the synchronization of the shared handle
+*
+* Lookups take the read side of the rwlock unless the handle modifies
+* its context on lookup.
+*
+* @param shared Handle and locks shared by the workers
+* @param op project2_op to be applied
+* @param key Key of the op
+*
+* @return Return value of project2_apply_op
+*/
+static int __locked_op(project2_shared *shared, int op, int key)
+{
+	project2_handle *handle = shared->handle;
+	bool read = op == PROJECT2_OP_LOOKUP &&
+			!(handle->flags & PROJECT2_HANDLE_LOOKUP_WRITES);
+	int ret;
+
+	__lock(shared, read);
+	ret = project2_apply_op(handle, op, key);
+	__unlock(shared, read);
+
+	return ret;
+}
+
+/**
+* @brief Applies the ops of the worker
+*
+* @param worker Worker of the calling thread
+*/
+static void __apply_ops(project2_worker *worker)
+{
+	project2_shared *shared = worker->shared;
+	unsigned long n;
+	u64 start;
+	int ret;
+	int i;
+
+	for (n = 0; !READ_ONCE(shared->abort); n++) {
+		if (worker->loop ? !atomic_read(&shared->running) : n == worker->nr)
+			break;
+
+		// Outside of the lock so that the spinlock modes may yield.
+		if (project2_yield(n)) {
+			worker->ret = -EINTR;
+			break;
+		}
+
+		i = n % worker->nr;
+
+		start = ktime_get_ns();
+
+		ret = __locked_op(shared, worker->ops[i], worker->keys[i]);
+
+		// Lookups of a handle without lookup are skipped.
+		if (ret == -EOPNOTSUPP)
+			continue;
+
+		project2_hist_add(&worker->hist, ktime_get_ns() - start);
+
+		if (ret < 0) {
+			worker->ret = ret;
+			break;
+		}
+
+		worker->done++;
+	}
+}
+
+/**
+* @brief Drains the shared handle in batches until it is found empty
+*		after all the other threads have exited
+*
+* done counts the drained elements, the histogram has one sample per
+* non-empty batch.
+*
+* @param worker Worker of the calling thread
+*/
+static void __drain(project2_worker *worker)
+{
+	project2_shared *shared = worker->shared;
+	project2_handle *handle = shared->handle;
+	unsigned long n;
+	bool idle;
+	int *keys;
+	u64 start;
+	int ret;
+
+	keys = kmalloc_array(PROJECT2_DRAIN_BATCH, sizeof(int), GFP_KERNEL);
+	if (keys == NULL) {
+		worker->ret = -ENOMEM;
+		return;
+	}
+
+	for (n = 0; !READ_ONCE(shared->abort); n++) {
+		// Read first, so an empty batch afterwards really is the end.
+		// done is completed once every producer has exited, or when
+		// the step gave up starting them.
+		idle = completion_done(&shared->done);
+
+		if (project2_yield(n)) {
+			worker->ret = -EINTR;
+			break;
+		}
+
+		start = ktime_get_ns();
+
+		__lock(shared, false);
+		ret = handle->remove_batch(handle->context, keys,
+						PROJECT2_DRAIN_BATCH);
+		__unlock(shared, false);
+
+		if (ret < 0) {
+			worker->ret = ret;
+			break;
+		}
+
+		if (ret == 0 && idle)
+			break;
+
+		if (ret)
+			project2_hist_add(&worker->hist, ktime_get_ns() - start);
+
+		worker->done += ret;
+	}
+
+	kfree(keys);
+}
+
+/**
+* @brief Waits for the other threads to finish their ops, polling so that
+*		a torn down step or a cancelled run does not leave it stuck
+*
+* @param shared Handle and locks shared by the workers
+*
+* @return true once the other threads are done, false if it gave up
+*/
+static bool __wait_done(project2_shared *shared)
+{
+	while (!wait_for_completion_timeout(&shared->done, HZ / 10))
+		if (READ_ONCE(shared->abort) || READ_ONCE(project2_stop))
+			return false;
+
+	return true;
+}
+
+/**
+* @brief Body of the worker kthreads
+*
+* @param data project2_worker of the thread
+*
+* @return 0, the results are left in the worker
+*/
+static int __worker(void *data)
+{
+	project2_worker *worker = data;
+	project2_shared *shared = worker->shared;
+
+	wait_for_completion(&shared->start);
+
+	// Only the work of the worker itself is timed.
+	if (worker->after && !__wait_done(shared)) {
+		worker->ret = -EINTR;
+	} else {
+		worker->start_ns = ktime_get_ns();
+
+		if (worker->consumer)
+			__drain(worker);
+		else
+			__apply_ops(worker);
+
+		worker->end_ns = ktime_get_ns();
+	}
+
+	if (!worker->loop && atomic_dec_and_test(&shared->running))
+		complete_all(&shared->done);
+
+	// Loop workers signal as well, the step waits for every one of them.
+	if (atomic_dec_and_test(&shared->alive))
+		complete_all(&shared->exited);
+
+	// kthread_stop() reaps the thread, it must not exit before that.
+	set_current_state(TASK_INTERRUPTIBLE);
+	while (!kthread_should_stop()) {
+		schedule();
+		set_current_state(TASK_INTERRUPTIBLE);
+	}
+	__set_current_state(TASK_RUNNING);
+
+	return 0;
+}
+
+/**
+* @brief Shares nr ops out between nr_threads workers, their slices differ
+*		by at most one op
+*
+* @param workers Array of at least nr_threads workers
+* @param nr_threads Number of workers
+* @param keys Keys of the ops
+* @param ops project2_op of every key
+* @param nr Number of ops
+*/
+static void __share_out(project2_worker *workers, int nr_threads,
+				const int *keys, const u8 *ops, int nr)
+{
+	int slice = nr / nr_threads;
+	int extra = nr % nr_threads;
+	int first = 0;
+	int i;
+
+	// The first nr % nr_threads workers take one op of the remainder
+	// each, so every op runs whatever the thread count.
+	for (i = 0; i < nr_threads; i++) {
+		workers[i].keys = keys + first;
+		workers[i].ops = ops + first;
+		workers[i].nr = slice + (i < extra);
+		first += workers[i].nr;
+		workers[i].loop = false;
+		workers[i].consumer = false;
+		workers[i].after = false;
+		workers[i].cpu = -1;
+	}
+}
+
+/**
+* @brief Runs one step of the sweep with nr_threads workers on the
+*		first nr_threads online CPUs, wrapping around if there are more
+*		workers than CPUs
+*
+* The ops of every worker are set up by the caller, the results are left
+* in the workers. A worker with cpu set is bound to that CPU instead.
+*
+* @param type Type of the test to be run.
+* @param sync Synchronization wrapped around the shared handle
+* @param prefill Keys inserted before the ops
+* @param size Number of prefilled keys
+* @param capacity Number of elements the handle is sized for
+* @param workers Array of at least nr_threads workers
+* @param nr_threads Number of workers
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int __run_step(project2_ds_type type, project2_sync sync,
+			const int *prefill, int size, int capacity,
+			project2_worker *workers, int nr_threads)
+{
+	project2_shared shared;
+	int started = 0;
+	int ret;
+	int err;
+	int cpu;
+	int i;
+
+	ret = project2_handle_open(type, capacity, &shared.handle);
+	if (ret)
+		return ret;
+
+	// The prefill runs unlocked in process context.
+	ret = project2_handle_fill(shared.handle, prefill, size);
+	if (ret)
+		goto out;
+
+	// Nothing may sleep while the spinning locks are held, only the ops
+	// of the workers run under them.
+	if (sync == PROJECT2_SYNC_SPIN || sync == PROJECT2_SYNC_RWLOCK)
+		project2_gfp = GFP_ATOMIC;
+
+	shared.sync = sync;
+	shared.abort = false;
+	spin_lock_init(&shared.spin);
+	rwlock_init(&shared.rw);
+	mutex_init(&shared.mutex);
+	init_completion(&shared.start);
+	init_completion(&shared.done);
+	atomic_set(&shared.running, 0);
+	init_completion(&shared.exited);
+	atomic_set(&shared.alive, 0);
+
+	cpu = -1;
+
+	for (i = 0; i < nr_threads; i++) {
+		workers[i].shared = &shared;
+		workers[i].done = 0;
+		workers[i].ret = 0;
+		workers[i].start_ns = 0;
+		workers[i].end_ns = 0;
+		project2_hist_init(&workers[i].hist);
+
+		cpu = cpumask_next(cpu, cpu_online_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_online_mask);
+
+		workers[i].task = kthread_create(__worker, &workers[i],
+							"project2_w%d", i);
+		if (IS_ERR(workers[i].task)) {
+			ret = PTR_ERR(workers[i].task);
+			shared.abort = true;
+			break;
+		}
+
+		if (!workers[i].loop)
+			atomic_inc(&shared.running);
+
+		atomic_inc(&shared.alive);
+
+		kthread_bind(workers[i].task,
+				workers[i].cpu >= 0 ? workers[i].cpu : cpu);
+		wake_up_process(workers[i].task);
+		started++;
+	}
+
+	// Nobody is left to release the workers waiting for the others.
+	if (shared.abort)
+		complete_all(&shared.done);
+
+	complete_all(&shared.start);
+
+	// kthread_stop() skips the body of a thread which has not run yet,
+	// so every worker has to be done with it before the threads are
+	// stopped. The first worker may share the CPU of the caller.
+	if (started)
+		wait_for_completion(&shared.exited);
+
+	for (i = 0; i < started; i++) {
+		err = kthread_stop(workers[i].task);
+		if (err && !ret)
+			ret = err;
+	}
+
+	project2_gfp = GFP_KERNEL;
+
+out:
+	shared.handle->remove(shared.handle->context, NULL);
+	project2_handle_close(type, shared.handle);
+
+	return ret;
+}
+
+/**
+* @brief Aggregates the results of workers [from, to)
+*
+* @param workers Workers of the step
+* @param from First worker
+* @param to Last worker (EXCLUSIVE)
+* @param step Receives the aggregated results
+*
+* @return 0 or the first error of the workers
+*/
+static int __collect(const project2_worker *workers, int from, int to,
+						project2_step *step)
+{
+	u64 first_ns = U64_MAX;
+	u64 last_ns = 0;
+	int ret = 0;
+	int i;
+
+	memset(step, 0, sizeof(project2_step));
+	project2_hist_init(&step->total);
+
+	for (i = from; i < to; i++) {
+		if (workers[i].ret && !ret)
+			ret = workers[i].ret;
+
+		step->ops += workers[i].done;
+
+		// A worker which never started has no span to add.
+		if (workers[i].start_ns) {
+			first_ns = min(first_ns, workers[i].start_ns);
+			last_ns = max(last_ns, workers[i].end_ns);
+		}
+
+		step->worst_p99 = max(step->worst_p99,
+				project2_hist_percentile(&workers[i].hist, 990));
+		project2_hist_merge(&step->total, &workers[i].hist);
+	}
+
+	step->elapsed_ns = last_ns > first_ns ? last_ns - first_ns : 0;
+
+	return ret;
+}
+
+/**
+* @brief Returns the throughput of a step in thousands of ops per second
+*
+* @param step Aggregated results
+*
+* @return Kops/s
+*/
+static u64 __kops(const project2_step *step)
+{
+	return step->elapsed_ns ?
+		div64_u64(step->ops * USEC_PER_SEC, step->elapsed_ns) : 0;
+}
+
+/**
+* @brief Checks whether type can be shared by the threads under sync
+*
+* @param type Type of the test
+* @param sync Synchronization wrapped around the handle
+* @param lookup Set if the lookups of the handle are needed as well
+* @param safe PROJECT2_HANDLE_* flags which make the type safe without
+*		synchronization
+*
+* @return true if the type offers the ops and is safe under sync
+*/
+static bool __shareable(project2_ds_type type, project2_sync sync, bool lookup,
+						unsigned int safe)
+{
+	project2_handle *handle = NULL;
+	bool shareable;
+
+	if (project2_handle_get(type, &handle))
+		return false;
+
+	shareable = handle->add_batch && handle->remove_batch &&
+			(handle->lookup || !lookup) &&
+			(sync != PROJECT2_SYNC_NONE ||
+			(handle->flags & safe));
+
+	project2_handle_put(type, handle);
+
+	return shareable;
+}
+
+/**
+* @brief Picks the synchronization type is shared under
+*
+* Types which are safe on their own run without a lock, the others under
+* sync.
+*
+* @param type Type of the test
+* @param sync Synchronization selected for the run
+* @param lookup Set if the lookups of the handle are needed as well
+* @param safe PROJECT2_HANDLE_* flags which make the type safe without
+*		synchronization
+*
+* @return project2_sync or -EOPNOTSUPP if type can not be shared
+*/
+static int __pick_sync(project2_ds_type type, project2_sync sync, bool lookup,
+						unsigned int safe)
+{
+	if (__shareable(type, PROJECT2_SYNC_NONE, lookup, safe))
+		sync = PROJECT2_SYNC_NONE;
+	else if (!__shareable(type, sync, lookup, safe))
+		return -EOPNOTSUPP;
+
+	return sync;
+}
+
+/**
+* @brief Generates the keys inserted before the ops, distinct keys from
+*		the range of the workload
+*
+* @param prefill Workload receiving the keys
+* @param params Parameters of the workload
+* @param seed Seed of the workload
+* @param size Number of keys
+* @param range Upper bound (EXCLUSIVE) of the keys
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int __generate_prefill(project2_workload *prefill,
+		const project2_workload_params *params, u64 seed, int size,
+		int range)
+{
+	project2_workload_params prefill_params = *params;
+
+	// The prefill only inserts, with distinct keys from the same range.
+	prefill_params.dist = PROJECT2_DIST_UNIQUE;
+	prefill_params.op_pct[PROJECT2_OP_INSERT] = 100;
+	prefill_params.op_pct[PROJECT2_OP_LOOKUP] = 0;
+	prefill_params.op_pct[PROJECT2_OP_DELETE] = 0;
+	prefill_params.seed = seed + 1;
+
+	return project2_workload_generate(prefill, &prefill_params, size, range);
+}
+
+/**
+* @brief Hammers one shared instance of the selected types from 1 up to
+*		cfg->threads kthreads pinned one per CPU
+*
+* Thread safe types run without a lock, the others under cfg->sync, so
+* the lock-free types are compared against the locked ones.
+*
+* @param cfg Configuration of the run
+* @param params Parameters of the workload
+* @param nr_ops Number of ops shared by the threads of every step
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_concurrent_run(const project2_config *cfg,
+		const project2_workload_params *params, int nr_ops)
+{
+	project2_workload prefill = { 0 };
+	project2_workload wl = { 0 };
+	project2_worker *workers;
+	project2_ds_type type;
+	project2_step step;
+	int range = project2_key_range(cfg->size);
+	int nr_threads;
+	int sync;
+	int ret;
+
+	if (cfg->threads > num_online_cpus())
+		return -EINVAL;
+
+	workers = kcalloc(cfg->threads, sizeof(project2_worker), GFP_KERNEL);
+	if (workers == NULL)
+		return -ENOMEM;
+
+	ret = project2_workload_generate(&wl, params, nr_ops, range);
+	if (ret)
+		goto out;
+
+	ret = __generate_prefill(&prefill, params, wl.seed, cfg->size, range);
+	if (ret)
+		goto out;
+
+	project2_report("##################################\n");
+	project2_report("Concurrency summary for %d prefilled integers, latency in ns\n",
+			cfg->size);
+	project2_workload_print(&wl, params);
+	project2_report("%-10s %-6s %7s %10s %10s %8s %8s %8s %9s %10s\n", "DS",
+			"SYNC", "THREADS", "OPS", "KOPS/S", "NS/OP", "P50", "P99",
+			"WORST P99", "MAX");
+
+	for (type = PROJECT2_LIST; type < PROJECT2_NR_TYPES; type++) {
+		if (READ_ONCE(project2_stop))
+			break;
+
+		if (cfg->type != PROJECT2_NR_TYPES && cfg->type != type)
+			continue;
+
+		sync = __pick_sync(type, cfg->sync, false,
+					PROJECT2_HANDLE_THREAD_SAFE);
+		if (sync < 0)
+			continue;
+
+		// Doubles the threads and ends with exactly cfg->threads.
+		for (nr_threads = 1; ; nr_threads = min(nr_threads * 2, cfg->threads)) {
+			__share_out(workers, nr_threads, wl.keys, wl.ops, wl.nr);
+
+			ret = __run_step(type, sync, prefill.keys, cfg->size,
+						cfg->size + wl.nr, workers, nr_threads);
+			if (!ret)
+				ret = __collect(workers, 0, nr_threads, &step);
+
+			if (ret) {
+				project2_report("%s with %d threads failed %d\n",
+						project2_type_name(type), nr_threads, ret);
+				break;
+			}
+
+			project2_report("%-10s %-6s %7d %10llu %10llu %8llu %8llu %8llu %9llu %10llu\n",
+					project2_type_name(type),
+					project2_sync_name(sync), nr_threads, step.ops,
+					__kops(&step),
+					step.total.count ?
+					div64_u64(step.total.sum_ns, step.total.count) : 0,
+					project2_hist_percentile(&step.total, 500),
+					project2_hist_percentile(&step.total, 990),
+					step.worst_p99, step.total.max_ns);
+
+			if (nr_threads == cfg->threads)
+				break;
+		}
+	}
+
+	project2_report("##################################\n");
+
+	ret = 0;
+
+out:
+	project2_workload_free(&prefill);
+	project2_workload_free(&wl);
+	kfree(workers);
+
+	return ret;
+}
+
+/**
+* @brief Scales the lookup threads of one shared instance from 1 up to
+*		cfg->threads - 1 next to a single writer thread
+*
+* The writer cycles through inserts and deletes until the readers are done.
+* Thread safe types run without a lock, the others under cfg->sync, so
+* the RCU list is compared against the locked list and the latched rbtree
+* against the rbtree under PROJECT2_SYNC_RWLOCK.
+*
+* @param cfg Configuration of the run
+* @param params Parameters of the workload
+* @param nr_ops Number of lookups shared by the readers of every step
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_readers_run(const project2_config *cfg,
+		const project2_workload_params *params, int nr_ops)
+{
+	project2_workload_params write_params = *params;
+	project2_workload prefill = { 0 };
+	project2_workload writes = { 0 };
+	project2_workload wl = { 0 };
+	project2_worker *workers;
+	project2_ds_type type;
+	project2_step readers;
+	project2_step writer;
+	int sync;
+	int range = project2_key_range(cfg->size);
+	int nr_readers;
+	int ret;
+	int i;
+
+	if (cfg->threads < 2 || cfg->threads > num_online_cpus())
+		return -EINVAL;
+
+	workers = kcalloc(cfg->threads, sizeof(project2_worker), GFP_KERNEL);
+	if (workers == NULL)
+		return -ENOMEM;
+
+	ret = project2_workload_generate(&wl, params, nr_ops, range);
+	if (ret)
+		goto out;
+
+	ret = __generate_prefill(&prefill, params, wl.seed, cfg->size, range);
+	if (ret)
+		goto out;
+
+	write_params.seed = wl.seed + 2;
+
+	ret = project2_workload_generate(&writes, &write_params,
+						PROJECT2_WRITER_OPS, range);
+	if (ret)
+		goto out;
+
+	// Readers only look up, the writer keeps the size steady.
+	memset(wl.ops, PROJECT2_OP_LOOKUP, wl.nr);
+
+	for (i = 0; i < writes.nr; i++)
+		writes.ops[i] = i & 1 ? PROJECT2_OP_DELETE : PROJECT2_OP_INSERT;
+
+	project2_report("##################################\n");
+	project2_report("Reader scaling for %d prefilled integers with one writer, latency in ns\n",
+			cfg->size);
+	project2_workload_print(&wl, params);
+	project2_report("%-10s %-6s %7s %10s %10s %8s %8s %8s %9s %10s\n", "DS",
+			"SYNC", "READERS", "LOOKUPS", "KOPS/S", "NS/OP", "P50",
+			"P99", "WORST P99", "W KOPS/S");
+
+	for (type = PROJECT2_LIST; type < PROJECT2_NR_TYPES; type++) {
+		if (READ_ONCE(project2_stop))
+			break;
+
+		if (cfg->type != PROJECT2_NR_TYPES && cfg->type != type)
+			continue;
+
+		sync = __pick_sync(type, cfg->sync, true,
+					PROJECT2_HANDLE_THREAD_SAFE);
+		if (sync < 0)
+			continue;
+
+		// Doubles the readers and ends with exactly cfg->threads - 1.
+		for (nr_readers = 1; ;
+				nr_readers = min(nr_readers * 2, cfg->threads - 1)) {
+			workers[0].keys = writes.keys;
+			workers[0].ops = writes.ops;
+			workers[0].nr = writes.nr;
+			workers[0].loop = true;
+			workers[0].consumer = false;
+			workers[0].after = false;
+			workers[0].cpu = -1;
+
+			__share_out(workers + 1, nr_readers, wl.keys, wl.ops, wl.nr);
+
+			ret = __run_step(type, sync, prefill.keys, cfg->size,
+					cfg->size + writes.nr, workers, nr_readers + 1);
+			if (!ret)
+				ret = __collect(workers, 1, nr_readers + 1, &readers);
+			if (!ret)
+				ret = __collect(workers, 0, 1, &writer);
+
+			if (ret) {
+				project2_report("%s with %d readers failed %d\n",
+						project2_type_name(type), nr_readers, ret);
+				break;
+			}
+
+			project2_report("%-10s %-6s %7d %10llu %10llu %8llu %8llu %8llu %9llu %10llu\n",
+					project2_type_name(type),
+					project2_sync_name(sync), nr_readers,
+					readers.ops, __kops(&readers),
+					readers.total.count ?
+					div64_u64(readers.total.sum_ns,
+						readers.total.count) : 0,
+					project2_hist_percentile(&readers.total, 500),
+					project2_hist_percentile(&readers.total, 990),
+					readers.worst_p99, __kops(&writer));
+
+			if (nr_readers == cfg->threads - 1)
+				break;
+		}
+	}
+
+	project2_report("##################################\n");
+
+	ret = 0;
+
+out:
+	project2_workload_free(&writes);
+	project2_workload_free(&prefill);
+	project2_workload_free(&wl);
+	kfree(workers);
+
+	return ret;
+}
+
+/**
+* @brief Pushes from 1 up to cfg->threads producer threads into one shared
+*		instance while a single consumer drains it in batches
+*
+* Types which take concurrent producers run without a lock, the others
+* under cfg->sync, so the llist is compared against the locked list. The
+* consumer is an extra thread sharing the first CPU once every CPU runs a
+* producer.
+*
+* @param cfg Configuration of the run
+* @param params Parameters of the workload
+* @param nr_ops Number of pushes shared by the producers of every step
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_ingest_run(const project2_config *cfg,
+		const project2_workload_params *params, int nr_ops)
+{
+	project2_workload wl = { 0 };
+	project2_worker *workers;
+	project2_worker *consumer;
+	project2_ds_type type;
+	project2_step producers;
+	project2_step drained;
+	int sync;
+	unsigned int safe = PROJECT2_HANDLE_THREAD_SAFE |
+				PROJECT2_HANDLE_MULTI_PRODUCER;
+	int nr_producers;
+	int ret;
+
+	if (cfg->threads > num_online_cpus())
+		return -EINVAL;
+
+	workers = kcalloc(cfg->threads + 1, sizeof(project2_worker), GFP_KERNEL);
+	if (workers == NULL)
+		return -ENOMEM;
+
+	ret = project2_workload_generate(&wl, params, nr_ops,
+					project2_key_range(nr_ops));
+	if (ret)
+		goto out;
+
+	// Producers only push, the structures start out empty.
+	memset(wl.ops, PROJECT2_OP_INSERT, wl.nr);
+
+	project2_report("##################################\n");
+	project2_report("Ingest of %d integers with one consumer draining %d at a time, latency in ns\n",
+			wl.nr, PROJECT2_DRAIN_BATCH);
+	project2_workload_print(&wl, params);
+	project2_report("%-10s %-6s %9s %10s %10s %8s %8s %8s %9s %10s\n", "DS",
+			"SYNC", "PRODUCERS", "PUSHES", "KOPS/S", "NS/OP", "P50",
+			"P99", "WORST P99", "D KOPS/S");
+
+	for (type = PROJECT2_LIST; type < PROJECT2_NR_TYPES; type++) {
+		if (READ_ONCE(project2_stop))
+			break;
+
+		if (cfg->type != PROJECT2_NR_TYPES && cfg->type != type)
+			continue;
+
+		sync = __pick_sync(type, cfg->sync, false, safe);
+		if (sync < 0)
+			continue;
+
+		// Doubles the producers and ends with exactly cfg->threads.
+		for (nr_producers = 1; ;
+				nr_producers = min(nr_producers * 2, cfg->threads)) {
+			__share_out(workers, nr_producers, wl.keys, wl.ops, wl.nr);
+
+			consumer = &workers[nr_producers];
+			consumer->nr = 0;
+			consumer->loop = true;
+			consumer->consumer = true;
+			consumer->after = false;
+			consumer->cpu = -1;
+
+			ret = __run_step(type, sync, NULL, 0, wl.nr, workers,
+							nr_producers + 1);
+			if (!ret)
+				ret = __collect(workers, 0, nr_producers, &producers);
+			if (!ret)
+				ret = __collect(workers, nr_producers,
+						nr_producers + 1, &drained);
+
+			if (ret) {
+				project2_report("%s with %d producers failed %d\n",
+						project2_type_name(type), nr_producers, ret);
+				break;
+			}
+
+			project2_report("%-10s %-6s %9d %10llu %10llu %8llu %8llu %8llu %9llu %10llu\n",
+					project2_type_name(type),
+					project2_sync_name(sync), nr_producers,
+					producers.ops, __kops(&producers),
+					producers.total.count ?
+					div64_u64(producers.total.sum_ns,
+						producers.total.count) : 0,
+					project2_hist_percentile(&producers.total, 500),
+					project2_hist_percentile(&producers.total, 990),
+					producers.worst_p99, __kops(&drained));
+
+			if (nr_producers == cfg->threads)
+				break;
+		}
+	}
+
+	project2_report("##################################\n");
+
+	ret = 0;
+
+out:
+	project2_workload_free(&wl);
+	kfree(workers);
+
+	return ret;
+}
+
+/**
+* @brief Fills a fresh instance from nr_producers producers, then times
+*		the consumer draining it on consumer_cpu
+*
+* @param type Type of the test to be run.
+* @param sync Synchronization wrapped around the shared handle
+* @param wl Pushes shared out between the producers
+* @param workers Array of at least nr_producers + 1 workers
+* @param nr_producers Number of producers
+* @param producer_cpu CPU of a single producer, -1 for the first CPUs
+* @param consumer_cpu CPU of the consumer
+* @param push Receives the results of the producers
+* @param drain Receives the results of the consumer
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int __drain_step(project2_ds_type type, project2_sync sync,
+		const project2_workload *wl, project2_worker *workers,
+		int nr_producers, int producer_cpu, int consumer_cpu,
+		project2_step *push, project2_step *drain)
+{
+	project2_worker *consumer = &workers[nr_producers];
+	int ret;
+
+	__share_out(workers, nr_producers, wl->keys, wl->ops, wl->nr);
+
+	workers[0].cpu = producer_cpu;
+
+	consumer->nr = 0;
+	consumer->loop = true;
+	consumer->consumer = true;
+	consumer->after = true;
+	consumer->cpu = consumer_cpu;
+
+	ret = __run_step(type, sync, NULL, 0, wl->nr, workers, nr_producers + 1);
+	if (!ret)
+		ret = __collect(workers, 0, nr_producers, push);
+	if (!ret)
+		ret = __collect(workers, nr_producers, nr_producers + 1, drain);
+
+	return ret;
+}
+
+/**
+* @brief Fills one shared instance from 1 up to cfg->threads producers and
+*		times a consumer on the first CPU draining it afterwards
+*
+* The first row fills from the consumer's CPU and the second one from
+* another CPU, the difference in ns per drained element is the cost of
+* pulling the elements across CPUs. The sweep after them spreads the fill
+* over more and more CPUs. Types which take concurrent producers run
+* without a lock, the others under cfg->sync.
+*
+* @param cfg Configuration of the run
+* @param params Parameters of the workload
+* @param nr_ops Number of pushes shared by the producers of every step
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_drain_run(const project2_config *cfg,
+		const project2_workload_params *params, int nr_ops)
+{
+	project2_workload wl = { 0 };
+	project2_worker *workers;
+	project2_ds_type type;
+	project2_step push;
+	project2_step drain;
+	int sync;
+	unsigned int safe = PROJECT2_HANDLE_THREAD_SAFE |
+				PROJECT2_HANDLE_MULTI_PRODUCER;
+	int first = cpumask_first(cpu_online_mask);
+	int producer_cpu;
+	int nr_producers;
+	int row;
+	int ret;
+
+	if (cfg->threads > num_online_cpus())
+		return -EINVAL;
+
+	workers = kcalloc(cfg->threads + 1, sizeof(project2_worker), GFP_KERNEL);
+	if (workers == NULL)
+		return -ENOMEM;
+
+	ret = project2_workload_generate(&wl, params, nr_ops,
+					project2_key_range(nr_ops));
+	if (ret)
+		goto out;
+
+	memset(wl.ops, PROJECT2_OP_INSERT, wl.nr);
+
+	project2_report("##################################\n");
+	project2_report("Drain of %d integers on CPU %d after the fill, %d at a time\n",
+			wl.nr, first, PROJECT2_DRAIN_BATCH);
+	project2_workload_print(&wl, params);
+	project2_report("%-10s %-6s %9s %6s %12s %12s %8s %10s\n", "DS", "SYNC",
+			"PRODUCERS", "LOCAL%", "PUSH KOPS/S", "DRAIN KOPS/S",
+			"NS/EL", "BATCH P99");
+
+	for (type = PROJECT2_LIST; type < PROJECT2_NR_TYPES; type++) {
+		if (READ_ONCE(project2_stop))
+			break;
+
+		if (cfg->type != PROJECT2_NR_TYPES && cfg->type != type)
+			continue;
+
+		sync = __pick_sync(type, cfg->sync, false, safe);
+		if (sync < 0)
+			continue;
+
+		// Row 0 fills locally, row 1 remotely, then 2, 4.. producers.
+		for (row = 0; ; row++) {
+			nr_producers = row < 2 ? 1 : min(1 << (row - 1), cfg->threads);
+			producer_cpu = row == 0 ? first : row == 1 ?
+				cpumask_next(first, cpu_online_mask) : -1;
+
+			// A single CPU has nothing remote to compare with.
+			if (producer_cpu >= (int)nr_cpu_ids)
+				break;
+
+			ret = __drain_step(type, sync, &wl, workers, nr_producers,
+					producer_cpu, first, &push, &drain);
+			if (ret) {
+				project2_report("%s with %d producers failed %d\n",
+						project2_type_name(type), nr_producers, ret);
+				break;
+			}
+
+			project2_report("%-10s %-6s %9d %6d %12llu %12llu %8llu %10llu\n",
+					project2_type_name(type),
+					project2_sync_name(sync), nr_producers,
+					row == 1 ? 0 : 100 / nr_producers,
+					__kops(&push), __kops(&drain),
+					drain.ops ?
+					div64_u64(drain.elapsed_ns, drain.ops) : 0,
+					project2_hist_percentile(&drain.total, 990));
+
+			if (row >= 1 && nr_producers == cfg->threads)
+				break;
+		}
+	}
+
+	project2_report("##################################\n");
+
+	ret = 0;
+
+out:
+	project2_workload_free(&wl);
+	kfree(workers);
+
+	return ret;
+}
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 multi-threaded contention benchmark\n");
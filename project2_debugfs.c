@@ -0,0 +1,405 @@
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/debugfs.h>
+#include <linux/uaccess.h>
+#include <linux/mutex.h>
+#include <linux/cpumask.h>
+#include "project2.h"
+
+/**
+* @brief Longest name accepted by the type, dist, sync and bench files
+*/
+#define PROJECT2_NAME_LEN 32
+
+/**
+* @brief Control directory, /sys/kernel/debug/project2
+*/
+static struct dentry *project2_dir;
+
+/**
+* @brief Configuration of the next run, protected by run_lock
+*/
+static project2_config debugfs_cfg;
+
+/**
+* @brief Serializes the runs and the changes to their configuration
+*/
+static DEFINE_MUTEX(run_lock);
+
+/**
+* @brief Copies a name written by user space
+*
+* @param name Buffer of PROJECT2_NAME_LEN bytes receiving the name
+* @param ubuf User buffer
+* @param count Size of the user buffer
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int __copy_name(char *name, const char __user *ubuf, size_t count)
+{
+	if (count >= PROJECT2_NAME_LEN)
+		return -EINVAL;
+
+	if (copy_from_user(name, ubuf, count))
+		return -EFAULT;
+
+	name[count] = '\0';
+
+	return 0;
+}
+
+/**
+* @brief Shows the name of the data structure of the next run
+*/
+static ssize_t type_read(struct file *file, char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	char name[PROJECT2_NAME_LEN];
+	int len;
+
+	mutex_lock(&run_lock);
+	len = scnprintf(name, sizeof(name), "%s\n",
+				project2_type_name(debugfs_cfg.type));
+	mutex_unlock(&run_lock);
+
+	return simple_read_from_buffer(ubuf, count, ppos, name, len);
+}
+
+/**
+* @brief Selects the data structure of the next run by name
+*/
+static ssize_t type_write(struct file *file, const char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	char name[PROJECT2_NAME_LEN];
+	int type;
+	int ret;
+
+	ret = __copy_name(name, ubuf, count);
+	if (ret)
+		return ret;
+
+	type = project2_type_parse(name);
+	if (type < 0)
+		return type;
+
+	mutex_lock(&run_lock);
+	debugfs_cfg.type = type;
+	mutex_unlock(&run_lock);
+
+	return count;
+}
+
+static const struct file_operations type_fops = {
+	.owner = THIS_MODULE,
+	.read = type_read,
+	.write = type_write,
+	.llseek = default_llseek,
+};
+
+/**
+* @brief Shows the key distribution of the next run
+*/
+static ssize_t dist_read(struct file *file, char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	char name[PROJECT2_NAME_LEN];
+	int len;
+
+	mutex_lock(&run_lock);
+	len = scnprintf(name, sizeof(name), "%s\n",
+				project2_dist_name(debugfs_cfg.dist));
+	mutex_unlock(&run_lock);
+
+	return simple_read_from_buffer(ubuf, count, ppos, name, len);
+}
+
+/**
+* @brief Selects the key distribution of the next run by name
+*/
+static ssize_t dist_write(struct file *file, const char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	char name[PROJECT2_NAME_LEN];
+	int dist;
+	int ret;
+
+	ret = __copy_name(name, ubuf, count);
+	if (ret)
+		return ret;
+
+	dist = project2_dist_parse(name);
+	if (dist < 0)
+		return dist;
+
+	mutex_lock(&run_lock);
+	debugfs_cfg.dist = dist;
+	mutex_unlock(&run_lock);
+
+	return count;
+}
+
+static const struct file_operations dist_fops = {
+	.owner = THIS_MODULE,
+	.read = dist_read,
+	.write = dist_write,
+	.llseek = default_llseek,
+};
+
+/**
+* @brief Shows the synchronization of the shared instance of the next run
+*/
+static ssize_t sync_read(struct file *file, char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	char name[PROJECT2_NAME_LEN];
+	int len;
+
+	mutex_lock(&run_lock);
+	len = scnprintf(name, sizeof(name), "%s\n",
+				project2_sync_name(debugfs_cfg.sync));
+	mutex_unlock(&run_lock);
+
+	return simple_read_from_buffer(ubuf, count, ppos, name, len);
+}
+
+/**
+* @brief Selects the synchronization of the shared instance by name
+*/
+static ssize_t sync_write(struct file *file, const char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	char name[PROJECT2_NAME_LEN];
+	int sync;
+	int ret;
+
+	ret = __copy_name(name, ubuf, count);
+	if (ret)
+		return ret;
+
+	sync = project2_sync_parse(name);
+	if (sync < 0)
+		return sync;
+
+	mutex_lock(&run_lock);
+	debugfs_cfg.sync = sync;
+	mutex_unlock(&run_lock);
+
+	return count;
+}
+
+static const struct file_operations sync_fops = {
+	.owner = THIS_MODULE,
+	.read = sync_read,
+	.write = sync_write,
+	.llseek = default_llseek,
+};
+
+/**
+* @brief Shows the benchmark of the next run
+*/
+static ssize_t bench_read(struct file *file, char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	char name[PROJECT2_NAME_LEN];
+	int len;
+
+	mutex_lock(&run_lock);
+	len = scnprintf(name, sizeof(name), "%s\n",
+				project2_bench_name(debugfs_cfg.bench));
+	mutex_unlock(&run_lock);
+
+	return simple_read_from_buffer(ubuf, count, ppos, name, len);
+}
+
+/**
+* @brief Selects the benchmark of the next run by name
+*/
+static ssize_t bench_write(struct file *file, const char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	char name[PROJECT2_NAME_LEN];
+	int bench;
+	int ret;
+
+	ret = __copy_name(name, ubuf, count);
+	if (ret)
+		return ret;
+
+	bench = project2_bench_parse(name);
+	if (bench < 0)
+		return bench;
+
+	mutex_lock(&run_lock);
+	debugfs_cfg.bench = bench;
+	mutex_unlock(&run_lock);
+
+	return count;
+}
+
+static const struct file_operations bench_fops = {
+	.owner = THIS_MODULE,
+	.read = bench_read,
+	.write = bench_write,
+	.llseek = default_llseek,
+};
+
+/**
+* @brief Generates the get/set pair of an integer field of the config,
+*		values outside of [min, max] are rejected.
+*
+* @param field Field of project2_config
+* @param min Smallest accepted value
+* @param max Largest accepted value
+*/
+#define PROJECT2_DEBUGFS_INT(field, min, max) \
+static int field##_get(void *data, u64 *val) \
+{ \
+	mutex_lock(&run_lock); \
+	*val = debugfs_cfg.field; \
+	mutex_unlock(&run_lock); \
+	return 0; \
+} \
+static int field##_set(void *data, u64 val) \
+{ \
+	if ((s64)val < (min) || (s64)val > (max)) \
+		return -EINVAL; \
+	mutex_lock(&run_lock); \
+	debugfs_cfg.field = val; \
+	mutex_unlock(&run_lock); \
+	return 0; \
+} \
+DEFINE_DEBUGFS_ATTRIBUTE(field##_fops, field##_get, field##_set, "%llu\n")
+
+PROJECT2_DEBUGFS_INT(size, 1, INT_MAX / 2);
+PROJECT2_DEBUGFS_INT(batch, 0, INT_MAX / 2);
+PROJECT2_DEBUGFS_INT(threads, 1, NR_CPUS);
+
+/**
+* @brief Shows the CPU the next run is bound to, -1 for any
+*/
+static ssize_t cpu_read(struct file *file, char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	char buf[16];
+	int len;
+
+	mutex_lock(&run_lock);
+	len = scnprintf(buf, sizeof(buf), "%d\n", debugfs_cfg.cpu);
+	mutex_unlock(&run_lock);
+
+	return simple_read_from_buffer(ubuf, count, ppos, buf, len);
+}
+
+/**
+* @brief Binds the next run to a CPU, -1 lets the scheduler pick one
+*/
+static ssize_t cpu_write(struct file *file, const char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	int cpu;
+	int ret;
+
+	ret = kstrtoint_from_user(ubuf, count, 0, &cpu);
+	if (ret)
+		return ret;
+
+	if (cpu < -1 || cpu >= nr_cpu_ids)
+		return -EINVAL;
+
+	mutex_lock(&run_lock);
+	debugfs_cfg.cpu = cpu;
+	mutex_unlock(&run_lock);
+
+	return count;
+}
+
+static const struct file_operations cpu_fops = {
+	.owner = THIS_MODULE,
+	.read = cpu_read,
+	.write = cpu_write,
+	.llseek = default_llseek,
+};
+
+/**
+* @brief Starts the benchmark with the current configuration on any write,
+*		the run happens on the runner kthread.
+*/
+static ssize_t run_write(struct file *file, const char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	int ret;
+
+	mutex_lock(&run_lock);
+	ret = project2_runner_start(project2_run, &debugfs_cfg);
+	mutex_unlock(&run_lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations run_fops = {
+	.owner = THIS_MODULE,
+	.write = run_write,
+	.llseek = noop_llseek,
+};
+
+/**
+* @brief Shows the report of the last run
+*/
+static ssize_t results_read(struct file *file, char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	return project2_report_read(ubuf, count, ppos);
+}
+
+static const struct file_operations results_fops = {
+	.owner = THIS_MODULE,
+	.read = results_read,
+	.llseek = default_llseek,
+};
+
+/**
+* @brief Creates the debugfs control directory
+*
+* @param cfg Initial configuration offered for the runs
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_debugfs_init(const project2_config *cfg)
+{
+	debugfs_cfg = *cfg;
+
+	project2_dir = debugfs_create_dir("project2", NULL);
+	if (IS_ERR_OR_NULL(project2_dir))
+		return project2_dir ? PTR_ERR(project2_dir) : -ENODEV;
+
+	debugfs_create_file("type", 0600, project2_dir, NULL, &type_fops);
+	debugfs_create_file("dist", 0600, project2_dir, NULL, &dist_fops);
+	debugfs_create_file_unsafe("size", 0600, project2_dir, NULL,
+						&size_fops);
+	debugfs_create_file_unsafe("batch", 0600, project2_dir, NULL,
+						&batch_fops);
+	debugfs_create_file_unsafe("threads", 0600, project2_dir, NULL,
+						&threads_fops);
+	debugfs_create_file("sync", 0600, project2_dir, NULL, &sync_fops);
+	debugfs_create_file("cpu", 0600, project2_dir, NULL, &cpu_fops);
+	debugfs_create_file("bench", 0600, project2_dir, NULL, &bench_fops);
+	debugfs_create_file("run", 0200, project2_dir, NULL, &run_fops);
+	debugfs_create_file("results", 0400, project2_dir, NULL, &results_fops);
+
+	return 0;
+}
+
+/**
+* @brief Removes the debugfs control directory
+*/
+void project2_debugfs_exit(void)
+{
+	debugfs_remove_recursive(project2_dir);
+	project2_dir = NULL;
+}
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 debugfs controls for running the benchmarks\n");
@@ -0,0 +1,472 @@
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/hashtable.h>
+#include "project2.h"
+
+/**
+* @brief Order of the number of buckets, fixed when the module is built
+*/
+#define PROJECT2_HTABLE_BITS 16
+
+/**
+* @brief Context for the fixed size hash table test
+*
+* The table never grows, so the chains get longer with the number of keys.
+*/
+typedef struct project2_htable_context_t {
+	DECLARE_HASHTABLE(table, PROJECT2_HTABLE_BITS);
+	int nr; /*Number of keys in the table */
+	int cursor; /*Bucket where remove_batch resumes */
+} project2_htable_context;
+
+/**
+* @brief Node of the hash table
+*/
+typedef struct my_hnode_t {
+	int value; /*Value to be stored */
+	struct hlist_node hnode; /*Links the node into its bucket */
+} my_hnode;
+
+/**
+* @brief Allocator for the hash table nodes
+*/
+project2_pool project2_htable_pool = PROJECT2_POOL_INIT("project2_hnode",
+									my_hnode);
+
+/**
+* @brief Helper function to find the node holding value
+*
+* @param htable_context Context of the table
+* @param value Value to be searched
+*
+* @return NULL if value is not present, Address of the node otherwise
+*/
+static my_hnode *__find_htable_node(project2_htable_context *htable_context,
+						int value)
+{
+	my_hnode *curr;
+
+	hash_for_each_possible(htable_context->table, curr, hnode, value)
+		if (curr->value == value)
+			return curr;
+
+	return NULL;
+}
+
+/**
+* @brief Helper API to link node into its bucket
+*
+* @param htable_context Context of the table
+* @param node Node to be inserted
+*
+* @return 0 for success and -EEXIST if the value is already present
+*/
+static int __add_htable_node(project2_htable_context *htable_context,
+						my_hnode *node)
+{
+	if (__find_htable_node(htable_context, node->value))
+		return -EEXIST;
+
+	hash_add(htable_context->table, &node->hnode, node->value);
+	htable_context->nr++;
+
+	return 0;
+}
+
+/**
+* @brief Add size number of Random Integers to the table
+*
+* @param context Context information for the table
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_htable(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	project2_htable_context *htable_context = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_htable_pool);
+	my_hnode *tmp_node;
+	int tmp_size = size;
+	int skipped = 0;
+	int ret = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_htable is NULL\n");
+		return -EINVAL;
+	}
+
+	while (tmp_size--) {
+		if (project2_yield(size - tmp_size - 1)) {
+			ret = -EINTR;
+			break;
+		}
+
+		start = project2_time_start(hist);
+
+		tmp_node = project2_pool_get(&batch, project2_gfp);
+
+		if (tmp_node == NULL) {
+			printk (KERN_INFO "memory allocation for htable node failed\n");
+			ret = -ENOMEM;
+			break;
+		}
+
+		tmp_node->value = keys[size - tmp_size - 1];
+
+		ret = __add_htable_node(htable_context, tmp_node);
+
+		project2_time_end(hist, start);
+
+		if (ret == -EEXIST) {
+			project2_pool_put(&batch, tmp_node);
+			skipped++;
+			ret = 0;
+			continue;
+		}
+
+		PROJECT2_TRACE(tmp_size, "HTABLE_ADD: %d\n", tmp_node->value);
+	}
+
+	project2_pool_flush(&batch);
+
+	if (skipped)
+		printk(KERN_INFO "Skipped %d duplicate keys\n", skipped);
+
+	PROJECT2_TRACE(0, "\n");
+	return ret;
+}
+
+/**
+* @brief Prints the contents of the table in bucket order
+*
+* @param context Context of the table
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_htable(void *context, project2_hist *hist)
+{
+	project2_htable_context *htable_context = context;
+	my_hnode *curr;
+	unsigned long index = 0;
+	int bkt;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_htable is NULL\n");
+		return;
+	}
+
+	start = project2_time_start(hist);
+
+	hash_for_each(htable_context->table, bkt, curr, hnode) {
+		PROJECT2_TRACE(index++, "HTABLE_SHOW<bucket,value>: <%d, %d>\n",
+					bkt, curr->value);
+
+		project2_time_end(hist, start);
+
+		if (project2_yield(index))
+			return;
+
+		start = project2_time_start(hist);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Removes the entire table.
+*
+* @param context Context of the table.
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_htable(void *context, project2_hist *hist)
+{
+	project2_htable_context *htable_context = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_htable_pool);
+	struct hlist_node *next;
+	my_hnode *curr;
+	unsigned long index = 0;
+	int bkt;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_htable is NULL\n");
+		return -EINVAL;
+	}
+
+	start = project2_time_start(hist);
+
+	hash_for_each_safe(htable_context->table, bkt, next, curr, hnode) {
+		PROJECT2_TRACE(index++, "HTABLE_REMOVE: %d\n", curr->value);
+		hash_del(&curr->hnode);
+		project2_pool_put(&batch, curr);
+
+		project2_time_end(hist, start);
+
+		project2_yield(index);
+
+		start = project2_time_start(hist);
+	}
+
+	project2_pool_flush(&batch);
+
+	htable_context->nr = 0;
+	htable_context->cursor = 0;
+
+	show_htable(context, NULL);
+
+	return 0;
+}
+
+/**
+* @brief Inserts nr keys one by one
+*
+* @param context Context of the table
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success, -EEXIST if some keys were already present or
+*		appropriate error codes on failure
+*/
+static int add_batch_htable(void *context, const int *keys, int nr)
+{
+	project2_htable_context *htable_context = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_htable_pool);
+	my_hnode *tmp_node;
+	int ret = 0;
+	int err;
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_htable is NULL\n");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < nr; i++) {
+		tmp_node = project2_pool_get(&batch, project2_gfp);
+		if (tmp_node == NULL) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		tmp_node->value = keys[i];
+
+		err = __add_htable_node(htable_context, tmp_node);
+		if (err) {
+			project2_pool_put(&batch, tmp_node);
+			ret = err;
+		}
+	}
+
+	project2_pool_flush(&batch);
+
+	return ret;
+}
+
+/**
+* @brief Removes up to nr keys in bucket order, starting at the bucket
+*		where the previous call stopped
+*
+* @param context Context of the table
+* @param keys Receives the removed keys
+* @param nr Maximum number of keys to remove
+*
+* @return Number of removed keys or appropriate error codes on failure
+*/
+static int remove_batch_htable(void *context, int *keys, int nr)
+{
+	project2_htable_context *htable_context = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_htable_pool);
+	struct hlist_node *next;
+	my_hnode *curr;
+	int count = 0;
+	int bkt;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_htable is NULL\n");
+		return -EINVAL;
+	}
+
+	// Every bucket is visited at most once, even if the table drains.
+	for (bkt = 0; bkt < HASH_SIZE(htable_context->table) &&
+			count < nr && htable_context->nr; bkt++) {
+		hlist_for_each_entry_safe(curr, next,
+			&htable_context->table[htable_context->cursor], hnode) {
+			if (count == nr)
+				break;
+
+			keys[count++] = curr->value;
+
+			hash_del(&curr->hnode);
+			project2_pool_put(&batch, curr);
+			htable_context->nr--;
+		}
+
+		if (count < nr)
+			htable_context->cursor = (htable_context->cursor + 1) &
+					(HASH_SIZE(htable_context->table) - 1);
+	}
+
+	project2_pool_flush(&batch);
+
+	return count;
+}
+
+/**
+* @brief Erases every key in [start, end] from the table, one lookup per
+*		key of the range as the table keeps no order
+*
+* @param context Context of the table
+* @param start Start of the range (INCLUSIVE)
+* @param end End of the range (INCLUSIVE)
+*
+* @return Number of erased keys or appropriate error codes on failure
+*/
+static int remove_range_htable(void *context, int start, int end)
+{
+	project2_htable_context *htable_context = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_htable_pool);
+	my_hnode *curr;
+	int count = 0;
+	long key;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_range_htable is NULL\n");
+		return -EINVAL;
+	}
+
+	for (key = start; key <= end && htable_context->nr; key++) {
+		curr = __find_htable_node(htable_context, key);
+		if (curr) {
+			hash_del(&curr->hnode);
+			project2_pool_put(&batch, curr);
+			htable_context->nr--;
+			count++;
+		}
+
+		project2_yield(key - start);
+	}
+
+	project2_pool_flush(&batch);
+
+	return count;
+}
+
+/**
+* @brief Searches the table for key
+*
+* @param context Context of the table
+* @param key Value to be searched
+*
+* @return true if key is present in the table
+*/
+static bool lookup_htable(void *context, int key)
+{
+	if (!context)
+		return false;
+
+	return __find_htable_node(context, key) != NULL;
+}
+
+/**
+* @brief Prints the load factor and the chain lengths of the table
+*
+* @param context Context of the table
+*/
+static void report_htable(void *context)
+{
+	project2_htable_context *htable_context = context;
+	unsigned int buckets = HASH_SIZE(htable_context->table);
+	unsigned int empty = 0;
+	unsigned int longest = 0;
+	unsigned int chain;
+	u64 load;
+	u32 frac;
+	my_hnode *curr;
+	int bkt;
+
+	if (!context)
+		return;
+
+	for (bkt = 0; bkt < buckets; bkt++) {
+		// The walk covers every bucket and node, the figures are
+		// dropped if the run is cancelled meanwhile.
+		if (project2_yield(bkt))
+			return;
+
+		chain = 0;
+
+		hlist_for_each_entry(curr, &htable_context->table[bkt], hnode)
+			chain++;
+
+		if (!chain)
+			empty++;
+
+		longest = max(longest, chain);
+	}
+
+	// Keys per bucket with two decimals.
+	load = div_u64((u64)htable_context->nr * 100, buckets);
+	load = div_u64_rem(load, 100, &frac);
+
+	project2_report("htable: %d keys in %u buckets, load factor %llu.%02u, longest chain %u, %u empty buckets, fixed size\n",
+			htable_context->nr, buckets, load, frac, longest, empty);
+}
+
+/**
+* @brief Deallocates the context
+*
+* @param context Context for the table
+*/
+static void deinit_htable(void *context)
+{
+	kvfree(context);
+}
+
+/**
+* @brief Initializes the context with empty buckets
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_htable(int size, void **context)
+{
+	project2_htable_context *htable_context;
+
+	// The buckets are embedded, which is too large for a kmalloc.
+	htable_context = kvmalloc(sizeof(project2_htable_context), GFP_KERNEL);
+
+	if (!htable_context) {
+		printk (KERN_INFO "memory allocation for htable context failed\n");
+		return -ENOMEM;
+	}
+
+	hash_init(htable_context->table);
+	htable_context->nr = 0;
+	htable_context->cursor = 0;
+
+	*context = htable_context;
+
+	return 0;
+}
+
+// Generates the handles for the hash table test-case
+PROJECT2_GENERATE_HANDLE(htable,
+			PROJECT2_HANDLE_OP(htable, add_batch),
+			PROJECT2_HANDLE_OP(htable, remove_batch),
+			PROJECT2_HANDLE_OP(htable, remove_range),
+			PROJECT2_HANDLE_OP(htable, lookup),
+			PROJECT2_HANDLE_OP(htable, report));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 for manipulation of hash table data structures\n");
@@ -0,0 +1,560 @@
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/sort.h>
+#include <linux/prefetch.h>
+#include <linux/cache.h>
+#include <linux/bitops.h>
+#include "project2.h"
+
+/**
+* @brief Number of keys in a node of the static B-tree, one cache line
+*/
+#define PROJECT2_SBTREE_KEYS 16
+
+/**
+* @brief Static search layouts of a read-only set
+*/
+typedef enum project2_layout_kind_t {
+	PROJECT2_LAYOUT_EYTZINGER = 0x0, /*Implicit BFS order, 1-indexed */
+	PROJECT2_LAYOUT_SBTREE /*Implicit B-tree, one cache line per node */
+} project2_layout_kind;
+
+/**
+* @brief Context for the static layout tests
+*
+* Inserts only append to keys. The first lookup after an insert sorts keys
+* and lays them out again in search order, so the layout is meant to be
+* read far more than it is written.
+*/
+typedef struct project2_layout_context_t {
+	int *keys; /*Buffer holding the keys appended so far */
+	int nr; /*Number of keys in the buffer */
+	int max; /*Capacity of the buffer */
+	void *mem; /*Allocation backing layout */
+	int *layout; /*Keys in search order, aligned to a cache line */
+	int nr_blocks; /*Number of nodes of the static B-tree */
+	bool has_max; /*INT_MAX is a key and not only the B-tree padding */
+	bool settled; /*Set while layout matches keys */
+	project2_layout_kind kind;
+} project2_layout_context;
+
+
+/**
+* @brief Fills the Eytzinger layout with the sorted keys by an in-order
+*		walk of the implicit tree
+*
+* @param layout_context Context of the layout
+* @param i Index of the next sorted key
+* @param k Index of the node in the layout
+* @param may_sleep Reschedule every PROJECT2_RESCHED_INTERVAL keys
+*
+* @return Index of the next sorted key after the subtree of k
+*/
+static int __fill_eytzinger(project2_layout_context *layout_context, int i,
+						unsigned long k, bool may_sleep)
+{
+	if (k <= layout_context->nr) {
+		i = __fill_eytzinger(layout_context, i, 2 * k, may_sleep);
+		layout_context->layout[k] = layout_context->keys[i++];
+
+		if (may_sleep)
+			project2_yield(i);
+
+		i = __fill_eytzinger(layout_context, i, 2 * k + 1, may_sleep);
+	}
+
+	return i;
+}
+
+/**
+* @brief Fills the static B-tree with the sorted keys by an in-order walk,
+*		node k has children k * (PROJECT2_SBTREE_KEYS + 1) + 1 + j
+*
+* @param layout_context Context of the layout
+* @param i Index of the next sorted key
+* @param k Index of the node
+* @param may_sleep Reschedule every PROJECT2_RESCHED_INTERVAL nodes
+*
+* @return Index of the next sorted key after the subtree of k
+*/
+static int __fill_sbtree(project2_layout_context *layout_context, int i,
+						unsigned long k, bool may_sleep)
+{
+	int *node;
+	int j;
+
+	if (k >= layout_context->nr_blocks)
+		return i;
+
+	node = layout_context->layout + k * PROJECT2_SBTREE_KEYS;
+
+	for (j = 0; j < PROJECT2_SBTREE_KEYS; j++) {
+		i = __fill_sbtree(layout_context, i,
+				k * (PROJECT2_SBTREE_KEYS + 1) + 1 + j, may_sleep);
+
+		// Slots past the last key are padded with the largest key.
+		node[j] = i < layout_context->nr ?
+					layout_context->keys[i++] : INT_MAX;
+	}
+
+	if (may_sleep)
+		project2_yield(k + 1);
+
+	return __fill_sbtree(layout_context, i,
+			k * (PROJECT2_SBTREE_KEYS + 1) + 1 + PROJECT2_SBTREE_KEYS,
+			may_sleep);
+}
+
+/**
+* @brief Lays the sorted keys out in search order, in O(n)
+*
+* @param layout_context Context of the layout
+* @param may_sleep Set if the caller may reschedule
+*/
+static void __lay_out(project2_layout_context *layout_context, bool may_sleep)
+{
+	layout_context->has_max = layout_context->nr &&
+			layout_context->keys[layout_context->nr - 1] == INT_MAX;
+
+	if (layout_context->kind == PROJECT2_LAYOUT_EYTZINGER) {
+		__fill_eytzinger(layout_context, 0, 1, may_sleep);
+	} else {
+		layout_context->nr_blocks = DIV_ROUND_UP(layout_context->nr,
+						PROJECT2_SBTREE_KEYS);
+		__fill_sbtree(layout_context, 0, 0, may_sleep);
+	}
+
+	layout_context->settled = true;
+}
+
+/**
+* @brief Sorts the keys appended since the last lookup and lays them out
+*
+* A lookup may run under a spinlock of the concurrent benches, so only the
+* other callers reschedule. sort() itself has no resched point.
+*
+* @param layout_context Context of the layout
+* @param may_sleep Set if the caller may reschedule
+*/
+static void __settle_layout(project2_layout_context *layout_context,
+						bool may_sleep)
+{
+	if (layout_context->settled)
+		return;
+
+	sort(layout_context->keys, layout_context->nr, sizeof(int),
+						project2_cmp_int, NULL);
+
+	if (may_sleep)
+		cond_resched();
+
+	__lay_out(layout_context, may_sleep);
+}
+
+/**
+* @brief Add size number of Random Integers to the set
+*
+* @param context Context information for the layout
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_layout(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	project2_layout_context *layout_context =
+							(project2_layout_context *) context;
+	int tmp_size = size;
+	int data;
+	int ret = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_layout is NULL\n");
+		return -EINVAL;
+	}
+
+	while (tmp_size--) {
+
+		if (project2_yield(size - tmp_size - 1)) {
+			ret = -EINTR;
+			break;
+		}
+
+		data = keys[size - tmp_size - 1];
+
+		if (layout_context->nr >= layout_context->max) {
+			printk(KERN_INFO "static layout is full\n");
+			ret = -ENOSPC;
+			break;
+		}
+
+		start = project2_time_start(hist);
+
+		layout_context->keys[layout_context->nr++] = data;
+		layout_context->settled = false;
+
+		project2_time_end(hist, start);
+
+		PROJECT2_TRACE(tmp_size, "LAYOUT_ADD: %d\n", data);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+
+	return ret;
+}
+
+/**
+* @brief Prints the contents of the set in ascending order
+*
+* @param context Context of the layout
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_layout(void *context, project2_hist *hist)
+{
+	project2_layout_context *layout_context =
+							(project2_layout_context *) context;
+	int index;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_layout is NULL\n");
+		return;
+	}
+
+	__settle_layout(layout_context, true);
+
+	start = project2_time_start(hist);
+
+	for (index = 0; index < layout_context->nr; index++) {
+		PROJECT2_TRACE(index, "LAYOUT_SHOW: %d\n",
+						layout_context->keys[index]);
+
+		project2_time_end(hist, start);
+
+		if (project2_yield(index))
+			return;
+
+		start = project2_time_start(hist);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Removes all the keys, the layout is dropped with them
+*
+* @param context Context of the layout
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_layout(void *context, project2_hist *hist)
+{
+	project2_layout_context *layout_context =
+							(project2_layout_context *) context;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_layout is NULL\n");
+		return -EINVAL;
+	}
+
+	start = project2_time_start(hist);
+
+	layout_context->nr = 0;
+	layout_context->nr_blocks = 0;
+	layout_context->has_max = false;
+	layout_context->settled = true;
+
+	project2_time_end(hist, start);
+
+	PROJECT2_TRACE(0, "LAYOUT_DEL\n");
+
+	return 0;
+}
+
+/**
+* @brief Appends nr keys to the set
+*
+* @param context Context of the layout
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int add_batch_layout(void *context, const int *keys, int nr)
+{
+	project2_layout_context *layout_context =
+							(project2_layout_context *) context;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_layout is NULL\n");
+		return -EINVAL;
+	}
+
+	if (nr > layout_context->max - layout_context->nr)
+		return -ENOSPC;
+
+	memcpy(layout_context->keys + layout_context->nr, keys,
+			nr * sizeof(int));
+	layout_context->nr += nr;
+	layout_context->settled = false;
+
+	return 0;
+}
+
+/**
+* @brief Lays out sorted keys directly, without the sort of a lookup
+*
+* @param context Context of the layout, which must be empty
+* @param keys Strictly increasing keys
+* @param nr Number of keys
+*
+* @return 0 for success, -EBUSY if the set is not empty, -EINVAL if the
+*		keys are not strictly increasing or -ENOSPC
+*/
+static int build_layout(void *context, const int *keys, int nr)
+{
+	project2_layout_context *layout_context =
+							(project2_layout_context *) context;
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to build_layout is NULL\n");
+		return -EINVAL;
+	}
+
+	if (layout_context->nr)
+		return -EBUSY;
+
+	if (nr < 0 || nr > layout_context->max)
+		return nr < 0 ? -EINVAL : -ENOSPC;
+
+	for (i = 1; i < nr; i++)
+		if (keys[i - 1] >= keys[i])
+			return -EINVAL;
+
+	memcpy(layout_context->keys, keys, nr * sizeof(int));
+	layout_context->nr = nr;
+
+	// The keys were checked to be sorted, so the sort is skipped.
+	__lay_out(layout_context, true);
+
+	return 0;
+}
+
+/**
+* @brief Searches the Eytzinger layout, prefetching the line holding the
+*		16 descendants four levels below the current node
+*
+* @param layout_context Context of the layout
+* @param key Value to be searched
+*
+* @return true if key is present in the set
+*/
+static bool __lookup_eytzinger(project2_layout_context *layout_context,
+						int key)
+{
+	const int *layout = layout_context->layout;
+	unsigned long nr = layout_context->nr;
+	unsigned long k = 1;
+
+	while (k <= nr) {
+		prefetch(layout + 16 * k);
+		k = 2 * k + (layout[k] < key);
+	}
+
+	// Undo the right turns after the last left one, k is the lower bound.
+	k >>= ffz(k) + 1;
+
+	return k && layout[k] == key;
+}
+
+/**
+* @brief Searches the static B-tree, the rank of key inside a node is
+*		counted without branches
+*
+* @param layout_context Context of the layout
+* @param key Value to be searched
+*
+* @return true if key is present in the set
+*/
+static bool __lookup_sbtree(project2_layout_context *layout_context, int key)
+{
+	const int *node;
+	unsigned long k = 0;
+	int candidate = INT_MAX;
+	int rank;
+	int j;
+
+	while (k < layout_context->nr_blocks) {
+		node = layout_context->layout + k * PROJECT2_SBTREE_KEYS;
+		rank = 0;
+
+		for (j = 0; j < PROJECT2_SBTREE_KEYS; j++)
+			rank += node[j] < key;
+
+		if (rank < PROJECT2_SBTREE_KEYS)
+			candidate = node[rank];
+
+		k = k * (PROJECT2_SBTREE_KEYS + 1) + 1 + rank;
+	}
+
+	return candidate == key && (key != INT_MAX || layout_context->has_max);
+}
+
+/**
+* @brief Searches the layout for key
+*
+* @param context Context of the layout
+* @param key Value to be searched
+*
+* @return true if key is present in the set
+*/
+static bool lookup_layout(void *context, int key)
+{
+	project2_layout_context *layout_context =
+							(project2_layout_context *) context;
+
+	if (!context)
+		return false;
+
+	__settle_layout(layout_context, false);
+
+	if (layout_context->kind == PROJECT2_LAYOUT_EYTZINGER)
+		return __lookup_eytzinger(layout_context, key);
+
+	return __lookup_sbtree(layout_context, key);
+}
+
+/**
+* @brief Deallocates the context
+*
+* @param context Context for the layout
+*/
+static void deinit_layout(void *context)
+{
+	project2_layout_context *layout_context =
+							(project2_layout_context *) context;
+
+	if (context) {
+		kvfree(layout_context->mem);
+		kvfree(layout_context->keys);
+		kfree(context);
+	}
+}
+
+/**
+* @brief Initializes the context by allocating the key buffer and the
+*		layout for up to size keys
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+* @param kind Layout of the keys.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int __init_layout(int size, void **context, project2_layout_kind kind)
+{
+	project2_layout_context *layout_context =
+				kzalloc(sizeof(project2_layout_context), GFP_KERNEL);
+	size_t bytes;
+
+	if (!layout_context) {
+		printk (KERN_INFO "memory allocation for layout context failed\n");
+		return -ENOMEM;
+	}
+
+	// Eytzinger leaves slot 0 unused, the B-tree pads its last node.
+	if (kind == PROJECT2_LAYOUT_EYTZINGER)
+		bytes = ((size_t)size + 1) * sizeof(int);
+	else
+		bytes = round_up((size_t)size, PROJECT2_SBTREE_KEYS) * sizeof(int);
+
+	layout_context->keys = kvmalloc_array(size, sizeof(int), GFP_KERNEL);
+	layout_context->mem = kvmalloc(bytes + L1_CACHE_BYTES, GFP_KERNEL);
+
+	if (layout_context->keys == NULL || layout_context->mem == NULL) {
+		printk (KERN_INFO "memory allocation for layout buffer failed\n");
+		deinit_layout(layout_context);
+		return -ENOMEM;
+	}
+
+	layout_context->layout = PTR_ALIGN((int *)layout_context->mem,
+							L1_CACHE_BYTES);
+	layout_context->max = size;
+	layout_context->settled = true;
+	layout_context->kind = kind;
+
+	*context = layout_context;
+
+	return 0;
+}
+
+/**
+* @brief Initializes the context of the Eytzinger layout
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_eytzinger(int size, void **context)
+{
+	return __init_layout(size, context, PROJECT2_LAYOUT_EYTZINGER);
+}
+
+/**
+* @brief Initializes the context of the static B-tree
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_sbtree(int size, void **context)
+{
+	return __init_layout(size, context, PROJECT2_LAYOUT_SBTREE);
+}
+
+// Both layouts share every operation except the init.
+#define add_eytzinger add_layout
+#define show_eytzinger show_layout
+#define remove_eytzinger remove_layout
+#define deinit_eytzinger deinit_layout
+#define add_batch_eytzinger add_batch_layout
+#define lookup_eytzinger lookup_layout
+#define build_eytzinger build_layout
+
+#define add_sbtree add_layout
+#define show_sbtree show_layout
+#define remove_sbtree remove_layout
+#define deinit_sbtree deinit_layout
+#define add_batch_sbtree add_batch_layout
+#define lookup_sbtree lookup_layout
+#define build_sbtree build_layout
+
+// Generates the handles for the Eytzinger layout test-case
+PROJECT2_GENERATE_HANDLE(eytzinger,
+			PROJECT2_HANDLE_OP(eytzinger, add_batch),
+			PROJECT2_HANDLE_OP(eytzinger, lookup),
+			PROJECT2_HANDLE_OP(eytzinger, build),
+			PROJECT2_HANDLE_FLAGS(eytzinger,
+					PROJECT2_HANDLE_LOOKUP_WRITES));
+
+// Generates the handles for the static B-tree test-case
+PROJECT2_GENERATE_HANDLE(sbtree,
+			PROJECT2_HANDLE_OP(sbtree, add_batch),
+			PROJECT2_HANDLE_OP(sbtree, lookup),
+			PROJECT2_HANDLE_OP(sbtree, build),
+			PROJECT2_HANDLE_FLAGS(sbtree,
+					PROJECT2_HANDLE_LOOKUP_WRITES));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 for manipulation of static search layouts\n");
@@ -11,16 +11,23 @@ typedef struct project2_list_t {
 	struct list_head list;
 } project2_list;
 
+/**
+* @brief Allocator for the list nodes
+*/
+project2_pool project2_list_pool = PROJECT2_POOL_INIT("project2_list",
+									project2_list);
 
 /**
 * @brief Helper API to perform insertion in the list.
 *
 * @param head Head of the list.
 * @param data Data which is to be inserted.
+* @param batch Batch of the list pool to allocate the node from.
 *
 * @return 0 for success and appropriate error codes for failure
 */
-static int __add_list(struct list_head *head, int data)
+static int __add_list(struct list_head *head, int data,
+						project2_pool_batch *batch)
 {
 	project2_list *tmp;
 
@@ -29,7 +36,7 @@ static int __add_list(struct list_head *head, int data)
 		return -EINVAL;
 	}
 
-	tmp  = kmalloc(sizeof(project2_list), GFP_KERNEL);
+	tmp = project2_pool_get(batch, project2_gfp);
 
 	if (tmp == NULL) {
 		printk (KERN_INFO "memory allocation for list addition failed\n");
@@ -40,8 +47,6 @@ static int __add_list(struct list_head *head, int data)
 
 	list_add_tail(&tmp->list, head);
 
-	printk(KERN_INFO "LIST_ADD: %d\n", tmp->data);
-
 	return 0;
 }
 
@@ -49,16 +54,21 @@ static int __add_list(struct list_head *head, int data)
 * @brief Add size number of random numbers to the list
 *
 * @param context Context information for the list
+* @param keys Keys to be inserted
 * @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
 *
 * @return 0 if successful otherwise appropriate error codes
 */
-static int add_list(void *context, int size)
+static int add_list(void *context, const int *keys, int size,
+						project2_hist *hist)
 {
 	int data;
 	struct list_head *head = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_list_pool);
 	int ret = 0;
 	int tmp_size = size;
+	u64 start;
 
 	if (!context) {
 		printk(KERN_INFO "context to add_list is NULL\n");
@@ -67,15 +77,29 @@ static int add_list(void *context, int size)
 
 	while (tmp_size--) {
 
-		data = project2_get_next_integer(size);
+		if (project2_yield(size - tmp_size - 1)) {
+			ret = -EINTR;
+			break;
+		}
+
+		data = keys[size - tmp_size - 1];
 
-		ret = __add_list(head, data);
+		start = project2_time_start(hist);
+
+		ret = __add_list(head, data, &batch);
+
+		project2_time_end(hist, start);
 
 		if (ret)
 			break;
+
+		PROJECT2_TRACE(tmp_size, "LIST_ADD: %d\n", data);
 	}
 
-	printk(KERN_INFO "\n");
+	// Release the nodes which were allocated in bulk but not used.
+	project2_pool_flush(&batch);
+
+	PROJECT2_TRACE(0, "\n");
 
 	return ret;
 }
@@ -84,11 +108,14 @@ static int add_list(void *context, int size)
 * @brief Prints the contents of the list from head
 *
 * @param context Context of the list
+* @param hist Histogram for per element latency, may be NULL
 */
-static void show_list(void *context)
+static void show_list(void *context, project2_hist *hist)
 {
 	struct list_head *head = context;
 	project2_list *tmp;
+	unsigned long index = 0;
+	u64 start;
 
 	if (!context) {
 		printk(KERN_INFO "context to show_list is NULL\n");
@@ -98,25 +125,39 @@ static void show_list(void *context)
 	if (list_empty(head))
 		return;
 
+	start = project2_time_start(hist);
+
 	list_for_each_entry(tmp, head, list) {
-		printk(KERN_INFO "LIST_SHOW: %d\n", tmp->data);
+		PROJECT2_TRACE(index++, "LIST_SHOW: %d\n", tmp->data);
+
+		// Each sample covers the step to the node and its processing.
+		project2_time_end(hist, start);
+
+		if (project2_yield(index))
+			return;
+
+		start = project2_time_start(hist);
 	}
 
-	printk(KERN_INFO "\n");
+	PROJECT2_TRACE(0, "\n");
 }
 
 /**
 * @brief Removes the entire list.
 *
 * @param context Context of the list.
+* @param hist Histogram for per element latency, may be NULL
 *
 * @return 0 for success and appropriate error codes on failure
 */
-static int remove_list(void *context)
+static int remove_list(void *context, project2_hist *hist)
 {
 	struct list_head *head = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_list_pool);
 	project2_list *curr;
 	project2_list *next;
+	unsigned long index = 0;
+	u64 start;
 
 	if (!context) {
 		printk(KERN_INFO "context to remove_list is NULL\n");
@@ -128,18 +169,146 @@ static int remove_list(void *context)
 
 	list_for_each_entry_safe(curr, next, head, list)
 	{
+		start = project2_time_start(hist);
 		list_del(&curr->list);
-		printk(KERN_INFO "LIST_DEL: %d\n", curr->data);
-		kfree (curr);
+		PROJECT2_TRACE(index++, "LIST_DEL: %d\n", curr->data);
+		project2_pool_put(&batch, curr);
+		project2_time_end(hist, start);
+
+		project2_yield(index);
 	}
 
-	show_list(context);
+	project2_pool_flush(&batch);
 
-	printk(KERN_INFO "\n");
+	show_list(context, NULL);
+
+	PROJECT2_TRACE(0, "\n");
 
 	return 0;
 }
 
+/**
+* @brief Appends nr keys to the list with a single splice
+*
+* @param context Context of the list
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int add_batch_list(void *context, const int *keys, int nr)
+{
+	struct list_head *head = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_list_pool);
+	LIST_HEAD(staging);
+	int ret = 0;
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_list is NULL\n");
+		return -EINVAL;
+	}
+
+	// Link the new nodes privately, then publish them at once.
+	for (i = 0; i < nr; i++) {
+		ret = __add_list(&staging, keys[i], &batch);
+		if (ret)
+			break;
+	}
+
+	project2_pool_flush(&batch);
+
+	list_splice_tail(&staging, head);
+
+	return ret;
+}
+
+/**
+* @brief Removes up to nr elements from the head of the list
+*
+* @param context Context of the list
+* @param keys Receives the removed values
+* @param nr Maximum number of elements to remove
+*
+* @return Number of removed elements or appropriate error codes on failure
+*/
+static int remove_batch_list(void *context, int *keys, int nr)
+{
+	struct list_head *head = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_list_pool);
+	project2_list *curr;
+	project2_list *next;
+	int count = 0;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_list is NULL\n");
+		return -EINVAL;
+	}
+
+	list_for_each_entry_safe(curr, next, head, list) {
+		if (count == nr)
+			break;
+
+		keys[count++] = curr->data;
+		list_del(&curr->list);
+		project2_pool_put(&batch, curr);
+	}
+
+	project2_pool_flush(&batch);
+
+	return count;
+}
+
+/**
+* @brief Adds up the values of the list, reading every one of them
+*
+* @param context Context of the list
+*
+* @return Sum of the values, partial if the run was cancelled
+*/
+static s64 sum_list(void *context)
+{
+	struct list_head *head = context;
+	project2_list *tmp;
+	unsigned long index = 0;
+	s64 sum = 0;
+
+	if (!context)
+		return 0;
+
+	list_for_each_entry(tmp, head, list) {
+		sum += tmp->data;
+
+		if (project2_yield(++index))
+			break;
+	}
+
+	return sum;
+}
+
+/**
+* @brief Searches the list for key
+*
+* @param context Context of the list
+* @param key Value to be searched
+*
+* @return true if key is present in the list
+*/
+static bool lookup_list(void *context, int key)
+{
+	struct list_head *head = context;
+	project2_list *tmp;
+
+	if (!context)
+		return false;
+
+	list_for_each_entry(tmp, head, list)
+		if (tmp->data == key)
+			return true;
+
+	return false;
+}
+
 /**
 * @brief Initializes the context by adding a head for the test
 *
@@ -178,24 +347,30 @@ static void deinit_list(void *context)
 /**
 * @brief Executes all list functions in 1 function
 *
+* @param keys Keys to be inserted
 * @param size Number of integers to be inserted
 *
 * @return 0 for success or appropriate error code on failure.
 */
-int project2_list_standalone(int size)
+int project2_list_standalone(const int *keys, int size)
 {
 	LIST_HEAD(my_head);
 	int tmp_size = size;
 	int data;
 	project2_list *tmp;
 	project2_list *next;
+	unsigned long index = 0;
 
 	printk(KERN_INFO "##################################\n");
 	printk(KERN_INFO "Running single function list test\n");
 
 	while (tmp_size--) {
 
-		data = project2_get_next_integer(size);
+		// A cancelled run still frees what was added below.
+		if (project2_yield(size - tmp_size - 1))
+			break;
+
+		data = keys[size - tmp_size - 1];
 
 		tmp  = kmalloc(sizeof(project2_list), GFP_KERNEL);
 
@@ -208,32 +383,40 @@ int project2_list_standalone(int size)
 
 		list_add_tail(&tmp->list, &my_head);
 
-		printk(KERN_INFO "LIST1_ADD: %d\n", tmp->data);
+		PROJECT2_TRACE(tmp_size, "LIST1_ADD: %d\n", tmp->data);
 	}
 
-	printk(KERN_INFO "\n");
+	PROJECT2_TRACE(0, "\n");
 
 	list_for_each_entry(tmp, &my_head, list) {
-		printk(KERN_INFO "LIST1_SHOW: %d\n", tmp->data);
+		PROJECT2_TRACE(index++, "LIST1_SHOW: %d\n", tmp->data);
+		project2_yield(index);
 	}
 
-	printk(KERN_INFO "\n");
+	PROJECT2_TRACE(0, "\n");
+
+	index = 0;
 
 	list_for_each_entry_safe(tmp, next, &my_head, list)
 	{
 		list_del(&tmp->list);
-		printk(KERN_INFO "LIST1_DEL: %d\n", tmp->data);
+		PROJECT2_TRACE(index++, "LIST1_DEL: %d\n", tmp->data);
 		kfree (tmp);
+		project2_yield(index);
 	}
 
-	printk(KERN_INFO "\n");
+	PROJECT2_TRACE(0, "\n");
 	printk(KERN_INFO "##################################\n");
 
 	return 0;
 }
 
 // Generates the handles for the list test-case
-PROJECT2_GENERATE_HANDLE(list);
+PROJECT2_GENERATE_HANDLE(list,
+			PROJECT2_HANDLE_OP(list, add_batch),
+			PROJECT2_HANDLE_OP(list, remove_batch),
+			PROJECT2_HANDLE_OP(list, lookup),
+			PROJECT2_HANDLE_OP(list, sum));
 
 // Module related macros
 MODULE_LICENSE("GPL");
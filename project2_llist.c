@@ -0,0 +1,361 @@
+#include <linux/module.h>
+#include <linux/llist.h>
+#include <linux/slab.h>
+#include "project2.h"
+
+/**
+* @brief Node of the lock-less list.
+*/
+typedef struct project2_llist_t {
+	int data;
+	struct llist_node node;
+} project2_llist;
+
+/**
+* @brief Context of the lock-less list
+*
+* Producers push onto head with a cmpxchg, which leaves it newest first.
+* The single consumer takes the whole chain at once and keeps it oldest
+* first in drained until it is consumed.
+*/
+typedef struct project2_llist_head_t {
+	struct llist_head head; /*Pushed by any number of producers */
+	struct llist_node *drained; /*Taken from head, owned by the consumer */
+} project2_llist_head;
+
+/**
+* @brief Allocator for the llist nodes
+*/
+project2_pool project2_llist_pool = PROJECT2_POOL_INIT("project2_llist",
+									project2_llist);
+
+/**
+* @brief Helper API to take the next node in push order.
+*
+* Refills the drained chain from head once it is used up.
+*
+* @param lhead Context of the list.
+*
+* @return Oldest node or NULL if the list is empty
+*/
+static project2_llist *__pop_llist(project2_llist_head *lhead)
+{
+	struct llist_node *node;
+
+	if (lhead->drained == NULL)
+		lhead->drained = llist_reverse_order(llist_del_all(&lhead->head));
+
+	node = lhead->drained;
+	if (node == NULL)
+		return NULL;
+
+	lhead->drained = node->next;
+
+	return llist_entry(node, project2_llist, node);
+}
+
+/**
+* @brief Add size number of random numbers to the list
+*
+* @param context Context information for the list
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_llist(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	project2_llist_head *lhead = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_llist_pool);
+	project2_llist *tmp;
+	int ret = 0;
+	int tmp_size = size;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_llist is NULL\n");
+		return -EINVAL;
+	}
+
+	while (tmp_size--) {
+
+		if (project2_yield(size - tmp_size - 1)) {
+			ret = -EINTR;
+			break;
+		}
+
+		start = project2_time_start(hist);
+
+		tmp = project2_pool_get(&batch, project2_gfp);
+
+		if (tmp == NULL) {
+			printk (KERN_INFO "memory allocation for llist addition failed\n");
+			ret = -ENOMEM;
+			break;
+		}
+
+		tmp->data = keys[size - tmp_size - 1];
+		llist_add(&tmp->node, &lhead->head);
+
+		project2_time_end(hist, start);
+
+		PROJECT2_TRACE(tmp_size, "LLIST_ADD: %d\n", tmp->data);
+	}
+
+	project2_pool_flush(&batch);
+
+	PROJECT2_TRACE(0, "\n");
+
+	return ret;
+}
+
+/**
+* @brief Prints the contents of the list, the drained part oldest first
+*		followed by the pushed part newest first
+*
+* @param context Context of the list
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_llist(void *context, project2_hist *hist)
+{
+	project2_llist_head *lhead = context;
+	project2_llist *tmp;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_llist is NULL\n");
+		return;
+	}
+
+	start = project2_time_start(hist);
+
+	llist_for_each_entry(tmp, lhead->drained, node) {
+		PROJECT2_TRACE(index++, "LLIST_SHOW: %d\n", tmp->data);
+		project2_time_end(hist, start);
+
+		if (project2_yield(index))
+			return;
+
+		start = project2_time_start(hist);
+	}
+
+	llist_for_each_entry(tmp, lhead->head.first, node) {
+		PROJECT2_TRACE(index++, "LLIST_SHOW: %d\n", tmp->data);
+		project2_time_end(hist, start);
+
+		if (project2_yield(index))
+			return;
+
+		start = project2_time_start(hist);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Removes the entire list.
+*
+* @param context Context of the list.
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_llist(void *context, project2_hist *hist)
+{
+	project2_llist_head *lhead = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_llist_pool);
+	project2_llist *tmp;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_llist is NULL\n");
+		return -EINVAL;
+	}
+
+	for (;;) {
+		start = project2_time_start(hist);
+
+		tmp = __pop_llist(lhead);
+		if (tmp == NULL)
+			break;
+
+		PROJECT2_TRACE(index++, "LLIST_DEL: %d\n", tmp->data);
+		project2_pool_put(&batch, tmp);
+		project2_time_end(hist, start);
+
+		project2_yield(index);
+	}
+
+	project2_pool_flush(&batch);
+
+	show_llist(context, NULL);
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Pushes nr keys with a single cmpxchg, safe against other
+*		producers and the consumer
+*
+* @param context Context of the list
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int add_batch_llist(void *context, const int *keys, int nr)
+{
+	project2_llist_head *lhead = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_llist_pool);
+	struct llist_node *first = NULL;
+	struct llist_node *last = NULL;
+	project2_llist *tmp;
+	int ret = 0;
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_llist is NULL\n");
+		return -EINVAL;
+	}
+
+	// Chain the nodes privately newest first, as llist_add would.
+	for (i = 0; i < nr; i++) {
+		tmp = project2_pool_get(&batch, project2_gfp);
+		if (tmp == NULL) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		tmp->data = keys[i];
+		tmp->node.next = first;
+		first = &tmp->node;
+
+		if (last == NULL)
+			last = first;
+	}
+
+	project2_pool_flush(&batch);
+
+	if (first)
+		llist_add_batch(first, last, &lhead->head);
+
+	return ret;
+}
+
+/**
+* @brief Drains up to nr elements in push order, only one thread may
+*		consume at a time
+*
+* @param context Context of the list
+* @param keys Receives the removed values
+* @param nr Maximum number of elements to remove
+*
+* @return Number of removed elements or appropriate error codes on failure
+*/
+static int remove_batch_llist(void *context, int *keys, int nr)
+{
+	project2_llist_head *lhead = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_llist_pool);
+	project2_llist *tmp;
+	int count = 0;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_llist is NULL\n");
+		return -EINVAL;
+	}
+
+	while (count < nr) {
+		tmp = __pop_llist(lhead);
+		if (tmp == NULL)
+			break;
+
+		keys[count++] = tmp->data;
+		project2_pool_put(&batch, tmp);
+	}
+
+	project2_pool_flush(&batch);
+
+	return count;
+}
+
+/**
+* @brief Searches the list for key
+*
+* @param context Context of the list
+* @param key Value to be searched
+*
+* @return true if key is present in the list
+*/
+static bool lookup_llist(void *context, int key)
+{
+	project2_llist_head *lhead = context;
+	project2_llist *tmp;
+
+	if (!context)
+		return false;
+
+	llist_for_each_entry(tmp, lhead->drained, node)
+		if (tmp->data == key)
+			return true;
+
+	llist_for_each_entry(tmp, lhead->head.first, node)
+		if (tmp->data == key)
+			return true;
+
+	return false;
+}
+
+/**
+* @brief Initializes the context by adding a head for the test
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_llist(int size, void **context)
+{
+	project2_llist_head *lhead = kmalloc(sizeof(project2_llist_head),
+								GFP_KERNEL);
+
+	if (lhead == NULL) {
+		printk (KERN_INFO "memory allocation for llist head failed\n");
+		return -ENOMEM;
+	}
+
+	init_llist_head(&lhead->head);
+	lhead->drained = NULL;
+
+	*context = lhead;
+
+	return 0;
+}
+
+/**
+* @brief Deallocates the context
+*
+* @param context Context for the List
+*/
+static void deinit_llist(void *context)
+{
+	if (context)
+		kfree(context);
+}
+
+// Generates the handles for the llist test-case
+PROJECT2_GENERATE_HANDLE(llist,
+			PROJECT2_HANDLE_OP(llist, add_batch),
+			PROJECT2_HANDLE_OP(llist, remove_batch),
+			PROJECT2_HANDLE_OP(llist, lookup),
+			PROJECT2_HANDLE_FLAGS(llist, PROJECT2_HANDLE_MULTI_PRODUCER));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 lock-less list for multi-producer ingest\n");
@@ -1,12 +1,21 @@
 #include <linux/module.h>
 #include <linux/kernel.h>
 #include <linux/init.h>
+#include <linux/mm.h>
+#include <linux/random.h>
+#include <linux/vmstat.h>
+#include <linux/sort.h>
 #include "project2.h"
 
+/**
+* @brief Largest batch size compared by the batch test
+*/
+#define PROJECT2_MAX_BATCH 4096
+
 /**
 * @brief Argument to control the number of integers to insert
 */
-static int dstruct_size __initdata = 5;
+static int dstruct_size = 5;
 
 
 /**
@@ -15,45 +24,255 @@ static int dstruct_size __initdata = 5;
 module_param(dstruct_size, int, 0);
 MODULE_PARM_DESC(dstruct_size, "Number of random numbers to insert in DS");
 
+/**
+* @brief Runs the data structure loops without the per element logging
+*/
+static bool bench_mode;
+module_param(bench_mode, bool, 0);
+MODULE_PARM_DESC(bench_mode, "Disable per element logging to benchmark the DS");
+
+/**
+* @brief Logs every trace_sample-th element in benchmark mode
+*/
+static int trace_sample;
+module_param(trace_sample, int, 0);
+MODULE_PARM_DESC(trace_sample, "Log every Nth element in benchmark mode, 0 for none");
+
+/**
+* @brief Allocator for the list and rbtree nodes
+*/
+static int alloc_mode = PROJECT2_ALLOC_KMALLOC;
+module_param(alloc_mode, int, 0);
+MODULE_PARM_DESC(alloc_mode, "Node allocator: 0 kmalloc, 1 kmem_cache, 2 kmem_cache bulk");
+
+/**
+* @brief Compares the batch operations for batch sizes 1 to 4096
+*/
+static bool batch_test;
+module_param(batch_test, bool, 0);
+MODULE_PARM_DESC(batch_test, "Compare batched add/remove for batch sizes 1..4096");
+
+/**
+* @brief Measures lookup throughput for every handle implementing lookup
+*/
+static bool lookup_test;
+module_param(lookup_test, bool, 0);
+MODULE_PARM_DESC(lookup_test, "Measure lookups/sec for sizes 1000..dstruct_size");
+
+/**
+* @brief Percentage of the lookups which search a key that is present
+*/
+static int hit_ratio = 50;
+module_param(hit_ratio, int, 0);
+MODULE_PARM_DESC(hit_ratio, "Percentage of lookups that hit, 0..100");
+
+/**
+* @brief Number of lookups issued per structure and size
+*/
+static int nr_lookups = 1000000;
+module_param(nr_lookups, int, 0);
+MODULE_PARM_DESC(nr_lookups, "Number of lookups per structure and size");
+
+/**
+* @brief Time after which the lookups of one structure and size are cut short
+*/
+static int lookup_budget_ms = 1000;
+module_param(lookup_budget_ms, int, 0);
+MODULE_PARM_DESC(lookup_budget_ms, "Time limit in ms for the lookups of one run");
+
+/**
+* @brief Distribution of the keys, one of the names of project2_dist
+*/
+static char *wl_dist = "unique";
+module_param(wl_dist, charp, 0);
+MODULE_PARM_DESC(wl_dist, "Key distribution: unique, uniform, sequential, reverse, zipf, hotset, sawtooth");
+
+/**
+* @brief Skew of the Zipfian distribution in hundredths
+*/
+static int wl_theta = 99;
+module_param(wl_theta, int, 0);
+MODULE_PARM_DESC(wl_theta, "Zipfian theta in hundredths, 1..99");
+
+/**
+* @brief Share of the key range which is hot in the hot-set distribution
+*/
+static int wl_hot_keys = 10;
+module_param(wl_hot_keys, int, 0);
+MODULE_PARM_DESC(wl_hot_keys, "Percentage of the keys which are hot, 1..100");
+
+/**
+* @brief Share of the accesses going to the hot keys
+*/
+static int wl_hot_ops = 90;
+module_param(wl_hot_ops, int, 0);
+MODULE_PARM_DESC(wl_hot_ops, "Percentage of the accesses to the hot keys, 0..100");
+
+/**
+* @brief Number of keys per tooth of the sawtooth distribution
+*/
+static int wl_period = 1000;
+module_param(wl_period, int, 0);
+MODULE_PARM_DESC(wl_period, "Keys per tooth of the sawtooth distribution");
+
+/**
+* @brief Op mix of the mixed test in percent, summing to 100
+*/
+static int wl_insert = 100;
+module_param(wl_insert, int, 0);
+MODULE_PARM_DESC(wl_insert, "Percentage of inserts in the mixed test");
+
+static int wl_lookup;
+module_param(wl_lookup, int, 0);
+MODULE_PARM_DESC(wl_lookup, "Percentage of lookups in the mixed test");
+
+static int wl_delete;
+module_param(wl_delete, int, 0);
+MODULE_PARM_DESC(wl_delete, "Percentage of deletes in the mixed test");
+
+/**
+* @brief Seed of the workload generator, 0 picks a random one
+*/
+static unsigned long long wl_seed;
+module_param(wl_seed, ullong, 0);
+MODULE_PARM_DESC(wl_seed, "Seed of the workload, 0 for random, printed for reruns");
+
+/**
+* @brief Runs the op mix against every handle after prefilling it
+*/
+static bool mixed_test;
+module_param(mixed_test, bool, 0);
+MODULE_PARM_DESC(mixed_test, "Run wl_insert/wl_lookup/wl_delete on prefilled structures");
+
+/**
+* @brief Number of ops issued by the mixed test
+*/
+static int nr_ops = 1000000;
+module_param(nr_ops, int, 0);
+MODULE_PARM_DESC(nr_ops, "Number of ops per structure in the mixed test");
+
+/**
+* @brief CPU the runs are bound to, -1 lets the scheduler pick one
+*/
+static int run_cpu = -1;
+module_param(run_cpu, int, 0);
+MODULE_PARM_DESC(run_cpu, "CPU the benchmark kthread is bound to, -1 for any");
+
+/**
+* @brief Number of threads of the load-time run
+*/
+static int nr_threads = 1;
+module_param(nr_threads, int, 0);
+MODULE_PARM_DESC(nr_threads, "Threads sharing one instance, >1 sweeps 1..nr_threads");
+
+/**
+* @brief Synchronization wrapped around the shared instance
+*/
+static char *sync_mode = "spin";
+module_param(sync_mode, charp, 0);
+MODULE_PARM_DESC(sync_mode, "Lock of the shared instance: none, spin, rwlock, mutex");
+
+/**
+* @brief Benchmark of the load-time run, one of the names of project2_bench
+*/
+static char *bench = "suite";
+module_param(bench, charp, 0);
+MODULE_PARM_DESC(bench, "Benchmark: suite, readers, ingest, drain, idmap, hold, ostat, build or iter, an unknown name lists what each one runs");
+
 /**
 * @brief List of Handles to be executed
 */
-static project2_ds_handle ds_handle[] __initdata = {
+static project2_ds_handle ds_handle[] = {
 	PROJECT2_GENERATE_HANDLE_ARRAY(list),
 	PROJECT2_GENERATE_HANDLE_ARRAY(queue),
 	PROJECT2_GENERATE_HANDLE_ARRAY(map),
-	PROJECT2_GENERATE_HANDLE_ARRAY(rbtree)
+	PROJECT2_GENERATE_HANDLE_ARRAY(rbtree),
+	PROJECT2_GENERATE_HANDLE_ARRAY(sarray),
+	PROJECT2_GENERATE_HANDLE_ARRAY(rculist),
+	PROJECT2_GENERATE_HANDLE_ARRAY(llist),
+	PROJECT2_GENERATE_HANDLE_ARRAY(pcpu_queue),
+	PROJECT2_GENERATE_HANDLE_ARRAY(ring),
+	PROJECT2_GENERATE_HANDLE_ARRAY(tqueue),
+	PROJECT2_GENERATE_HANDLE_ARRAY(xarray),
+	PROJECT2_GENERATE_HANDLE_ARRAY(rbtree_cached),
+	PROJECT2_GENERATE_HANDLE_ARRAY(ostree),
+	PROJECT2_GENERATE_HANDLE_ARRAY(rbtree_latch),
+	PROJECT2_GENERATE_HANDLE_ARRAY(eytzinger),
+	PROJECT2_GENERATE_HANDLE_ARRAY(sbtree),
+	PROJECT2_GENERATE_HANDLE_ARRAY(htable),
+	PROJECT2_GENERATE_HANDLE_ARRAY(rhashtable),
+	PROJECT2_GENERATE_HANDLE_ARRAY(ulist)
 };
 
+/**
+* @brief Timing results of one test suite
+*/
+typedef struct project2_result_t {
+	project2_hist add; /*Per element latency of add */
+	project2_hist iterate; /*Per element latency of iterate */
+	project2_hist remove; /*Per element latency of remove */
+	u64 add_ns; /*Wall time of the add phase */
+	u64 iterate_ns; /*Wall time of the iterate phase */
+	u64 remove_ns; /*Wall time of the remove phase */
+	int ret; /*Return code of the test suite */
+	bool valid; /*Set once the suite has been executed */
+} project2_result;
+
+/**
+* @brief Results of the test suites indexed by project2_ds_type
+*/
+static project2_result results[ARRAY_SIZE(ds_handle)];
+
 /**
 * @brief Test case executor function
 *
 * @param handle Handle for the test to be executed
+* @param keys Keys to be inserted
 * @param size Number of integers to be inserted
 * @param context Context of the test being executed
+* @param result Receives the timing of every phase
 *
 * @return 0 for success or appropriate error codes on failure.
 */
-static int execute_test(project2_handle *handle, int size, void *context)
+static int execute_test(project2_handle *handle, const int *keys, int size,
+				void *context, project2_result *result)
 {
 	int ret_add = 0;
 	int ret_del = 0;
+	u64 start;
+
+	project2_hist_init(&result->add);
+	project2_hist_init(&result->iterate);
+	project2_hist_init(&result->remove);
 
 	/* Performs addition of size number of integers */
-	ret_add = handle->add(context, size);
+	start = ktime_get_ns();
+	ret_add = handle->add(context, keys, size, &result->add);
+	result->add_ns = ktime_get_ns() - start;
 	if (ret_add) {
-		printk (KERN_INFO "adding elements failed %d\n", ret_add);
+		project2_report("adding elements failed %d\n", ret_add);
 	}
 
+	/* Prints the figures of the structure once it is full */
+	if (handle->report)
+		handle->report(context);
+
 	/* Prints the current state of the data structure*/
-	handle->iterate(context);
+	start = ktime_get_ns();
+	handle->iterate(context, &result->iterate);
+	result->iterate_ns = ktime_get_ns() - start;
 
 	/* Removes all the integers from the data structure*/
-	ret_del = handle->remove(context);
+	start = ktime_get_ns();
+	ret_del = handle->remove(context, &result->remove);
+	result->remove_ns = ktime_get_ns() - start;
 	if (ret_del) {
-		printk (KERN_INFO "removing elements failed %d\n", ret_del);
+		project2_report("removing elements failed %d\n", ret_del);
 	}
 
+	result->ret = ret_add | ret_del;
+	result->valid = true;
+
 	/* Return error if any of them failed */
 	return ret_add | ret_del;
 }
@@ -62,16 +281,17 @@ static int execute_test(project2_handle *handle, int size, void *context)
 * @brief Runs the test by initializing the handles and calling execute.
 *
 * @param type Type of the test to be run.
+* @param keys Keys to be inserted.
 * @param size Number of integers to be inserted.
 *
 * @return 0 for success or appropriate error codes on failure.
 */
-static int run_test(project2_ds_type type, int size)
+static int run_test(project2_ds_type type, const int *keys, int size)
 {
 	int ret = 0;
 	project2_handle *handle = NULL;
 
-	if (type >= PROJECT2_LIST && type <= PROJECT2_RBTREE) {
+	if (type >= PROJECT2_LIST && type < PROJECT2_NR_TYPES) {
 		do {
 			/* Get the handle for the test */
 			ret = ds_handle[type].get_handle(&handle);
@@ -81,8 +301,8 @@ static int run_test(project2_ds_type type, int size)
 				break;
 			}
 
-			printk(KERN_INFO "##################################\n");
-			printk(KERN_INFO "Running %s Test Suite\n", ds_handle[type].type);
+			project2_report("##################################\n");
+			project2_report("Running %s Test Suite\n", ds_handle[type].type);
 
 			/* Initialize the context for the test */
 			ret = handle->init(size, &handle->context);
@@ -93,13 +313,14 @@ static int run_test(project2_ds_type type, int size)
 			}
 
 			/* Do not Break if execution failed as deinit is needed */
-			ret = execute_test(handle, size, handle->context);
+			ret = execute_test(handle, keys, size, handle->context,
+								&results[type]);
 
 			handle->deinit(handle->context);
 
 		} while (0);
 
-		printk(KERN_INFO "##################################\n");
+		project2_report("##################################\n");
 
 	/* Free Handle if it was initialized */
 	if (handle)
@@ -109,40 +330,2240 @@ static int run_test(project2_ds_type type, int size)
 }
 
 /**
-* @brief Init function for the module
+* @brief Gets the handle of type without a context, to query its ops
+*
+* @param type Type of the test.
+* @param handle Receives the handle.
 *
 * @return 0 for success or appropriate error codes on failure.
 */
-static int __init project2_init(void)
+int project2_handle_get(project2_ds_type type, project2_handle **handle)
+{
+	return ds_handle[type].get_handle(handle);
+}
+
+/**
+* @brief Frees the handle returned by project2_handle_get
+*
+* @param type Type of the test.
+* @param handle Handle to be freed.
+*/
+void project2_handle_put(project2_ds_type type, project2_handle *handle)
+{
+	ds_handle[type].free_handle(handle);
+}
+
+/**
+* @brief Gets the handle of type and initializes its context
+*
+* @param type Type of the test to be run.
+* @param size Number of integers to be inserted.
+* @param handle Receives the initialized handle.
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+int project2_handle_open(project2_ds_type type, int size,
+						project2_handle **handle)
+{
+	int ret = ds_handle[type].get_handle(handle);
+
+	if (ret)
+		return ret;
+
+	ret = (*handle)->init(size, &(*handle)->context);
+	if (ret) {
+		ds_handle[type].free_handle(*handle);
+		*handle = NULL;
+	}
+
+	return ret;
+}
+
+/**
+* @brief Deinitializes the context and frees the handle of type
+*
+* @param type Type of the test which was run.
+* @param handle Handle returned by project2_handle_open.
+*/
+void project2_handle_close(project2_ds_type type, project2_handle *handle)
+{
+	handle->deinit(handle->context);
+	ds_handle[type].free_handle(handle);
+}
+
+/**
+* @brief Inserts and drains size keys in batches of batch elements
+*
+* @param type Type of the test to be run.
+* @param keys Keys to be inserted.
+* @param out Buffer receiving the removed keys.
+* @param size Number of keys.
+* @param batch Number of keys per batch call.
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int run_batch(project2_ds_type type, const int *keys, int *out,
+							int size, int batch)
+{
+	project2_handle *handle = NULL;
+	project2_hist add_hist;
+	project2_hist remove_hist;
+	u64 add_ns;
+	u64 remove_ns;
+	u64 start;
+	int removed = 0;
+	int ret;
+	int nr;
+	int i;
+
+	ret = project2_handle_open(type, size, &handle);
+	if (ret)
+		return ret;
+
+	project2_hist_init(&add_hist);
+	project2_hist_init(&remove_hist);
+
+	start = ktime_get_ns();
+	for (i = 0; i < size && !ret; i += batch) {
+		u64 call;
+
+		if (project2_yield(i)) {
+			ret = -EINTR;
+			break;
+		}
+
+		call = ktime_get_ns();
+
+		ret = handle->add_batch(handle->context, keys + i,
+						min(batch, size - i));
+		project2_hist_add(&add_hist, ktime_get_ns() - call);
+	}
+	add_ns = ktime_get_ns() - start;
+
+	start = ktime_get_ns();
+	do {
+		u64 call = ktime_get_ns();
+
+		nr = handle->remove_batch(handle->context, out + removed,
+						min(batch, size - removed));
+		project2_hist_add(&remove_hist, ktime_get_ns() - call);
+
+		if (nr > 0)
+			removed += nr;
+
+		project2_yield(removed);
+	} while (nr > 0 && removed < size);
+	remove_ns = ktime_get_ns() - start;
+
+	project2_handle_close(type, handle);
+
+	if (ret)
+		return ret;
+
+	if (nr < 0)
+		return nr;
+
+	project2_report("%-8s %6d %12llu %12llu %10llu %10llu %8d\n",
+			ds_handle[type].type, batch,
+			div_u64(add_ns, size), div_u64(remove_ns, size),
+			project2_hist_percentile(&add_hist, 990),
+			project2_hist_percentile(&remove_hist, 990),
+			removed);
+
+	return removed == size ? 0 : -EIO;
+}
+
+/**
+* @brief Copies size keys into a staging buffer and back out in batches of
+*		batch elements, the bound the batch operations approach
+*
+* @param keys Keys to be copied.
+* @param out Buffer receiving the keys.
+* @param size Number of keys.
+* @param batch Number of keys per memcpy.
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int run_batch_memcpy(const int *keys, int *out, int size, int batch)
+{
+	project2_hist add_hist;
+	project2_hist remove_hist;
+	int *staging;
+	u64 add_ns;
+	u64 remove_ns;
+	u64 start;
+	u64 call;
+	int i;
+
+	staging = kvmalloc_array(size, sizeof(int), GFP_KERNEL);
+	if (staging == NULL)
+		return -ENOMEM;
+
+	project2_hist_init(&add_hist);
+	project2_hist_init(&remove_hist);
+
+	start = ktime_get_ns();
+	for (i = 0; i < size; i += batch) {
+		project2_yield(i);
+
+		call = ktime_get_ns();
+		memcpy(staging + i, keys + i, min(batch, size - i) * sizeof(int));
+		project2_hist_add(&add_hist, ktime_get_ns() - call);
+	}
+	add_ns = ktime_get_ns() - start;
+
+	start = ktime_get_ns();
+	for (i = 0; i < size; i += batch) {
+		project2_yield(i);
+
+		call = ktime_get_ns();
+		memcpy(out + i, staging + i, min(batch, size - i) * sizeof(int));
+		project2_hist_add(&remove_hist, ktime_get_ns() - call);
+	}
+	remove_ns = ktime_get_ns() - start;
+
+	kvfree(staging);
+
+	project2_report("%-8s %6d %12llu %12llu %10llu %10llu %8d\n",
+			"memcpy", batch,
+			div_u64(add_ns, size), div_u64(remove_ns, size),
+			project2_hist_percentile(&add_hist, 990),
+			project2_hist_percentile(&remove_hist, 990),
+			size);
+
+	return 0;
+}
+
+/**
+* @brief Compares batch sizes for every selected handle which implements
+*		the batch operations.
+*
+* @param only Type to be run or PROJECT2_NR_TYPES for all of them.
+* @param size Number of integers to be inserted.
+* @param batch Batch size to be run, 0 for every power of two from 1 to
+*		PROJECT2_MAX_BATCH.
+*/
+static void run_batch_test(int only, int size, int batch)
 {
+	project2_workload_params params = project2_wl_params;
+	project2_workload wl = { 0 };
 	project2_ds_type type;
+	project2_handle *handle = NULL;
+	bool has_batch;
+	int *out;
+	int first = batch ? batch : 1;
+	int last = batch ? batch : PROJECT2_MAX_BATCH;
 
-	printk(KERN_INFO "Starting Project2 for %d integers\n", dstruct_size);
+	// Distinct keys so that keyed structures accept every insert.
+	params.dist = PROJECT2_DIST_UNIQUE;
 
-	/* Error check for <= 0 size */
-	if (dstruct_size <= 0) {
-		printk (KERN_INFO "invalid size %d\n", dstruct_size);
+	out = kvmalloc_array(size, sizeof(int), GFP_KERNEL);
+
+	if (out == NULL || project2_workload_generate(&wl, &params, size, size)) {
+		project2_report("memory allocation for batch test failed\n");
+		goto out;
+	}
+
+	project2_report("##################################\n");
+	project2_report("Batch summary for %d integers, latency in ns\n", size);
+	project2_report("%-8s %6s %12s %12s %10s %10s %8s\n", "DS", "BATCH",
+			"ADD NS/ELEM", "DEL NS/ELEM", "ADD P99", "DEL P99",
+			"REMOVED");
+
+	for (type = PROJECT2_LIST; type < PROJECT2_NR_TYPES; type++) {
+		if (READ_ONCE(project2_stop))
+			break;
+
+		if (only != PROJECT2_NR_TYPES && only != type)
+			continue;
+
+		if (ds_handle[type].get_handle(&handle))
+			continue;
+
+		has_batch = handle->add_batch && handle->remove_batch;
+		ds_handle[type].free_handle(handle);
+
+		if (!has_batch)
+			continue;
+
+		for (batch = first; batch <= last; batch *= 2)
+			if (run_batch(type, wl.keys, out, size, batch))
+				project2_report("%s batch %d failed\n",
+						ds_handle[type].type, batch);
+	}
+
+	// Plain copies of the same batches, the floor of the per element cost.
+	for (batch = first; batch <= last && !READ_ONCE(project2_stop);
+			batch *= 2)
+		if (run_batch_memcpy(wl.keys, out, size, batch))
+			project2_report("memcpy batch %d failed\n", batch);
+
+	project2_report("##################################\n");
+
+out:
+	kvfree(out);
+	project2_workload_free(&wl);
+}
+
+/**
+* @brief Returns the next size of a sweep growing by 10x up to max_size
+*
+* @param size Current size of the sweep.
+* @param max_size Last size of the sweep.
+*
+* @return Next size or 0 once max_size has been reached.
+*/
+static int next_sweep_size(int size, int max_size)
+{
+	if (size >= max_size)
+		return 0;
+
+	return size <= max_size / 10 ? size * 10 : max_size;
+}
+
+/**
+* @brief Callbacks of a benchmark run over growing sizes by run_sweep
+*/
+typedef struct project2_sweep_t {
+	const char *name; /*Name of the benchmark in the reports */
+	void (*header)(void); /*Prints the title and the columns */
+	/*Selects the types the benchmark runs */
+	bool (*accepts)(project2_ds_type type, const project2_handle *handle);
+	/*Sets up more inputs of a size, cleans up itself on failure, optional */
+	int (*prepare)(void *arg, project2_workload *wl, int size);
+	/*Measures one type on the keys of a size */
+	int (*run)(void *arg, project2_ds_type type, const project2_workload *wl,
+								int size);
+	/*Frees what prepare set up, optional */
+	void (*release)(void *arg);
+} project2_sweep;
+
+/**
+* @brief Runs a benchmark for sizes growing by 10x from 1000 up to
+*		max_size, on size distinct keys per size.
+*
+* A failed type is reported and the sweep goes on with the next one.
+*
+* @param sweep Callbacks of the benchmark.
+* @param arg State passed to the callbacks.
+* @param type Type of the test to be run, PROJECT2_NR_TYPES for all.
+* @param max_size Largest number of keys.
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int run_sweep(const project2_sweep *sweep, void *arg,
+				project2_ds_type type, int max_size)
+{
+	project2_workload_params params = project2_wl_params;
+	project2_workload wl = { 0 };
+	project2_handle *handle = NULL;
+	bool accepted[PROJECT2_NR_TYPES];
+	project2_ds_type curr;
+	bool any = false;
+	int size;
+	int ret;
+
+	for (curr = PROJECT2_LIST; curr < PROJECT2_NR_TYPES; curr++) {
+		accepted[curr] = false;
+
+		if (type != PROJECT2_NR_TYPES && type != curr)
+			continue;
+
+		if (ds_handle[curr].get_handle(&handle))
+			continue;
+
+		accepted[curr] = sweep->accepts(curr, handle);
+		ds_handle[curr].free_handle(handle);
+
+		any |= accepted[curr];
+	}
+
+	if (!any) {
+		project2_report("%s bench does not run %s\n", sweep->name,
+					project2_type_name(type));
 		return -EINVAL;
 	}
 
-	project2_list_standalone(dstruct_size);
+	params.dist = PROJECT2_DIST_UNIQUE;
 
-	/* Iterate over all data structures and perform the test
-	* Ignore the errors as we want to run all the test-cases.
-	*/
-	for (type = PROJECT2_LIST; type <= PROJECT2_RBTREE; type++)
-		if (run_test(type, dstruct_size)) {
-			printk (KERN_INFO "%s test failed\n", ds_handle[type].type);
+	project2_report("##################################\n");
+	sweep->header();
+
+	for (size = min(1000, max_size); size;
+			size = next_sweep_size(size, max_size)) {
+		ret = project2_workload_generate(&wl, &params, size,
+						project2_key_range(size));
+		if (!ret && sweep->prepare) {
+			ret = sweep->prepare(arg, &wl, size);
+			if (ret)
+				project2_workload_free(&wl);
+		}
+
+		if (ret) {
+			project2_report("memory allocation for %s test failed\n",
+						sweep->name);
+			return ret;
+		}
+
+		for (curr = PROJECT2_LIST; curr < PROJECT2_NR_TYPES; curr++) {
+			if (!accepted[curr])
+				continue;
+
+			if (sweep->run(arg, curr, &wl, size))
+				project2_report("%s %s of %d failed\n",
+					ds_handle[curr].type, sweep->name, size);
+
+			if (READ_ONCE(project2_stop))
+				break;
 		}
 
+		if (sweep->release)
+			sweep->release(arg);
+
+		project2_workload_free(&wl);
+
+		if (READ_ONCE(project2_stop))
+			return -EINTR;
+	}
+
+	project2_report("##################################\n");
+
 	return 0;
 }
 
 /**
-* @brief Exit function for the module/
+* @brief Fills the structure with keys and times lookups of queries
+*
+* The keys are even, so a query hits if and only if it is even.
+*
+* @param type Type of the test to be run.
+* @param keys Keys to be inserted.
+* @param size Number of keys.
+* @param queries Keys to be looked up.
+* @param nr Number of queries.
+*
+* @return 0 for success or appropriate error codes on failure.
 */
-static void __exit project2_exit(void)
+static int run_lookup(project2_ds_type type, const int *keys, int size,
+							const int *queries, int nr)
+{
+	project2_handle *handle = NULL;
+	u64 budget_ns = (u64)lookup_budget_ms * NSEC_PER_MSEC;
+	u64 elapsed;
+	u64 start;
+	int expected = 0;
+	int hits = 0;
+	int done = 0;
+	int chunk;
+	int ret = 0;
+	int i;
+
+	ret = project2_handle_open(type, size, &handle);
+	if (ret)
+		return ret;
+
+	ret = project2_handle_fill(handle, keys, size);
+	if (ret)
+		goto out;
+
+	// Settle lazily built structures outside of the timed region.
+	handle->lookup(handle->context, keys[0]);
+
+	start = ktime_get_ns();
+	do {
+		chunk = min(done + 1024, nr);
+
+		for (; done < chunk; done++)
+			hits += handle->lookup(handle->context, queries[done]);
+
+		elapsed = ktime_get_ns() - start;
+
+		if (project2_yield(done)) {
+			ret = -EINTR;
+			goto out;
+		}
+	} while (done < nr && elapsed < budget_ns);
+
+	for (i = 0; i < done; i++)
+		expected += !(queries[i] & 1);
+
+	project2_report("%-8s %10d %4d%% %10d %10llu %12llu %s\n",
+			ds_handle[type].type, size, hit_ratio, done,
+			div_u64(elapsed, done),
+			elapsed ? div64_u64((u64)done * USEC_PER_SEC, elapsed) : 0,
+			hits == expected ? "ok" : "MISMATCH");
+
+	if (hits != expected)
+		ret = -EIO;
+
+out:
+	handle->remove(handle->context, NULL);
+	project2_handle_close(type, handle);
+
+	return ret;
+}
+
+/**
+* @brief Measures the lookups of every handle for sizes growing by 10x
+*		from 1000 up to max_size.
+*
+* @param max_size Largest number of integers to be inserted.
+*/
+static void run_lookup_test(int max_size)
 {
+	project2_workload_params params = project2_wl_params;
+	project2_workload wl = { 0 };
+	project2_ds_type type;
+	project2_handle *handle = NULL;
+	bool has_lookup;
+	int *queries;
+	int size;
+	int i;
+
+	params.dist = PROJECT2_DIST_UNIQUE;
+
+	queries = kvmalloc_array(nr_lookups, sizeof(int), GFP_KERNEL);
+
+	if (queries == NULL) {
+		project2_report("memory allocation for lookup test failed\n");
+		goto out;
+	}
+
+	project2_report("##################################\n");
+	project2_report("Lookup summary, latency in ns\n");
+	project2_report("%-8s %10s %5s %10s %10s %12s %s\n", "DS", "SIZE",
+			"HIT", "LOOKUPS", "NS/LOOKUP", "KLOOKUPS/S", "CHECK");
+
+	for (type = PROJECT2_LIST; type < PROJECT2_NR_TYPES; type++) {
+		if (READ_ONCE(project2_stop))
+			break;
+
+		if (ds_handle[type].get_handle(&handle))
+			continue;
+
+		has_lookup = handle->lookup && handle->add_batch;
+		ds_handle[type].free_handle(handle);
+
+		if (!has_lookup)
+			continue;
+
+		for (size = min(1000, max_size); size;
+				size = next_sweep_size(size, max_size)) {
+			if (project2_workload_generate(&wl, &params, size, size)) {
+				project2_report("memory allocation for lookup test failed\n");
+				break;
+			}
+
+			for (i = 0; i < size; i++)
+				wl.keys[i] *= 2;
+
+			// Hits pick an inserted key, misses the odd key next to one.
+			for (i = 0; i < nr_lookups; i++) {
+				if (prandom_u32_state(&wl.rnd) % 100 < hit_ratio)
+					queries[i] = wl.keys[prandom_u32_state(&wl.rnd) % size];
+				else
+					queries[i] = 2 * (prandom_u32_state(&wl.rnd) % size) + 1;
+			}
+
+			if (run_lookup(type, wl.keys, size, queries, nr_lookups))
+				project2_report("%s lookup of %d failed\n",
+						ds_handle[type].type, size);
+
+			project2_workload_free(&wl);
+		}
+	}
+
+	project2_report("##################################\n");
+
+out:
+	kvfree(queries);
+}
+
+/**
+* @brief Returns the number of free pages of the system
+*
+* The slab and vmalloc pages of a structure come out of this count, so
+* the drop over a fill approximates its footprint. The per-CPU page
+* lists and other activity add noise of a few pages.
+*/
+static long project2_free_pages(void)
+{
+	return global_zone_page_state(NR_FREE_PAGES);
+}
+
+/**
+* @brief Id workloads of the idmap bench, the id modes followed by churn
+*/
+#define PROJECT2_IDMAP_CHURN PROJECT2_NR_ID_MODES
+
+/**
+* @brief Names of the idmap workloads indexed by project2_id_mode, churn last
+*/
+static const char * const idmap_names[] = {
+	"dense",
+	"cyclic",
+	"sparse",
+	"churn"
+};
+
+/**
+* @brief Allocates size ids, looks every id up, iterates and destroys the
+*		structure, timing each phase
+*
+* The churn workload allocates cyclic ids and then, size times, removes
+* the oldest id and allocates a new one, which moves the live ids from
+* [0, size) to [size, 2 * size).
+*
+* @param type Type of the test to be run.
+* @param mode project2_id_mode or PROJECT2_IDMAP_CHURN.
+* @param keys Values to be stored, the ids themselves in the sparse mode.
+* @param size Number of ids.
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int run_idmap(project2_ds_type type, int mode, const int *keys,
+								int size)
+{
+	project2_handle *handle = NULL;
+	u64 insert_ns;
+	u64 churn_ns = 0;
+	u64 lookup_ns = 0;
+	u64 iterate_ns = 0;
+	u64 destroy_ns;
+	u64 start;
+	long pages;
+	int base = 0;
+	int hits = 0;
+	int key;
+	int ret;
+	int i;
+
+	project2_id_alloc = mode == PROJECT2_IDMAP_CHURN ? PROJECT2_ID_CYCLIC :
+								mode;
+
+	pages = project2_free_pages();
+	start = ktime_get_ns();
+
+	ret = project2_handle_open(type, size, &handle);
+	project2_id_alloc = PROJECT2_ID_DENSE;
+
+	if (ret)
+		return ret;
+
+	// Fresh dense and cyclic ids are allocated lowest first, 0..size-1.
+	ret = handle->add(handle->context, keys, size, NULL);
+
+	insert_ns = ktime_get_ns() - start;
+
+	if (ret)
+		goto out;
+
+	if (mode == PROJECT2_IDMAP_CHURN) {
+		start = ktime_get_ns();
+
+		for (i = 0; i < size && !ret; i++) {
+			if (handle->remove_batch(handle->context, &key, 1) != 1)
+				ret = -ENOENT;
+			else
+				ret = handle->add(handle->context, &key, 1, NULL);
+
+			if (project2_yield(i))
+				ret = -EINTR;
+		}
+
+		churn_ns = ktime_get_ns() - start;
+		base = size;
+
+		if (ret)
+			goto out;
+	}
+
+	pages -= project2_free_pages();
+
+	start = ktime_get_ns();
+
+	for (i = 0; i < size; i++) {
+		hits += handle->lookup(handle->context,
+				mode == PROJECT2_ID_SPARSE ? keys[i] : base + i);
+
+		if (project2_yield(i)) {
+			ret = -EINTR;
+			goto out;
+		}
+	}
+
+	lookup_ns = ktime_get_ns() - start;
+
+	start = ktime_get_ns();
+	handle->iterate(handle->context, NULL);
+	iterate_ns = ktime_get_ns() - start;
+
+out:
+	start = ktime_get_ns();
+	handle->remove(handle->context, NULL);
+	project2_handle_close(type, handle);
+	destroy_ns = ktime_get_ns() - start;
+
+	if (ret)
+		return ret;
+
+	project2_report("%-8s %-6s %10d %10llu %10llu %10llu %10llu %10llu %10ld %s\n",
+			ds_handle[type].type, idmap_names[mode], size,
+			div_u64(insert_ns, size), div_u64(churn_ns, size),
+			div_u64(lookup_ns, size), div_u64(iterate_ns, size),
+			div_u64(destroy_ns, size), pages * (long)PAGE_SIZE / size,
+			hits == size ? "ok" : "MISMATCH");
+
+	return hits == size ? 0 : -EIO;
+}
+
+/**
+* @brief Values of every id workload of the current size of the idmap bench
+*/
+typedef struct project2_idmap_sweep_t {
+	project2_workload wl[PROJECT2_IDMAP_CHURN + 1];
+} project2_idmap_sweep;
+
+/**
+* @brief Prints the title and the columns of the idmap bench
+*/
+static void header_idmap(void)
+{
+	project2_report("ID map summary, latency in ns per element, memory approximate\n");
+	project2_report("%-8s %-6s %10s %10s %10s %10s %10s %10s %10s %s\n",
+			"DS", "MODE", "SIZE", "INSERT", "CHURN", "LOOKUP",
+			"ITERATE", "DESTROY", "B/ENTRY", "CHECK");
+}
+
+/**
+* @brief The idmap bench compares the IDR map against the xarray
+*/
+static bool accepts_idmap(project2_ds_type type, const project2_handle *handle)
+{
+	return type == PROJECT2_MAP || type == PROJECT2_XARRAY;
+}
+
+/**
+* @brief Frees the id workloads of the current size
+*
+* @param arg project2_idmap_sweep
+*/
+static void release_idmap(void *arg)
+{
+	project2_idmap_sweep *idmap = arg;
+	int mode;
+
+	for (mode = 0; mode <= PROJECT2_IDMAP_CHURN; mode++)
+		project2_workload_free(&idmap->wl[mode]);
+}
+
+/**
+* @brief Generates the values of every id workload for size ids
+*
+* @param arg project2_idmap_sweep
+* @param wl Keys of the sweep, not used by the id workloads
+* @param size Number of ids
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int prepare_idmap(void *arg, project2_workload *wl, int size)
+{
+	project2_workload_params params = project2_wl_params;
+	project2_idmap_sweep *idmap = arg;
+	int mode;
+	int ret;
+
+	params.dist = PROJECT2_DIST_UNIQUE;
+
+	for (mode = 0; mode <= PROJECT2_IDMAP_CHURN; mode++) {
+		// Sparse keys are spread over the whole 31-bit id space.
+		ret = project2_workload_generate(&idmap->wl[mode], &params, size,
+				mode == PROJECT2_ID_SPARSE ? INT_MAX : size);
+		if (ret) {
+			release_idmap(arg);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/**
+* @brief Runs every id workload of the current size on type
+*
+* @param arg project2_idmap_sweep
+* @param type PROJECT2_MAP or PROJECT2_XARRAY
+* @param wl Keys of the sweep, not used by the id workloads
+* @param size Number of ids
+*
+* @return 0, a failed workload is reported and the next one runs
+*/
+static int sweep_idmap(void *arg, project2_ds_type type,
+				const project2_workload *wl, int size)
+{
+	project2_idmap_sweep *idmap = arg;
+	int mode;
+
+	for (mode = 0; mode <= PROJECT2_IDMAP_CHURN; mode++) {
+		if (run_idmap(type, mode, idmap->wl[mode].keys, size))
+			project2_report("%s %s idmap of %d failed\n",
+					ds_handle[type].type, idmap_names[mode], size);
+
+		if (READ_ONCE(project2_stop))
+			break;
+	}
+
+	return 0;
+}
+
+/**
+* @brief Sweep of the idmap bench
+*/
+static const project2_sweep idmap_sweep = {
+	.name = "idmap",
+	.header = header_idmap,
+	.accepts = accepts_idmap,
+	.prepare = prepare_idmap,
+	.run = sweep_idmap,
+	.release = release_idmap,
+};
+
+/**
+* @brief Compares the IDR map against the xarray for every id workload and
+*		sizes growing by 10x from 1000 up to cfg->size.
+*
+* @param cfg Configuration of the run, type MAP, XARRAY or all of them.
+* @param params Parameters of the workload, the ids are always distinct.
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int run_idmap_test(const project2_config *cfg,
+				const project2_workload_params *params)
+{
+	project2_idmap_sweep idmap = { 0 };
+
+	return run_sweep(&idmap_sweep, &idmap, cfg->type, cfg->size);
+}
+
+/**
+* @brief Runs the hold model on a prefilled priority queue: nr times the
+*		smallest key is popped and reinserted a random distance later.
+*
+* The queue keeps its size, and the popped keys never decrease.
+*
+* @param type Type of the test to be run.
+* @param keys Keys to be prefilled.
+* @param size Number of keys.
+* @param incs Distances of the reinserted keys, at least 0.
+* @param nr Number of pop-min and insert pairs.
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int run_hold(project2_ds_type type, const int *keys, int size,
+						const int *incs, int nr)
+{
+	project2_handle *handle = NULL;
+	bool ordered = true;
+	u64 peek_ns;
+	u64 hold_ns;
+	u64 start;
+	int last = INT_MIN;
+	int key;
+	int ret;
+	int i;
+
+	ret = project2_handle_open(type, size, &handle);
+	if (ret)
+		return ret;
+
+	ret = project2_handle_fill(handle, keys, size);
+	if (ret)
+		goto out;
+
+	start = ktime_get_ns();
+
+	for (i = 0; i < nr && !ret; i++)
+		ret = handle->peek_min(handle->context, &key);
+
+	peek_ns = ktime_get_ns() - start;
+
+	if (ret)
+		goto out;
+
+	start = ktime_get_ns();
+
+	for (i = 0; i < nr; i++) {
+		ret = handle->pop_min(handle->context, &key);
+		if (ret)
+			break;
+
+		ordered &= key >= last;
+		last = key;
+
+		if (key > INT_MAX - incs[i] - 1) {
+			ret = -ERANGE;
+			break;
+		}
+
+		// The tree keeps unique keys, move on to the next free one.
+		key += incs[i] + 1;
+		while ((ret = handle->add_batch(handle->context, &key, 1)) ==
+					-EEXIST && key < INT_MAX)
+			key++;
+
+		if (ret)
+			break;
+
+		if (project2_yield(i)) {
+			ret = -EINTR;
+			break;
+		}
+	}
+
+	hold_ns = ktime_get_ns() - start;
+
+	if (ret)
+		goto out;
+
+	project2_report("%-14s %10d %10d %10llu %10llu %12llu %s\n",
+			ds_handle[type].type, size, nr, div_u64(peek_ns, nr),
+			div_u64(hold_ns, nr),
+			hold_ns ? div64_u64((u64)nr * USEC_PER_SEC, hold_ns) : 0,
+			ordered ? "ok" : "MISMATCH");
+
+	if (!ordered)
+		ret = -EIO;
+
+out:
+	handle->remove(handle->context, NULL);
+	project2_handle_close(type, handle);
+
+	return ret;
+}
+
+/**
+* @brief Distances of the reinserted keys for the current size of the hold
+*		bench
+*/
+typedef struct project2_hold_sweep_t {
+	project2_workload incs;
+} project2_hold_sweep;
+
+/**
+* @brief Prints the title and the columns of the hold bench
+*/
+static void header_hold(void)
+{
+	project2_report("Hold model summary, latency in ns\n");
+	project2_report("%-14s %10s %10s %10s %10s %12s %s\n", "DS", "SIZE",
+			"HOLDS", "NS/PEEK", "NS/HOLD", "KHOLDS/S", "CHECK");
+}
+
+/**
+* @brief The hold bench runs the priority queues
+*/
+static bool accepts_hold(project2_ds_type type, const project2_handle *handle)
+{
+	return handle->peek_min && handle->pop_min && handle->add_batch;
+}
+
+/**
+* @brief Generates the distances of the nr_ops holds of the current size
+*
+* @param arg project2_hold_sweep
+* @param wl Keys prefilled into the queues
+* @param size Number of keys
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int prepare_hold(void *arg, project2_workload *wl, int size)
+{
+	project2_workload_params params = project2_wl_params;
+	project2_hold_sweep *hold = arg;
+
+	params.dist = PROJECT2_DIST_UNIFORM;
+
+	return project2_workload_generate(&hold->incs, &params, nr_ops,
+						project2_key_range(size));
+}
+
+/**
+* @brief Frees the distances of the current size
+*
+* @param arg project2_hold_sweep
+*/
+static void release_hold(void *arg)
+{
+	project2_hold_sweep *hold = arg;
+
+	project2_workload_free(&hold->incs);
+}
+
+/**
+* @brief Runs the nr_ops holds of the current size on type
+*
+* @param arg project2_hold_sweep
+* @param type Type of the test to be run.
+* @param wl Keys prefilled into the queue
+* @param size Number of keys
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int sweep_hold(void *arg, project2_ds_type type,
+				const project2_workload *wl, int size)
+{
+	project2_hold_sweep *hold = arg;
+
+	return run_hold(type, wl->keys, size, hold->incs.keys, nr_ops);
+}
+
+/**
+* @brief Sweep of the hold bench
+*/
+static const project2_sweep hold_sweep = {
+	.name = "hold",
+	.header = header_hold,
+	.accepts = accepts_hold,
+	.prepare = prepare_hold,
+	.run = sweep_hold,
+	.release = release_hold,
+};
+
+/**
+* @brief Measures the hold model of every priority queue for sizes growing
+*		by 10x from 1000 up to cfg->size.
+*
+* @param cfg Configuration of the run
+* @param params Parameters of the workload, the keys are always distinct.
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int run_hold_test(const project2_config *cfg,
+				const project2_workload_params *params)
+{
+	project2_hold_sweep hold = { 0 };
+
+	return run_sweep(&hold_sweep, &hold, cfg->type, cfg->size);
+}
+
+/**
+* @brief Inserts size distinct keys one by one, runs rank and select on
+*		the full tree when the type has them and erases the keys one by
+*		one again, timing each phase.
+*
+* @param type Type of the test to be run.
+* @param keys Distinct keys to be inserted.
+* @param size Number of keys.
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int run_ostat(project2_ds_type type, const int *keys, int size)
+{
+	project2_handle *handle = NULL;
+	bool ok = true;
+	u64 insert_ns;
+	u64 rank_ns = 0;
+	u64 select_ns = 0;
+	u64 erase_ns;
+	u64 rank_sum = 0;
+	u64 start;
+	int last = INT_MIN;
+	int key;
+	int ret;
+	int i;
+
+	ret = project2_handle_open(type, size, &handle);
+	if (ret)
+		return ret;
+
+	start = ktime_get_ns();
+	ret = handle->add(handle->context, keys, size, NULL);
+	insert_ns = ktime_get_ns() - start;
+
+	if (ret)
+		goto out;
+
+	if (handle->rank && handle->select) {
+		start = ktime_get_ns();
+
+		for (i = 0; i < size; i++) {
+			rank_sum += handle->rank(handle->context, keys[i]);
+			project2_yield(i);
+		}
+
+		rank_ns = ktime_get_ns() - start;
+
+		start = ktime_get_ns();
+
+		for (i = 0; i < size; i++) {
+			ok &= !handle->select(handle->context, i, &key) &&
+								key > last;
+			last = key;
+			project2_yield(i);
+		}
+
+		select_ns = ktime_get_ns() - start;
+
+		// Distinct keys have the ranks 0..size-1, each exactly once.
+		ok &= rank_sum == (u64)size * (size - 1) / 2;
+	}
+
+	start = ktime_get_ns();
+
+	for (i = 0; i < size && ok; i++) {
+		ok &= handle->remove_range(handle->context, keys[i], keys[i]) == 1;
+
+		if (project2_yield(i)) {
+			ret = -EINTR;
+			break;
+		}
+	}
+
+	erase_ns = ktime_get_ns() - start;
+
+	if (ret)
+		goto out;
+
+	project2_report("%-14s %10d %10llu %10llu %10llu %10llu %s\n",
+			ds_handle[type].type, size, div_u64(insert_ns, size),
+			div_u64(erase_ns, size), div_u64(rank_ns, size),
+			div_u64(select_ns, size), ok ? "ok" : "MISMATCH");
+
+	if (!ok)
+		ret = -EIO;
+
+out:
+	handle->remove(handle->context, NULL);
+	project2_handle_close(type, handle);
+
+	return ret;
+}
+
+/**
+* @brief Prints the title and the columns of the ostat bench
+*/
+static void header_ostat(void)
+{
+	project2_report("Order statistics summary, latency in ns per element\n");
+	project2_report("%-14s %10s %10s %10s %10s %10s %s\n", "DS", "SIZE",
+			"INSERT", "ERASE", "RANK", "SELECT", "CHECK");
+}
+
+/**
+* @brief The ostat bench compares the order statistics tree against the
+*		plain rbtree
+*/
+static bool accepts_ostat(project2_ds_type type, const project2_handle *handle)
+{
+	return type == PROJECT2_RBTREE || type == PROJECT2_OSTREE;
+}
+
+/**
+* @brief Runs the insert, rank, select and erase phases on type
+*
+* @param arg Not used
+* @param type PROJECT2_RBTREE or PROJECT2_OSTREE
+* @param wl Keys to be inserted
+* @param size Number of keys
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int sweep_ostat(void *arg, project2_ds_type type,
+				const project2_workload *wl, int size)
+{
+	return run_ostat(type, wl->keys, size);
+}
+
+/**
+* @brief Sweep of the ostat bench
+*/
+static const project2_sweep ostat_sweep = {
+	.name = "ostat",
+	.header = header_ostat,
+	.accepts = accepts_ostat,
+	.run = sweep_ostat,
+};
+
+/**
+* @brief Measures the cost of the subtree sizes of the order statistics
+*		tree against the plain rbtree for sizes growing by 10x from 1000
+*		up to cfg->size.
+*
+* @param cfg Configuration of the run, type RBTREE, OSTREE or all of them.
+* @param params Parameters of the workload, the keys are always distinct.
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int run_ostat_test(const project2_config *cfg,
+				const project2_workload_params *params)
+{
+	return run_sweep(&ostat_sweep, NULL, cfg->type, cfg->size);
+}
+
+/**
+* @brief Ways of loading the keys compared by the build bench
+*/
+enum {
+	PROJECT2_LOAD_ADD = 0x0, /*add, one descent per key in random order */
+	PROJECT2_LOAD_BATCH, /*add_batch, sorted chunks with a hint */
+	PROJECT2_LOAD_BUILD, /*build from the whole sorted array */
+	PROJECT2_NR_LOADS
+};
+
+/**
+* @brief Names of the ways of loading indexed by PROJECT2_LOAD_*
+*/
+static const char * const load_names[] = {
+	"add",
+	"batch",
+	"build"
+};
+
+/**
+* @brief Loads the keys in one of the PROJECT2_LOAD_* ways, then times
+*		lookups of queries and counts their cache misses
+*
+* @param type Type of the test to be run.
+* @param load PROJECT2_LOAD_* way of loading the keys.
+* @param keys Keys in random order.
+* @param sorted The same keys in increasing order.
+* @param size Number of keys.
+* @param queries Keys to be looked up, all of them present.
+* @param nr Number of queries.
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int run_build(project2_ds_type type, int load, const int *keys,
+			const int *sorted, int size, const int *queries, int nr)
+{
+	project2_handle *handle = NULL;
+	project2_llc llc;
+	u64 load_ns;
+	u64 lookup_ns;
+	u64 misses;
+	u64 start;
+	u32 frac;
+	int hits = 0;
+	int ret;
+	int i;
+
+	ret = project2_handle_open(type, size, &handle);
+	if (ret)
+		return ret;
+
+	start = ktime_get_ns();
+
+	if (load == PROJECT2_LOAD_ADD)
+		ret = handle->add(handle->context, keys, size, NULL);
+	else if (load == PROJECT2_LOAD_BATCH)
+		ret = project2_handle_fill(handle, keys, size);
+	else
+		ret = handle->build(handle->context, sorted, size);
+
+	// Read-only layouts are sorted by their first lookup, charge it here.
+	if (!ret && (handle->flags & PROJECT2_HANDLE_LOOKUP_WRITES))
+		handle->lookup(handle->context, sorted[0]);
+
+	load_ns = ktime_get_ns() - start;
+
+	if (ret)
+		goto out;
+
+	// Without a PMU counter the misses read as 0, the timings still count.
+	project2_llc_open(&llc);
+	misses = project2_llc_read(&llc);
+
+	start = ktime_get_ns();
+
+	for (i = 0; i < nr; i++) {
+		hits += handle->lookup(handle->context, queries[i]);
+
+		if (project2_yield(i)) {
+			ret = -EINTR;
+			break;
+		}
+	}
+
+	lookup_ns = ktime_get_ns() - start;
+	misses = project2_llc_read(&llc) - misses;
+
+	project2_llc_close(&llc);
+
+	if (ret)
+		goto out;
+
+	// Misses per lookup with two decimals.
+	misses = div_u64(misses * 100, nr);
+
+	misses = div_u64_rem(misses, 100, &frac);
+
+	project2_report("%-14s %-6s %10d %10llu %10llu %7llu.%02u %s\n",
+			ds_handle[type].type, load_names[load], size,
+			div_u64(load_ns, size), div_u64(lookup_ns, nr),
+			misses, frac,
+			hits == nr ? "ok" : "MISMATCH");
+
+	if (hits != nr)
+		ret = -EIO;
+
+out:
+	handle->remove(handle->context, NULL);
+	project2_handle_close(type, handle);
+
+	return ret;
+}
+
+/**
+* @brief Inputs of the current size of the build bench
+*/
+typedef struct project2_build_sweep_t {
+	int *sorted; /*Keys of the size in increasing order */
+	int *queries; /*nr_lookups keys of the size, for every size */
+} project2_build_sweep;
+
+/**
+* @brief Prints the title and the columns of the build bench
+*/
+static void header_build(void)
+{
+	project2_report("Build summary, latency in ns\n");
+	project2_report("%-14s %-6s %10s %10s %10s %10s %s\n", "DS", "LOAD",
+			"SIZE", "NS/KEY", "NS/LOOKUP", "MISS/LOOKUP", "CHECK");
+}
+
+/**
+* @brief The build bench runs the types which build from sorted keys
+*/
+static bool accepts_build(project2_ds_type type, const project2_handle *handle)
+{
+	return handle->build && handle->lookup && handle->add_batch;
+}
+
+/**
+* @brief Sorts the keys of the current size and draws the queries from them
+*
+* @param arg project2_build_sweep
+* @param wl Keys of the size, its random state draws the queries
+* @param size Number of keys
+*
+* @return 0 for success or -ENOMEM in failure.
+*/
+static int prepare_build(void *arg, project2_workload *wl, int size)
+{
+	project2_build_sweep *build = arg;
+	int i;
+
+	build->sorted = kvmalloc_array(size, sizeof(int), GFP_KERNEL);
+	if (build->sorted == NULL)
+		return -ENOMEM;
+
+	memcpy(build->sorted, wl->keys, size * sizeof(int));
+	sort(build->sorted, size, sizeof(int), project2_cmp_int, NULL);
+
+	for (i = 0; i < nr_lookups; i++)
+		build->queries[i] = wl->keys[prandom_u32_state(&wl->rnd) % size];
+
+	return 0;
+}
+
+/**
+* @brief Frees the sorted keys of the current size
+*
+* @param arg project2_build_sweep
+*/
+static void release_build(void *arg)
+{
+	project2_build_sweep *build = arg;
+
+	kvfree(build->sorted);
+	build->sorted = NULL;
+}
+
+/**
+* @brief Loads type in every PROJECT2_LOAD_* way and times the lookups
+*
+* @param arg project2_build_sweep
+* @param type Type of the test to be run.
+* @param wl Keys of the size in random order
+* @param size Number of keys
+*
+* @return 0, a failed load is reported and the next one runs
+*/
+static int sweep_build(void *arg, project2_ds_type type,
+				const project2_workload *wl, int size)
+{
+	project2_build_sweep *build = arg;
+	int load;
+
+	for (load = 0; load < PROJECT2_NR_LOADS; load++) {
+		if (run_build(type, load, wl->keys, build->sorted, size,
+					build->queries, nr_lookups))
+			project2_report("%s %s of %d failed\n",
+					ds_handle[type].type, load_names[load], size);
+
+		if (READ_ONCE(project2_stop))
+			break;
+	}
+
+	return 0;
+}
+
+/**
+* @brief Sweep of the build bench
+*/
+static const project2_sweep build_sweep = {
+	.name = "build",
+	.header = header_build,
+	.accepts = accepts_build,
+	.prepare = prepare_build,
+	.run = sweep_build,
+	.release = release_build,
+};
+
+/**
+* @brief Compares building the trees from sorted keys with inserting the
+*		keys, for sizes growing by 10x from 1000 up to cfg->size.
+*
+* @param cfg Configuration of the run
+* @param params Parameters of the workload, the keys are always distinct.
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int run_build_test(const project2_config *cfg,
+				const project2_workload_params *params)
+{
+	project2_build_sweep build = { 0 };
+	int ret;
+
+	build.queries = kvmalloc_array(nr_lookups, sizeof(int), GFP_KERNEL);
+	if (build.queries == NULL) {
+		project2_report("memory allocation for build test failed\n");
+		return -ENOMEM;
+	}
+
+	ret = run_sweep(&build_sweep, &build, cfg->type, cfg->size);
+
+	kvfree(build.queries);
+
+	return ret;
+}
+
+/**
+* @brief Fills the list, iterates over it and frees it, timing each phase
+*		and measuring the footprint per element
+*
+* The iteration adds up the values with the sum op, so that every value is
+* read, and runs over the whole list passes times, so that each size
+* iterates about nr_ops elements.
+*
+* @param type Type of the test to be run.
+* @param keys Keys to be appended.
+* @param size Number of keys.
+* @param passes Number of iterations over the list.
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int run_iter(project2_ds_type type, const int *keys, int size,
+								int passes)
+{
+	project2_handle *handle = NULL;
+	s64 expected = 0;
+	s64 sum = 0;
+	u64 add_ns;
+	u64 iterate_ns = 0;
+	u64 free_ns;
+	u64 bandwidth;
+	u64 start;
+	u32 frac;
+	long pages;
+	int ret;
+	int i;
+
+	pages = project2_free_pages();
+
+	ret = project2_handle_open(type, size, &handle);
+	if (ret)
+		return ret;
+
+	start = ktime_get_ns();
+	ret = project2_handle_fill(handle, keys, size);
+	add_ns = ktime_get_ns() - start;
+
+	pages -= project2_free_pages();
+
+	if (ret)
+		goto out;
+
+	for (i = 0; i < size; i++)
+		expected += keys[i];
+
+	for (i = 0; i < passes; i++) {
+		start = ktime_get_ns();
+		sum = handle->sum(handle->context);
+		iterate_ns += ktime_get_ns() - start;
+
+		if (READ_ONCE(project2_stop)) {
+			ret = -EINTR;
+			goto out;
+		}
+	}
+
+out:
+	start = ktime_get_ns();
+	handle->remove(handle->context, NULL);
+	free_ns = ktime_get_ns() - start;
+
+	project2_handle_close(type, handle);
+
+	if (ret)
+		return ret;
+
+	// Bytes of values read per ns are GB/s, kept with two decimals.
+	bandwidth = div64_u64((u64)size * passes * sizeof(int) * 100,
+						max_t(u64, iterate_ns, 1));
+
+	bandwidth = div_u64_rem(bandwidth, 100, &frac);
+
+	project2_report("%-8s %10d %10llu %7llu.%02u %10ld %10llu %s\n",
+			ds_handle[type].type, size, div_u64(add_ns, size),
+			bandwidth, frac,
+			pages * (long)PAGE_SIZE / size, div_u64(free_ns, size),
+			sum == expected ? "ok" : "MISMATCH");
+
+	return sum == expected ? 0 : -EIO;
+}
+
+/**
+* @brief Prints the title and the columns of the iter bench
+*/
+static void header_iter(void)
+{
+	project2_report("Iteration summary, latency in ns per element, memory approximate\n");
+	project2_report("%-8s %10s %10s %10s %10s %10s %s\n", "DS", "SIZE",
+			"ADD", "GB/S", "B/ELEM", "FREE", "CHECK");
+}
+
+/**
+* @brief The iter bench runs the types which add up their values, the
+*		list and the unrolled list
+*/
+static bool accepts_iter(project2_ds_type type, const project2_handle *handle)
+{
+	return handle->sum;
+}
+
+/**
+* @brief Iterates about nr_ops elements of type over the current size
+*
+* @param arg Not used
+* @param type Type of the test to be run.
+* @param wl Keys to be appended
+* @param size Number of keys
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int sweep_iter(void *arg, project2_ds_type type,
+				const project2_workload *wl, int size)
+{
+	return run_iter(type, wl->keys, size, max(1, nr_ops / size));
+}
+
+/**
+* @brief Sweep of the iter bench
+*/
+static const project2_sweep iter_sweep = {
+	.name = "iter",
+	.header = header_iter,
+	.accepts = accepts_iter,
+	.run = sweep_iter,
+};
+
+/**
+* @brief Compares the unrolled list against the list on iteration bandwidth
+*		and footprint, for sizes growing by 10x from 1000 up to cfg->size.
+*
+* @param cfg Configuration of the run, type LIST, ULIST or all of them.
+* @param params Parameters of the workload, the keys are always distinct.
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int run_iter_test(const project2_config *cfg,
+				const project2_workload_params *params)
+{
+	return run_sweep(&iter_sweep, NULL, cfg->type, cfg->size);
+}
+
+/**
+* @brief Names of the ops indexed by project2_op
+*/
+static const char * const op_names[] = {
+	"insert",
+	"lookup",
+	"delete"
+};
+
+/**
+* @brief Inserts size keys through add_batch in PROJECT2_MAX_BATCH chunks
+*
+* @param handle Handle of the data structure
+* @param keys Keys to be inserted
+* @param size Number of keys
+*
+* @return 0 for success, keys already present are not an error, or
+*		appropriate error code on failure.
+*/
+int project2_handle_fill(project2_handle *handle, const int *keys, int size)
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < size && (!ret || ret == -EEXIST);
+			i += PROJECT2_MAX_BATCH) {
+		if (project2_yield(i))
+			return -EINTR;
+
+		ret = handle->add_batch(handle->context, keys + i,
+						min(PROJECT2_MAX_BATCH, size - i));
+	}
+
+	return ret == -EEXIST ? 0 : ret;
+}
+
+/**
+* @brief Applies one op of a mixed workload to the handle
+*
+* Inserts of a present key succeed. Deletes erase the key where
+* remove_range is offered and pop the oldest/smallest key otherwise.
+*
+* @param handle Handle of the data structure
+* @param op project2_op to be applied
+* @param key Key of the op
+*
+* @return 0 or positive for success, -EOPNOTSUPP if the handle has no
+*		lookup or appropriate error code on failure.
+*/
+int project2_apply_op(project2_handle *handle, int op, int key)
+{
+	int ret;
+
+	switch (op) {
+	case PROJECT2_OP_INSERT:
+		ret = handle->add_batch(handle->context, &key, 1);
+		return ret == -EEXIST ? 0 : ret;
+
+	case PROJECT2_OP_LOOKUP:
+		if (!handle->lookup)
+			return -EOPNOTSUPP;
+
+		return handle->lookup(handle->context, key);
+
+	case PROJECT2_OP_DELETE:
+		if (handle->remove_range)
+			return handle->remove_range(handle->context, key, key);
+
+		return handle->remove_batch(handle->context, &key, 1);
+	}
+
+	return -EINVAL;
+}
+
+/**
+* @brief Prefills the structure and runs the ops of the workload on it
+*
+* Lookups are skipped by structures without lookup.
+*
+* @param type Type of the test to be run.
+* @param prefill Keys inserted before the ops.
+* @param size Number of prefilled keys.
+* @param wl Ops and keys to be run.
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int run_mixed(project2_ds_type type, const int *prefill,
+					int size, const project2_workload *wl)
+{
+	project2_handle *handle = NULL;
+	project2_hist hists[PROJECT2_NR_OPS];
+	int skipped = 0;
+	int key;
+	int ret;
+	int op;
+	int i;
+	u64 start;
+
+	ret = project2_handle_open(type, size + wl->nr, &handle);
+	if (ret)
+		return ret;
+
+	ret = project2_handle_fill(handle, prefill, size);
+	if (ret)
+		goto out;
+
+	for (op = 0; op < PROJECT2_NR_OPS; op++)
+		project2_hist_init(&hists[op]);
+
+	for (i = 0; i < wl->nr && ret >= 0; i++) {
+		if (project2_yield(i)) {
+			ret = -EINTR;
+			break;
+		}
+
+		key = wl->keys[i];
+		op = wl->ops[i];
+
+		if (op == PROJECT2_OP_LOOKUP && !handle->lookup) {
+			skipped++;
+			continue;
+		}
+
+		start = ktime_get_ns();
+
+		ret = project2_apply_op(handle, op, key);
+
+		project2_hist_add(&hists[op], ktime_get_ns() - start);
+	}
+
+	if (ret < 0)
+		goto out;
+
+	ret = 0;
+
+	project2_hist_print_header();
+
+	for (op = 0; op < PROJECT2_NR_OPS; op++)
+		if (hists[op].count)
+			project2_hist_print(ds_handle[type].type, op_names[op],
+						&hists[op], hists[op].sum_ns);
+
+	if (skipped)
+		project2_report("%s has no lookup, skipped %d lookups\n",
+				ds_handle[type].type, skipped);
+
+	if (handle->report)
+		handle->report(handle->context);
+
+out:
+	handle->remove(handle->context, NULL);
+	project2_handle_close(type, handle);
+
+	return ret;
+}
+
+/**
+* @brief Runs the op mix of the workload parameters on every handle which
+*		implements the batch operations, prefilled with size keys.
+*
+* @param size Number of prefilled keys.
+*/
+static void run_mixed_test(int size)
+{
+	project2_workload_params params = project2_wl_params;
+	project2_workload prefill = { 0 };
+	project2_workload wl = { 0 };
+	project2_ds_type type;
+	project2_handle *handle = NULL;
+	bool has_batch;
+	int range = project2_key_range(size);
+
+	if (project2_workload_generate(&wl, &params, nr_ops, range))
+		goto out;
+
+	// The prefill only inserts, with distinct keys from the same range.
+	params.dist = PROJECT2_DIST_UNIQUE;
+	params.op_pct[PROJECT2_OP_INSERT] = 100;
+	params.op_pct[PROJECT2_OP_LOOKUP] = 0;
+	params.op_pct[PROJECT2_OP_DELETE] = 0;
+	params.seed = wl.seed + 1;
+
+	if (project2_workload_generate(&prefill, &params, size, range))
+		goto out;
+
+	project2_report("##################################\n");
+	project2_report("Mixed summary for %d prefilled integers\n", size);
+	project2_workload_print(&wl, &project2_wl_params);
+
+	for (type = PROJECT2_LIST; type < PROJECT2_NR_TYPES; type++) {
+		if (READ_ONCE(project2_stop))
+			break;
+
+		if (ds_handle[type].get_handle(&handle))
+			continue;
+
+		has_batch = handle->add_batch && handle->remove_batch;
+		ds_handle[type].free_handle(handle);
+
+		if (!has_batch)
+			continue;
+
+		if (run_mixed(type, prefill.keys, size, &wl))
+			project2_report("%s mixed test failed\n",
+					ds_handle[type].type);
+	}
+
+	project2_report("##################################\n");
+
+out:
+	if (!wl.keys || !prefill.keys)
+		project2_report("workload generation for mixed test failed\n");
+
+	project2_workload_free(&prefill);
+	project2_workload_free(&wl);
+}
+
+/**
+* @brief Prints the aggregated statistics of every test suite which was run
+*
+* @param size Number of integers inserted by every suite
+*/
+static void print_summary(int size)
+{
+	project2_ds_type type;
+	project2_result *result;
+
+	project2_report("##################################\n");
+	project2_report("Statistics summary for %d integers, latency in ns\n",
+			size);
+
+	for (type = PROJECT2_LIST; type < PROJECT2_NR_TYPES; type++) {
+		result = &results[type];
+
+		if (!result->valid)
+			continue;
+
+		project2_report("\n%s: %s\n", ds_handle[type].type,
+				result->ret ? "FAILED" : "passed");
+
+		project2_hist_print_header();
+
+		project2_hist_print(ds_handle[type].type, "add",
+					&result->add, result->add_ns);
+		project2_hist_print(ds_handle[type].type, "iterate",
+					&result->iterate, result->iterate_ns);
+		project2_hist_print(ds_handle[type].type, "remove",
+					&result->remove, result->remove_ns);
+	}
+
+	project2_report("##################################\n");
+}
+
+/**
+* @brief Looks up a data structure by name, "all" selects every one
+*
+* @param name Name of the data structure
+*
+* @return project2_ds_type, PROJECT2_NR_TYPES for all or -EINVAL
+*/
+int project2_type_parse(const char *name)
+{
+	int type;
+
+	for (type = PROJECT2_LIST; type < PROJECT2_NR_TYPES; type++)
+		if (sysfs_streq(name, ds_handle[type].type))
+			return type;
+
+	if (sysfs_streq(name, "all"))
+		return PROJECT2_NR_TYPES;
+
+	return -EINVAL;
+}
+
+/**
+* @brief Returns the name of a data structure
+*
+* @param type project2_ds_type or PROJECT2_NR_TYPES for all of them
+*
+* @return Name of the data structure
+*/
+const char *project2_type_name(int type)
+{
+	if (type == PROJECT2_NR_TYPES)
+		return "all";
+
+	if (type < PROJECT2_LIST || type > PROJECT2_NR_TYPES)
+		return "invalid";
+
+	return ds_handle[type].type;
+}
+
+/**
+* @brief Runs the test suite of every selected data structure, or shares
+*		one instance of them between several threads
+*
+* @param cfg Configuration of the run
+* @param params Parameters of the workload
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int run_suite(const project2_config *cfg,
+				const project2_workload_params *params)
+{
+	project2_workload wl = { 0 };
+	project2_ds_type type;
+	int ret;
+
+	/* Several threads share one instance instead of the suites below */
+	if (cfg->threads > 1)
+		return project2_concurrent_run(cfg, params, nr_ops);
+
+	project2_report("Starting Project2 for %d integers\n", cfg->size);
+
+	/* Keys are generated up front so the RNG stays out of the timings */
+	ret = project2_workload_generate(&wl, params, cfg->size,
+					project2_key_range(cfg->size));
+	if (ret) {
+		project2_report("workload generation failed %d\n", ret);
+		return ret;
+	}
+
+	project2_workload_print(&wl, params);
+
+	if (cfg->type == PROJECT2_LIST || cfg->type == PROJECT2_NR_TYPES)
+		project2_list_standalone(wl.keys, cfg->size);
+
+	/* Iterate over all data structures and perform the test
+	* Ignore the errors as we want to run all the test-cases.
+	*/
+	for (type = PROJECT2_LIST; type < PROJECT2_NR_TYPES; type++) {
+		if (cfg->type != PROJECT2_NR_TYPES && cfg->type != type)
+			continue;
+
+		if (run_test(type, wl.keys, cfg->size)) {
+			project2_report("%s test failed\n", ds_handle[type].type);
+		}
+
+		if (READ_ONCE(project2_stop)) {
+			project2_workload_free(&wl);
+			return -EINTR;
+		}
+	}
+
+	project2_workload_free(&wl);
+
+	print_summary(cfg->size);
+
+	if (cfg->batch)
+		run_batch_test(cfg->type, cfg->size, cfg->batch);
+
+	return 0;
+}
+
+/**
+* @brief Scales the readers next to one writer, see project2_readers_run
+*/
+static int run_readers(const project2_config *cfg,
+				const project2_workload_params *params)
+{
+	return project2_readers_run(cfg, params, nr_ops);
+}
+
+/**
+* @brief Scales the producers next to one consumer, see project2_ingest_run
+*/
+static int run_ingest(const project2_config *cfg,
+				const project2_workload_params *params)
+{
+	return project2_ingest_run(cfg, params, nr_ops);
+}
+
+/**
+* @brief Drains after the fill, see project2_drain_run
+*/
+static int run_drain(const project2_config *cfg,
+				const project2_workload_params *params)
+{
+	return project2_drain_run(cfg, params, nr_ops);
+}
+
+/**
+* @brief Benchmark which can be selected by name
+*/
+typedef struct project2_bench_desc_t {
+	const char *name; /*Name of the bench parameter and debugfs file */
+	const char *desc; /*Listed with the names on an unknown bench */
+	/*Entry point, cfg is checked already */
+	int (*run)(const project2_config *cfg,
+			const project2_workload_params *params);
+} project2_bench_desc;
+
+/**
+* @brief Benchmarks indexed by project2_bench
+*/
+static const project2_bench_desc benches[PROJECT2_NR_BENCHES] = {
+	[PROJECT2_BENCH_SUITE] = { "suite",
+		"add, iterate and remove every data structure, or share them between nr_threads threads",
+		run_suite },
+	[PROJECT2_BENCH_READERS] = { "readers",
+		"one writer, 1..nr_threads-1 readers", run_readers },
+	[PROJECT2_BENCH_INGEST] = { "ingest",
+		"1..nr_threads producers, one consumer", run_ingest },
+	[PROJECT2_BENCH_DRAIN] = { "drain",
+		"fill, then drain on the first CPU", run_drain },
+	[PROJECT2_BENCH_IDMAP] = { "idmap",
+		"map against xarray with dense, cyclic, sparse and churning ids for sizes 1000..dstruct_size",
+		run_idmap_test },
+	[PROJECT2_BENCH_HOLD] = { "hold",
+		"nr_ops pop-min and insert pairs on prefilled priority queues",
+		run_hold_test },
+	[PROJECT2_BENCH_OSTAT] = { "ostat",
+		"insert/erase cost of the order statistics tree against the rbtree, with rank and select",
+		run_ostat_test },
+	[PROJECT2_BENCH_BUILD] = { "build",
+		"add, add_batch and build from sorted keys, then lookups with cache misses, for the rbtree, sorted array and static layouts",
+		run_build_test },
+	[PROJECT2_BENCH_ITER] = { "iter",
+		"iteration bandwidth and bytes per element of the list against the unrolled list",
+		run_iter_test },
+};
+
+/**
+* @brief Looks up a benchmark by name
+*
+* @param name Name of the benchmark
+*
+* @return project2_bench or -EINVAL if the name is unknown
+*/
+int project2_bench_parse(const char *name)
+{
+	int bench;
+
+	for (bench = 0; bench < PROJECT2_NR_BENCHES; bench++)
+		if (sysfs_streq(name, benches[bench].name))
+			return bench;
+
+	return -EINVAL;
+}
+
+/**
+* @brief Returns the name of a benchmark
+*
+* @param bench project2_bench
+*
+* @return Name of the benchmark
+*/
+const char *project2_bench_name(int bench)
+{
+	if (bench < 0 || bench >= PROJECT2_NR_BENCHES)
+		return "invalid";
+
+	return benches[bench].name;
+}
+
+/**
+* @brief Checks the configuration of a run
+*
+* Several threads without synchronization only run the thread safe
+* handles.
+*
+* @param cfg Configuration of the run
+*
+* @return 0 if cfg can be run or appropriate error code.
+*/
+int project2_config_check(const project2_config *cfg)
+{
+	if (cfg->type < PROJECT2_LIST || cfg->type > PROJECT2_NR_TYPES ||
+			cfg->dist < 0 || cfg->dist >= PROJECT2_NR_DISTS ||
+			cfg->size <= 0 || cfg->size > INT_MAX / 2 ||
+			cfg->batch < 0 || cfg->batch > cfg->size ||
+			cfg->cpu < -1 || cfg->threads < 1 ||
+			cfg->threads > num_online_cpus() ||
+			cfg->sync < 0 || cfg->sync >= PROJECT2_NR_SYNCS ||
+			cfg->bench < 0 || cfg->bench >= PROJECT2_NR_BENCHES)
+		return -EINVAL;
+
+	/* The readers share the CPUs with one writer */
+	if (cfg->bench == PROJECT2_BENCH_READERS && cfg->threads < 2)
+		return -EINVAL;
+
+	return 0;
+}
+
+/**
+* @brief Runs the benchmark described by cfg, the report of the run
+*		replaces the previous one.
+*
+* @param cfg Configuration of the run
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_run(const project2_config *cfg)
+{
+	project2_workload_params params = project2_wl_params;
+	int ret;
+
+	ret = project2_config_check(cfg);
+	if (ret)
+		return ret;
+
+	params.dist = cfg->dist;
+
+	project2_report_reset();
+	memset(results, 0, sizeof(results));
+
+	return benches[cfg->bench].run(cfg, &params);
+}
+
+/**
+* @brief Runs the benchmark of the module parameters followed by the
+*		optional tests they enabled
+*
+* @param cfg Configuration built from the module parameters
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+static int run_on_load(const project2_config *cfg)
+{
+	int ret = project2_run(cfg);
+
+	if (ret)
+		return ret;
+
+	if (batch_test && !READ_ONCE(project2_stop))
+		run_batch_test(PROJECT2_NR_TYPES, cfg->size, 0);
+
+	if (lookup_test && !READ_ONCE(project2_stop))
+		run_lookup_test(cfg->size);
+
+	if (mixed_test && !READ_ONCE(project2_stop))
+		run_mixed_test(cfg->size);
+
+	if (!READ_ONCE(project2_stop))
+		project2_pools_report(cfg->size);
+
+	return 0;
+}
+
+/**
+* @brief Init function for the module
+*
+* @return 0 for success or appropriate error codes on failure.
+*/
+static int __init project2_init(void)
+{
+	project2_config cfg;
+	int dist;
+	int sync;
+	int bench_type;
+	int ret;
+	int i;
+
+	/* Error check for <= 0 size */
+	if (dstruct_size <= 0) {
+		printk (KERN_INFO "invalid size %d\n", dstruct_size);
+		return -EINVAL;
+	}
+
+	if (trace_sample < 0) {
+		printk (KERN_INFO "invalid trace_sample %d\n", trace_sample);
+		return -EINVAL;
+	}
+
+	if (hit_ratio < 0 || hit_ratio > 100 || nr_lookups <= 0 ||
+			dstruct_size > INT_MAX / 2) {
+		printk (KERN_INFO "invalid lookup parameters\n");
+		return -EINVAL;
+	}
+
+	if (alloc_mode < PROJECT2_ALLOC_KMALLOC || alloc_mode > PROJECT2_ALLOC_BULK) {
+		printk (KERN_INFO "invalid alloc_mode %d\n", alloc_mode);
+		return -EINVAL;
+	}
+
+	dist = project2_dist_parse(wl_dist);
+	if (dist < 0) {
+		printk (KERN_INFO "invalid wl_dist %s\n", wl_dist);
+		return -EINVAL;
+	}
+
+	if (wl_theta < 1 || wl_theta > 99 || wl_hot_keys < 1 ||
+			wl_hot_keys > 100 || wl_hot_ops < 0 || wl_hot_ops > 100 ||
+			wl_period <= 0) {
+		printk (KERN_INFO "invalid workload parameters\n");
+		return -EINVAL;
+	}
+
+	if (wl_insert < 0 || wl_lookup < 0 || wl_delete < 0 ||
+			wl_insert + wl_lookup + wl_delete != 100 || nr_ops <= 0 ||
+			nr_ops > INT_MAX - dstruct_size) {
+		printk (KERN_INFO "invalid op mix, percentages must sum to 100\n");
+		return -EINVAL;
+	}
+
+	sync = project2_sync_parse(sync_mode);
+	if (sync < 0) {
+		printk (KERN_INFO "invalid sync_mode %s\n", sync_mode);
+		return -EINVAL;
+	}
+
+	bench_type = project2_bench_parse(bench);
+	if (bench_type < 0) {
+		printk (KERN_INFO "invalid bench %s, one of:\n", bench);
+		for (i = 0; i < PROJECT2_NR_BENCHES; i++)
+			printk (KERN_INFO "  %-8s %s\n", benches[i].name,
+							benches[i].desc);
+		return -EINVAL;
+	}
+
+	project2_wl_params.dist = dist;
+	project2_wl_params.zipf_theta = wl_theta;
+	project2_wl_params.hot_keys_pct = wl_hot_keys;
+	project2_wl_params.hot_ops_pct = wl_hot_ops;
+	project2_wl_params.saw_period = wl_period;
+	project2_wl_params.op_pct[PROJECT2_OP_INSERT] = wl_insert;
+	project2_wl_params.op_pct[PROJECT2_OP_LOOKUP] = wl_lookup;
+	project2_wl_params.op_pct[PROJECT2_OP_DELETE] = wl_delete;
+	project2_wl_params.seed = wl_seed;
+
+	/* Only the sampled trace is kept in benchmark mode */
+	if (bench_mode)
+		project2_trace_interval = trace_sample;
+
+	project2_pool_mode = alloc_mode;
+
+	/* Dedicated caches are created even for kmalloc for the report */
+	if (project2_pools_create())
+		return -ENOMEM;
+
+	cfg.type = PROJECT2_NR_TYPES;
+	cfg.size = dstruct_size;
+	cfg.batch = 0;
+	cfg.dist = dist;
+	cfg.threads = nr_threads;
+	cfg.cpu = run_cpu;
+	cfg.sync = sync;
+	cfg.bench = bench_type;
+
+	/* Later runs are started from debugfs with the module loaded */
+	ret = project2_debugfs_init(&cfg);
+	if (ret) {
+		printk (KERN_INFO "debugfs control directory failed %d\n", ret);
+		project2_pools_destroy();
+		return ret;
+	}
+
+	/* The first run happens on the kthread so that insmod returns */
+	ret = project2_runner_start(run_on_load, &cfg);
+	if (ret) {
+		printk (KERN_INFO "starting the benchmark failed %d\n", ret);
+		project2_debugfs_exit();
+		project2_pools_destroy();
+		return ret;
+	}
+
+	return 0;
+}
+
+/**
+* @brief Exit function for the module/
+*/
+static void __exit project2_exit(void)
+{
+	project2_debugfs_exit();
+
+	/* Nodes are freed on cancellation, so the pools are empty after it */
+	project2_runner_stop();
+
+	project2_pools_destroy();
+
 	printk(KERN_INFO "Module exiting \n");
 }
 
@@ -1,6 +1,7 @@
 #include <linux/module.h>
 #include <linux/random.h>
 #include <linux/slab.h>
+#include <linux/mm.h>
 #include <linux/kfifo.h>
 #include "project2.h"
 
@@ -12,21 +13,99 @@ typedef struct project2_map_context_t {
 	struct idr *map_ptr; /*map pointer for accessing map*/
 	int lower_bound;
 	int upper_bound;
+	int nr_data; /*Slots of data_ptr handed out so far */
+	int max_data; /*Number of slots in data_ptr */
+	int free_slot; /*Released slots chained through data_ptr, -1 if none */
+	project2_id_mode mode; /*How add picks the ids */
 } project2_map_context;
 
+/**
+* @brief Hands out a released slot of the data buffer or the next unused one
+*
+* @param map_context Context of the map
+*
+* @return Slot for the data or NULL if the buffer is exhausted
+*/
+static int *__get_map_slot(project2_map_context *map_context)
+{
+	int *slot;
+
+	if (map_context->free_slot >= 0) {
+		slot = &map_context->data_ptr[map_context->free_slot];
+		map_context->free_slot = *slot;
+		return slot;
+	}
+
+	if (map_context->nr_data >= map_context->max_data)
+		return NULL;
+
+	return &map_context->data_ptr[map_context->nr_data++];
+}
+
+/**
+* @brief Gives a slot back to the data buffer
+*
+* @param map_context Context of the map
+* @param slot Slot which no id refers to any more
+*/
+static void __put_map_slot(project2_map_context *map_context, int *slot)
+{
+	*slot = map_context->free_slot;
+	map_context->free_slot = slot - map_context->data_ptr;
+}
+
+/**
+* @brief Allocates the id of key as selected by the mode of the map
+*
+* @param map_context Context of the map
+* @param slot Slot holding the data
+* @param key Key to be inserted, the id itself in the sparse mode
+* @param gfp Allocation flags
+*
+* @return Allocated id or appropriate error codes on failure
+*/
+static int __alloc_map_id(project2_map_context *map_context, int *slot,
+							int key, gfp_t gfp)
+{
+	switch (map_context->mode) {
+	case PROJECT2_ID_CYCLIC:
+		return idr_alloc_cyclic(map_context->map_ptr, slot,
+						map_context->lower_bound,
+						map_context->upper_bound, gfp);
+
+	case PROJECT2_ID_SPARSE:
+		if (key < 0)
+			return -EINVAL;
+
+		// An end of 0 stands for INT_MAX in idr_alloc.
+		return idr_alloc(map_context->map_ptr, slot, key,
+					key == INT_MAX ? 0 : key + 1, gfp);
+
+	default:
+		return idr_alloc(map_context->map_ptr, slot,
+						map_context->lower_bound,
+						map_context->upper_bound, gfp);
+	}
+}
+
 
 /**
 * @brief Add size number of Random Integers to the map
 *
 * @param context Context information for the map
+* @param keys Keys to be inserted
 * @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
 *
 * @return 0 if successful otherwise appropriate error codes
 */
-static int add_map(void *context, int size)
+static int add_map(void *context, const int *keys, int size,
+						project2_hist *hist)
 {
 	int id = 0;
 	int tmp_size = size;
+	int *slot;
+	u64 start;
 	project2_map_context *map_context = (project2_map_context *) context;
 
 	if (!map_context) {
@@ -46,18 +125,30 @@ static int add_map(void *context, int size)
 
 	while(size--) {
 
-		map_context->data_ptr[size] = project2_get_next_integer(tmp_size);
+		if (project2_yield(tmp_size - size - 1))
+			return -EINTR;
 
-		idr_preload(GFP_KERNEL);
+		slot = __get_map_slot(map_context);
+		if (slot == NULL) {
+			printk(KERN_INFO "No space in the data buffer\n");
+			return -ENOSPC;
+		}
 
-		id = idr_alloc(map_context->map_ptr,
-						&(map_context->data_ptr[size]),
-						map_context->lower_bound,
-						map_context->upper_bound, GFP_KERNEL);
+		*slot = keys[tmp_size - size - 1];
+
+		start = project2_time_start(hist);
+
+		idr_preload(project2_gfp);
+
+		id = __alloc_map_id(map_context, slot, *slot, project2_gfp);
 
 		idr_preload_end();
 
+		project2_time_end(hist, start);
+
 		if (id < 0) {
+			__put_map_slot(map_context, slot);
+
 			if(id == -ENOSPC) {
 				printk(KERN_INFO "No space in the range\n");
 			} else if(id == -ENOMEM) {
@@ -67,10 +158,11 @@ static int add_map(void *context, int size)
 			}
 			return id;
 		}
-		printk(KERN_INFO "MAP_ADD<id,value>: <%d, %d>\n", id, map_context->data_ptr[size]);
+
+		PROJECT2_TRACE(size, "MAP_ADD<id,value>: <%d, %d>\n", id, *slot);
 	}
 
-	printk(KERN_INFO "\n");
+	PROJECT2_TRACE(0, "\n");
 
 	return 0;
 }
@@ -79,12 +171,15 @@ static int add_map(void *context, int size)
 * @brief Prints the contents of the map
 *
 * @param context Context of the map
+* @param hist Histogram for per element latency, may be NULL
 */
-static void show_map(void *context)
+static void show_map(void *context, project2_hist *hist)
 {
 	project2_map_context *map_context = (project2_map_context *) context;
+	unsigned long index = 0;
 	int *curr = NULL;
 	int id = 0;
+	u64 start;
 
 	if (!map_context) {
 		printk(KERN_INFO "context to show_map is NULL\n");
@@ -96,22 +191,38 @@ static void show_map(void *context)
 		return;
 	}
 
-	idr_for_each_entry(map_context->map_ptr, curr, id)
-		printk(KERN_INFO "MAP_SHOW<id,value>: <%d, %d>\n", id, *curr);
+	start = project2_time_start(hist);
+
+	idr_for_each_entry(map_context->map_ptr, curr, id) {
+		PROJECT2_TRACE(id, "MAP_SHOW<id,value>: <%d, %d>\n", id, *curr);
+
+		// Each sample covers the lookup of the next id and its processing.
+		project2_time_end(hist, start);
 
-	printk(KERN_INFO "\n");
+		if (project2_yield(++index))
+			return;
+
+		start = project2_time_start(hist);
+	}
+
+	PROJECT2_TRACE(0, "\n");
 }
 
 /**
 * @brief Destroys the entire map
 *
 * @param context Context of the map
+* @param hist Histogram for per element latency, may be NULL
 *
 * @return 0 for success and appropriate error codes on failure
 */
-static int remove_map(void *context)
+static int remove_map(void *context, project2_hist *hist)
 {
 	project2_map_context *map_context = (project2_map_context *) context;
+	unsigned long index = 0;
+	int *curr = NULL;
+	int id = 0;
+	u64 start;
 
 	if (!context) {
 		printk(KERN_INFO "context to remove_map is NULL\n");
@@ -119,15 +230,149 @@ static int remove_map(void *context)
 	}
 
 	if (map_context->map_ptr) {
+		// Remove the ids one by one so that every element gets timed.
+		idr_for_each_entry(map_context->map_ptr, curr, id) {
+			start = project2_time_start(hist);
+			idr_remove(map_context->map_ptr, id);
+			project2_time_end(hist, start);
+
+			project2_yield(++index);
+		}
+
 		idr_destroy(map_context->map_ptr);
 		printk(KERN_INFO "Destroyed entire map\n");
 	}
 
-	show_map(context);
+	map_context->nr_data = 0;
+	map_context->free_slot = -1;
+
+	show_map(context, NULL);
 
 	return 0;
 }
 
+/**
+* @brief Inserts nr keys, using every key as its own id
+*
+* The preloaded IDR nodes are shared by the whole batch and are only
+* refilled when an allocation runs out of them.
+*
+* @param context Context of the map
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success, -EEXIST if some keys were already present or
+*		appropriate error codes on failure
+*/
+static int add_batch_map(void *context, const int *keys, int nr)
+{
+	project2_map_context *map_context = (project2_map_context *) context;
+	int ret = 0;
+	int *slot;
+	int end;
+	int id;
+	int i;
+
+	if (!map_context || !map_context->map_ptr) {
+		printk(KERN_INFO "context to add_batch_map is NULL\n");
+		return -EINVAL;
+	}
+
+	idr_preload(project2_gfp);
+
+	for (i = 0; i < nr; i++) {
+		slot = __get_map_slot(map_context);
+		if (slot == NULL) {
+			ret = -ENOSPC;
+			break;
+		}
+
+		*slot = keys[i];
+
+		// An end of 0 stands for INT_MAX in idr_alloc.
+		end = keys[i] == INT_MAX ? 0 : keys[i] + 1;
+
+		id = idr_alloc(map_context->map_ptr, slot, keys[i], end,
+						GFP_NOWAIT);
+
+		if (id == -ENOMEM) {
+			idr_preload_end();
+			idr_preload(project2_gfp);
+			id = idr_alloc(map_context->map_ptr, slot, keys[i], end,
+							GFP_NOWAIT);
+		}
+
+		if (id == -ENOSPC) {
+			// The key is already present.
+			__put_map_slot(map_context, slot);
+			ret = -EEXIST;
+			continue;
+		}
+
+		if (id < 0) {
+			__put_map_slot(map_context, slot);
+			ret = id;
+			break;
+		}
+	}
+
+	idr_preload_end();
+
+	return ret;
+}
+
+/**
+* @brief Removes up to nr elements with the smallest ids
+*
+* @param context Context of the map
+* @param keys Receives the removed values
+* @param nr Maximum number of elements to remove
+*
+* @return Number of removed elements or appropriate error codes on failure
+*/
+static int remove_batch_map(void *context, int *keys, int nr)
+{
+	project2_map_context *map_context = (project2_map_context *) context;
+	int *curr;
+	int count;
+	int id = 0;
+
+	if (!map_context || !map_context->map_ptr) {
+		printk(KERN_INFO "context to remove_batch_map is NULL\n");
+		return -EINVAL;
+	}
+
+	for (count = 0; count < nr; count++, id++) {
+		curr = idr_get_next(map_context->map_ptr, &id);
+		if (curr == NULL)
+			break;
+
+		keys[count] = *curr;
+		idr_remove(map_context->map_ptr, id);
+		__put_map_slot(map_context, curr);
+	}
+
+	return count;
+}
+
+/**
+* @brief Checks whether the id is allocated in the map
+*
+* @param context Context of the map
+* @param key Id to be searched
+*
+* @return true if an element is stored under the id
+*/
+static bool lookup_map(void *context, int key)
+{
+	project2_map_context *map_context = (project2_map_context *) context;
+
+	if (!map_context || !map_context->map_ptr || key < 0)
+		return false;
+
+	return idr_find(map_context->map_ptr, key) != NULL;
+}
+
 /**
 * @brief Deallocates the context
 *
@@ -142,7 +387,7 @@ static void deinit_map(void *context)
 	}
 
 	if (context && map_context->data_ptr)
-		kfree(map_context->data_ptr);
+		kvfree(map_context->data_ptr);
 
 	if (context)
 		kfree(context);
@@ -171,10 +416,23 @@ static int init_map(int size, void **context)
 
 	map_context->lower_bound = 0;
 	map_context->upper_bound = size;
+	map_context->nr_data = 0;
+	map_context->max_data = size;
+	map_context->free_slot = -1;
+	map_context->mode = project2_id_alloc;
+
+	// Cyclic ids keep climbing past size, an end of 0 is INT_MAX.
+	if (map_context->mode == PROJECT2_ID_CYCLIC)
+		map_context->upper_bound = 0;
 
-	printk( KERN_INFO "Using range for id as [%d, %d)", 0, size);
+	if (map_context->mode == PROJECT2_ID_SPARSE)
+		printk(KERN_INFO "Using the keys as ids");
+	else
+		printk( KERN_INFO "Using range for id as [%d, %d)", 0,
+				map_context->upper_bound ? : INT_MAX);
 
-	map_context->data_ptr = kmalloc(sizeof(int) * size, GFP_KERNEL);
+	// Beyond a few MB the side buffer no longer fits a kmalloc.
+	map_context->data_ptr = kvmalloc_array(size, sizeof(int), GFP_KERNEL);
 
 	if (map_context->data_ptr == NULL) {
 		printk (KERN_INFO "memory allocation for map data buffer failed\n");
@@ -198,7 +456,10 @@ static int init_map(int size, void **context)
 }
 
 // Generates the handles for the map test-case
-PROJECT2_GENERATE_HANDLE(map);
+PROJECT2_GENERATE_HANDLE(map,
+			PROJECT2_HANDLE_OP(map, add_batch),
+			PROJECT2_HANDLE_OP(map, remove_batch),
+			PROJECT2_HANDLE_OP(map, lookup));
 
 // Module related macros
 MODULE_LICENSE("GPL");
@@ -0,0 +1,613 @@
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/version.h>
+#include <linux/rbtree_augmented.h>
+#include "project2.h"
+
+/**
+* @brief Context for the order statistics tree test
+*/
+typedef struct project2_ostree_context_t {
+	struct rb_root root; /*Root for the augmented Red-Black tree */
+} project2_ostree_context;
+
+/**
+* @brief Node of the order statistics tree
+*/
+typedef struct my_osnode_t {
+	int value; /*Value to be stored */
+	u32 size; /*Number of nodes in the subtree rooted here */
+	struct rb_node rbnode; /*Holds Meta-Data for Red-Black Node */
+} my_osnode;
+
+/**
+* @brief Allocator for the order statistics tree nodes
+*/
+project2_pool project2_ostree_pool = PROJECT2_POOL_INIT("project2_osnode",
+									my_osnode);
+
+/**
+* @brief Size of the subtree rooted at rb, 0 for an empty one
+*/
+static inline u32 __subtree_size(struct rb_node *rb)
+{
+	return rb ? rb_entry(rb, my_osnode, rbnode)->size : 0;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 3, 0)
+/**
+* @brief Recomputes the subtree size of node from its children
+*
+* @param node Node to be updated
+* @param exit Stop the propagation if the size did not change
+*
+* @return true if the propagation can stop at node
+*/
+static inline bool __compute_ostree_size(my_osnode *node, bool exit)
+{
+	u32 size = 1 + __subtree_size(node->rbnode.rb_left) +
+				__subtree_size(node->rbnode.rb_right);
+
+	if (exit && node->size == size)
+		return true;
+
+	node->size = size;
+
+	return false;
+}
+
+RB_DECLARE_CALLBACKS(static, ostree_callbacks, my_osnode, rbnode, size,
+						__compute_ostree_size);
+#else
+/**
+* @brief Computes the subtree size of node from its children
+*
+* @param node Node to be updated
+*
+* @return Size of the subtree rooted at node
+*/
+static inline u32 __compute_ostree_size(my_osnode *node)
+{
+	return 1 + __subtree_size(node->rbnode.rb_left) +
+				__subtree_size(node->rbnode.rb_right);
+}
+
+RB_DECLARE_CALLBACKS(static, ostree_callbacks, my_osnode, rbnode, u32, size,
+						__compute_ostree_size);
+#endif
+
+/**
+* @brief Helper API to perform insertion in the order statistics tree.
+*
+* Every node on the way down gains one in size, the rotations of the
+* rebalance fix the sizes through the callbacks.
+*
+* @param root Root for the tree
+* @param entry Node which has to be inserted
+*
+* @return 0 for success and appropriate error codes for failure
+*/
+static int __add_ostree_node(struct rb_root *root, my_osnode *entry)
+{
+	struct rb_node **link = &root->rb_node;
+	struct rb_node *parent = NULL;
+	struct rb_node *node;
+	my_osnode *myentry;
+
+	while (*link) {
+		parent = *link;
+		myentry = rb_entry(parent, my_osnode, rbnode);
+
+		if (myentry->value == entry->value) {
+			// Undo the sizes counted on the way down to the duplicate.
+			for (node = rb_parent(parent); node; node = rb_parent(node))
+				rb_entry(node, my_osnode, rbnode)->size--;
+
+			return -EEXIST;
+		}
+
+		myentry->size++;
+
+		if (myentry->value > entry->value)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+
+	entry->size = 1;
+	rb_link_node(&entry->rbnode, parent, link);
+	rb_insert_augmented(&entry->rbnode, root, &ostree_callbacks);
+
+	return 0;
+}
+
+/**
+* @brief Helper function to find the smallest node not below value
+*
+* @param root Root of the tree
+* @param value Lower bound of the search
+*
+* @return NULL if every node is below value, Address of the node otherwise
+*/
+static struct rb_node *__lower_bound_ostree(struct rb_root *root, int value)
+{
+	struct rb_node *node = root->rb_node;
+	struct rb_node *bound = NULL;
+
+	while (node) {
+		if (rb_entry(node, my_osnode, rbnode)->value >= value) {
+			bound = node;
+			node = node->rb_left;
+		} else
+			node = node->rb_right;
+	}
+	return bound;
+}
+
+/**
+* @brief Add size number of Random Integers to the tree, keys already
+*		present are skipped
+*
+* @param context Context information for the tree
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_ostree(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	project2_ostree_context *os_context = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_ostree_pool);
+	my_osnode *tmp_node;
+	int tmp_size = size;
+	int skipped = 0;
+	int ret = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_ostree is NULL\n");
+		return -EINVAL;
+	}
+
+	while (tmp_size--) {
+		if (project2_yield(size - tmp_size - 1)) {
+			ret = -EINTR;
+			break;
+		}
+
+		start = project2_time_start(hist);
+
+		tmp_node = project2_pool_get(&batch, project2_gfp);
+
+		if (tmp_node == NULL) {
+			printk (KERN_INFO "memory allocation for ostree node failed\n");
+			ret = -ENOMEM;
+			break;
+		}
+
+		tmp_node->value = keys[size - tmp_size - 1];
+
+		ret = __add_ostree_node(&os_context->root, tmp_node);
+
+		project2_time_end(hist, start);
+
+		if (ret == -EEXIST) {
+			project2_pool_put(&batch, tmp_node);
+			skipped++;
+			ret = 0;
+			continue;
+		}
+
+		PROJECT2_TRACE(tmp_size, "OSTREE_ADD: %d\n", tmp_node->value);
+	}
+
+	project2_pool_flush(&batch);
+
+	if (skipped)
+		printk(KERN_INFO "Skipped %d duplicate keys\n", skipped);
+
+	PROJECT2_TRACE(0, "\n");
+	return ret;
+}
+
+/**
+* @brief Prints the contents of the tree in INORDER with the subtree sizes
+*
+* @param context Context of the tree
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_ostree(void *context, project2_hist *hist)
+{
+	project2_ostree_context *os_context = context;
+	struct rb_node *node;
+	my_osnode *curr;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_ostree is NULL\n");
+		return;
+	}
+
+	start = project2_time_start(hist);
+
+	for (node = rb_first(&os_context->root); node != NULL;
+			node = rb_next(node)) {
+		curr = rb_entry(node, my_osnode, rbnode);
+		PROJECT2_TRACE(index++, "OSTREE_SHOW<value,size>: <%d, %u>\n",
+					curr->value, curr->size);
+
+		project2_time_end(hist, start);
+
+		if (project2_yield(index))
+			return;
+
+		start = project2_time_start(hist);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Removes the entire tree.
+*
+* @param context Context of the tree.
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_ostree(void *context, project2_hist *hist)
+{
+	project2_ostree_context *os_context = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_ostree_pool);
+	my_osnode *curr = NULL;
+	my_osnode *next = NULL;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_ostree is NULL\n");
+		return -EINVAL;
+	}
+
+	start = project2_time_start(hist);
+
+	rbtree_postorder_for_each_entry_safe(curr, next, &os_context->root,
+								rbnode) {
+		PROJECT2_TRACE(index++, "OSTREE_REMOVE: %d\n", curr->value);
+		project2_pool_put(&batch, curr);
+
+		project2_time_end(hist, start);
+
+		project2_yield(index);
+
+		start = project2_time_start(hist);
+	}
+
+	project2_pool_flush(&batch);
+
+	os_context->root = RB_ROOT;
+
+	show_ostree(context, NULL);
+
+	return 0;
+}
+
+/**
+* @brief Inserts nr keys one by one
+*
+* @param context Context of the tree
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success, -EEXIST if some keys were already present or
+*		appropriate error codes on failure
+*/
+static int add_batch_ostree(void *context, const int *keys, int nr)
+{
+	project2_ostree_context *os_context = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_ostree_pool);
+	my_osnode *tmp_node;
+	int ret = 0;
+	int err;
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_ostree is NULL\n");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < nr; i++) {
+		tmp_node = project2_pool_get(&batch, project2_gfp);
+		if (tmp_node == NULL) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		tmp_node->value = keys[i];
+
+		err = __add_ostree_node(&os_context->root, tmp_node);
+		if (err) {
+			project2_pool_put(&batch, tmp_node);
+			ret = err;
+		}
+	}
+
+	project2_pool_flush(&batch);
+
+	return ret;
+}
+
+/**
+* @brief Removes up to nr of the smallest keys from the tree
+*
+* @param context Context of the tree
+* @param keys Receives the removed keys in ascending order
+* @param nr Maximum number of keys to remove
+*
+* @return Number of removed keys or appropriate error codes on failure
+*/
+static int remove_batch_ostree(void *context, int *keys, int nr)
+{
+	project2_ostree_context *os_context = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_ostree_pool);
+	struct rb_node *node;
+	my_osnode *curr;
+	int count;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_ostree is NULL\n");
+		return -EINVAL;
+	}
+
+	for (count = 0; count < nr; count++) {
+		node = rb_first(&os_context->root);
+		if (node == NULL)
+			break;
+
+		curr = rb_entry(node, my_osnode, rbnode);
+		keys[count] = curr->value;
+
+		rb_erase_augmented(node, &os_context->root, &ostree_callbacks);
+		project2_pool_put(&batch, curr);
+	}
+
+	project2_pool_flush(&batch);
+
+	return count;
+}
+
+/**
+* @brief Erases every key in [start, end] from the tree
+*
+* @param context Context of the tree
+* @param start Start of the range (INCLUSIVE)
+* @param end End of the range (INCLUSIVE)
+*
+* @return Number of erased keys or appropriate error codes on failure
+*/
+static int remove_range_ostree(void *context, int start, int end)
+{
+	project2_ostree_context *os_context = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_ostree_pool);
+	struct rb_node *node;
+	struct rb_node *next;
+	my_osnode *curr;
+	int count = 0;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_range_ostree is NULL\n");
+		return -EINVAL;
+	}
+
+	node = __lower_bound_ostree(&os_context->root, start);
+
+	while (node) {
+		curr = rb_entry(node, my_osnode, rbnode);
+		if (curr->value > end)
+			break;
+
+		// The successor stays valid across the erase of node.
+		next = rb_next(node);
+
+		rb_erase_augmented(node, &os_context->root, &ostree_callbacks);
+		project2_pool_put(&batch, curr);
+		count++;
+
+		project2_yield(count);
+
+		node = next;
+	}
+
+	project2_pool_flush(&batch);
+
+	return count;
+}
+
+/**
+* @brief Searches the tree for key
+*
+* @param context Context of the tree
+* @param key Value to be searched
+*
+* @return true if key is present in the tree
+*/
+static bool lookup_ostree(void *context, int key)
+{
+	project2_ostree_context *os_context = context;
+	struct rb_node *node;
+
+	if (!context)
+		return false;
+
+	node = __lower_bound_ostree(&os_context->root, key);
+
+	return node && rb_entry(node, my_osnode, rbnode)->value == key;
+}
+
+/**
+* @brief Reads the smallest key of the tree without removing it
+*
+* @param context Context of the tree
+* @param key Receives the smallest key
+*
+* @return 0 for success, -ENOENT if the tree is empty
+*/
+static int peek_min_ostree(void *context, int *key)
+{
+	project2_ostree_context *os_context = context;
+	struct rb_node *node;
+
+	if (!context) {
+		printk(KERN_INFO "context to peek_min_ostree is NULL\n");
+		return -EINVAL;
+	}
+
+	node = rb_first(&os_context->root);
+	if (node == NULL)
+		return -ENOENT;
+
+	*key = rb_entry(node, my_osnode, rbnode)->value;
+
+	return 0;
+}
+
+/**
+* @brief Removes the smallest key of the tree
+*
+* @param context Context of the tree
+* @param key Receives the removed key
+*
+* @return 0 for success, -ENOENT if the tree is empty
+*/
+static int pop_min_ostree(void *context, int *key)
+{
+	int ret = remove_batch_ostree(context, key, 1);
+
+	if (ret < 0)
+		return ret;
+
+	return ret ? 0 : -ENOENT;
+}
+
+/**
+* @brief Counts the keys below key in O(log n)
+*
+* @param context Context of the tree
+* @param key Key whose rank is wanted, it need not be in the tree
+*
+* @return Number of keys smaller than key or appropriate error codes
+*/
+static int rank_ostree(void *context, int key)
+{
+	project2_ostree_context *os_context = context;
+	struct rb_node *node;
+	int rank = 0;
+
+	if (!context)
+		return -EINVAL;
+
+	node = os_context->root.rb_node;
+
+	while (node) {
+		if (rb_entry(node, my_osnode, rbnode)->value < key) {
+			// The node and its left subtree are all below key.
+			rank += __subtree_size(node->rb_left) + 1;
+			node = node->rb_right;
+		} else
+			node = node->rb_left;
+	}
+
+	return rank;
+}
+
+/**
+* @brief Finds the k-th smallest key in O(log n)
+*
+* @param context Context of the tree
+* @param k Rank of the wanted key, 0 for the smallest one
+* @param key Receives the key
+*
+* @return 0 for success, -ENOENT if the tree holds k keys or less
+*/
+static int select_ostree(void *context, int k, int *key)
+{
+	project2_ostree_context *os_context = context;
+	struct rb_node *node;
+	int left;
+
+	if (!context || k < 0)
+		return -EINVAL;
+
+	node = os_context->root.rb_node;
+
+	while (node) {
+		left = __subtree_size(node->rb_left);
+
+		if (k < left) {
+			node = node->rb_left;
+		} else if (k == left) {
+			*key = rb_entry(node, my_osnode, rbnode)->value;
+			return 0;
+		} else {
+			k -= left + 1;
+			node = node->rb_right;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/**
+* @brief Deallocates the context
+*
+* @param context Context for the tree
+*/
+static void deinit_ostree(void *context)
+{
+	if (context)
+		kfree(context);
+}
+
+/**
+* @brief Initializes the context by adding a root for the test
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_ostree(int size, void **context)
+{
+	project2_ostree_context *os_context =
+				kmalloc(sizeof(project2_ostree_context), GFP_KERNEL);
+
+	if (!os_context) {
+		printk (KERN_INFO "memory allocation for ostree context failed\n");
+		return -ENOMEM;
+	}
+
+	os_context->root = RB_ROOT;
+
+	*context = os_context;
+
+	return 0;
+}
+
+// Generates the handles for the ostree test-case
+PROJECT2_GENERATE_HANDLE(ostree,
+			PROJECT2_HANDLE_OP(ostree, add_batch),
+			PROJECT2_HANDLE_OP(ostree, remove_batch),
+			PROJECT2_HANDLE_OP(ostree, lookup),
+			PROJECT2_HANDLE_OP(ostree, remove_range),
+			PROJECT2_HANDLE_OP(ostree, peek_min),
+			PROJECT2_HANDLE_OP(ostree, pop_min),
+			PROJECT2_HANDLE_OP(ostree, rank),
+			PROJECT2_HANDLE_OP(ostree, select));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 order statistics tree on augmented rbtree\n");
@@ -0,0 +1,414 @@
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/log2.h>
+#include <linux/spinlock.h>
+#include <linux/kfifo.h>
+#include <linux/percpu.h>
+#include <linux/cpumask.h>
+#include <linux/smp.h>
+#include "project2.h"
+
+/**
+* @brief Shard of the per-CPU queue.
+*
+* Only the owning CPU enqueues, with preemption disabled, and only one
+* consumer dequeues at a time, which is the single producer/single consumer
+* case kfifo handles without locks or atomics.
+*/
+typedef struct project2_pcpu_shard_t {
+	struct kfifo fifo;
+	void *buf; /*Buffer of fifo, NULL for the CPUs offline at init */
+} project2_pcpu_shard;
+
+/**
+* @brief Context of the per-CPU queue
+*
+* The shards share the capacity of the queue, so one producer alone fills
+* its shard early. It then carries on in spill, which holds the whole
+* capacity and is shared by the producers under a lock. The memory is
+* about twice the capacity whatever the number of CPUs.
+*/
+typedef struct project2_pcpu_queue_t {
+	project2_pcpu_shard __percpu *shards; /*One kfifo per online CPU */
+	struct kfifo spill; /*Taken when the shard of the producer is full */
+	void *spill_buf; /*Buffer of spill */
+	spinlock_t spill_lock; /*Serializes the producers of spill */
+} project2_pcpu_queue;
+
+/**
+* @brief Helper API to enqueue nr keys on the shard of the calling CPU.
+*
+* @param queue Context of the queue.
+* @param keys Keys to be inserted.
+* @param nr Number of keys.
+*
+* @return 0 for success, -ENOMEM if both the local shard and the spill
+*		are full
+*/
+static int __enqueue_local(project2_pcpu_queue *queue, const int *keys, int nr)
+{
+	project2_pcpu_shard *shard = get_cpu_ptr(queue->shards);
+	unsigned int len = nr * sizeof(int);
+	int ret = 0;
+
+	// Refuse partial batches so that the queue never splits an integer.
+	if (shard->buf && kfifo_avail(&shard->fifo) >= len) {
+		kfifo_in(&shard->fifo, keys, len);
+		put_cpu_ptr(queue->shards);
+		return 0;
+	}
+
+	put_cpu_ptr(queue->shards);
+
+	spin_lock(&queue->spill_lock);
+
+	if (kfifo_avail(&queue->spill) < len)
+		ret = -ENOMEM;
+	else
+		kfifo_in(&queue->spill, keys, len);
+
+	spin_unlock(&queue->spill_lock);
+
+	return ret;
+}
+
+/**
+* @brief Helper API to dequeue up to nr keys from the shard of cpu.
+*
+* @param queue Context of the queue.
+* @param cpu CPU owning the shard.
+* @param keys Receives the dequeued values.
+* @param nr Maximum number of keys.
+*
+* @return Number of dequeued keys
+*/
+static int __dequeue_shard(project2_pcpu_queue *queue, int cpu, int *keys,
+								int nr)
+{
+	project2_pcpu_shard *shard = per_cpu_ptr(queue->shards, cpu);
+
+	if (shard->buf == NULL)
+		return 0;
+
+	return kfifo_out(&shard->fifo, keys, nr * sizeof(int)) / sizeof(int);
+}
+
+/**
+* @brief Helper API to dequeue up to nr keys from the spill.
+*
+* The producers of the spill are serialized by its lock, so the single
+* consumer reads it without the lock like a shard.
+*
+* @param queue Context of the queue.
+* @param keys Receives the dequeued values.
+* @param nr Maximum number of keys.
+*
+* @return Number of dequeued keys
+*/
+static int __dequeue_spill(project2_pcpu_queue *queue, int *keys, int nr)
+{
+	return kfifo_out(&queue->spill, keys, nr * sizeof(int)) / sizeof(int);
+}
+
+/**
+* @brief Add size number of random numbers to the shard of the CPU each
+*		element is enqueued on
+*
+* @param context Context information for the queue
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_pcpu_queue(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	int data;
+	int ret = 0;
+	int tmp_size = size;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_pcpu_queue is NULL\n");
+		return -EINVAL;
+	}
+
+	while (tmp_size--) {
+
+		if (project2_yield(size - tmp_size - 1))
+			return -EINTR;
+
+		data = keys[size - tmp_size - 1];
+
+		start = project2_time_start(hist);
+
+		ret = __enqueue_local(context, &data, 1);
+
+		project2_time_end(hist, start);
+
+		if (ret) {
+			printk(KERN_INFO "enqueue failed due to less space\n");
+			return ret;
+		}
+
+		PROJECT2_TRACE(tmp_size, "PCPU_ENQUEUE: %d\n", data);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Prints the number of elements queued on every shard
+*
+* @param context Context of the queue
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_pcpu_queue(void *context, project2_hist *hist)
+{
+	project2_pcpu_queue *queue = context;
+	int cpu;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_pcpu_queue is NULL\n");
+		return;
+	}
+
+	for_each_possible_cpu(cpu)
+		PROJECT2_TRACE(0, "PCPU_SHOW: cpu %d holds %u\n", cpu,
+			kfifo_len(&per_cpu_ptr(queue->shards, cpu)->fifo) /
+			(unsigned int)sizeof(int));
+
+	PROJECT2_TRACE(0, "PCPU_SHOW: spill holds %u\n",
+			kfifo_len(&queue->spill) / (unsigned int)sizeof(int));
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Drains every shard of the queue.
+*
+* @param context Context of the queue.
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_pcpu_queue(void *context, project2_hist *hist)
+{
+	int data;
+	int cpu;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_pcpu_queue is NULL\n");
+		return -EINVAL;
+	}
+
+	for_each_possible_cpu(cpu) {
+		for (;;) {
+			start = project2_time_start(hist);
+
+			if (!__dequeue_shard(context, cpu, &data, 1))
+				break;
+
+			project2_time_end(hist, start);
+
+			PROJECT2_TRACE(index++, "PCPU_DEQUEUE: %d\n", data);
+
+			project2_yield(index);
+		}
+	}
+
+	for (;;) {
+		start = project2_time_start(hist);
+
+		if (!__dequeue_spill(context, &data, 1))
+			break;
+
+		project2_time_end(hist, start);
+
+		PROJECT2_TRACE(index++, "PCPU_DEQUEUE: %d\n", data);
+
+		project2_yield(index);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Enqueues nr keys on the shard of the calling CPU, without any
+*		lock or atomic, or on the locked spill once the shard is full
+*
+* @param context Context of the queue
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int add_batch_pcpu_queue(void *context, const int *keys, int nr)
+{
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_pcpu_queue is NULL\n");
+		return -EINVAL;
+	}
+
+	return __enqueue_local(context, keys, nr);
+}
+
+/**
+* @brief Dequeues up to nr elements, from the shard of the calling CPU
+*		first, then stealing from the other shards and the spill
+*
+* Every shard is FIFO, there is no order between the shards. Only one
+* thread may dequeue at a time.
+*
+* @param context Context of the queue
+* @param keys Receives the dequeued values
+* @param nr Maximum number of elements to dequeue
+*
+* @return Number of dequeued elements or appropriate error codes on failure
+*/
+static int remove_batch_pcpu_queue(void *context, int *keys, int nr)
+{
+	int local = raw_smp_processor_id();
+	int count;
+	int cpu;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_pcpu_queue is NULL\n");
+		return -EINVAL;
+	}
+
+	// The local shard is the cheapest to drain, its lines are still here.
+	count = __dequeue_shard(context, local, keys, nr);
+
+	for_each_possible_cpu(cpu) {
+		if (count == nr)
+			break;
+
+		if (cpu != local)
+			count += __dequeue_shard(context, cpu, keys + count,
+								nr - count);
+	}
+
+	if (count < nr)
+		count += __dequeue_spill(context, keys + count, nr - count);
+
+	return count;
+}
+
+/**
+* @brief Releases the buffers of the shards and of the spill
+*
+* @param queue Context of the queue, its shards may be partly allocated
+*/
+static void __free_pcpu_queue(project2_pcpu_queue *queue)
+{
+	int cpu;
+
+	if (queue->shards) {
+		for_each_possible_cpu(cpu)
+			kvfree(per_cpu_ptr(queue->shards, cpu)->buf);
+
+		free_percpu(queue->shards);
+	}
+
+	kvfree(queue->spill_buf);
+	kfree(queue);
+}
+
+/**
+* @brief Initializes the context by splitting the capacity over one kfifo
+*		per online CPU, with a spill of the whole capacity behind them
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_pcpu_queue(int size, void **context)
+{
+	int qsize = project2_queue_size(size);
+	project2_pcpu_queue *queue;
+	project2_pcpu_shard *shard;
+	size_t shard_bytes;
+	int cpu;
+
+	if (qsize < 0) {
+		printk (KERN_INFO "integer overflow while getting power of 2\n");
+		return -EINVAL;
+	}
+
+	queue = kzalloc(sizeof(project2_pcpu_queue), GFP_KERNEL);
+	if (queue == NULL) {
+		printk (KERN_INFO "memory allocation for pcpu_queue failed\n");
+		return -ENOMEM;
+	}
+
+	spin_lock_init(&queue->spill_lock);
+
+	// kfifo_init needs a power of 2, qsize already is one.
+	shard_bytes = sizeof(int) *
+		roundup_pow_of_two(DIV_ROUND_UP(qsize, num_online_cpus()));
+
+	// Zeroed, so the shards of offline CPUs have no buffer.
+	queue->shards = alloc_percpu(project2_pcpu_shard);
+	if (queue->shards == NULL)
+		goto fail;
+
+	// A CPU coming online later has no shard and enqueues on the spill.
+	for_each_online_cpu(cpu) {
+		shard = per_cpu_ptr(queue->shards, cpu);
+
+		shard->buf = kvmalloc(shard_bytes, GFP_KERNEL);
+		if (shard->buf == NULL)
+			goto fail;
+
+		kfifo_init(&shard->fifo, shard->buf, shard_bytes);
+	}
+
+	queue->spill_buf = kvmalloc_array(qsize, sizeof(int), GFP_KERNEL);
+	if (queue->spill_buf == NULL)
+		goto fail;
+
+	kfifo_init(&queue->spill, queue->spill_buf, sizeof(int) * qsize);
+
+	*context = queue;
+	return 0;
+
+fail:
+	printk (KERN_INFO "memory allocation for pcpu_queue shards failed\n");
+
+	__free_pcpu_queue(queue);
+
+	return -ENOMEM;
+}
+
+/**
+* @brief Deallocates the context
+*
+* @param context Context for the queue
+*/
+static void deinit_pcpu_queue(void *context)
+{
+	if (context)
+		__free_pcpu_queue(context);
+}
+
+// Generates the handles for the pcpu_queue test-case
+PROJECT2_GENERATE_HANDLE(pcpu_queue,
+			PROJECT2_HANDLE_OP(pcpu_queue, add_batch),
+			PROJECT2_HANDLE_OP(pcpu_queue, remove_batch),
+			PROJECT2_HANDLE_FLAGS(pcpu_queue,
+					PROJECT2_HANDLE_MULTI_PRODUCER));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 per-CPU sharded queue built on kfifo\n");
@@ -12,7 +12,7 @@
 *
 * @return Ceiling power 2 for the input size
 */
-static int __get_queue_size(int size)
+int project2_queue_size(int size)
 {
 	int ret_size = 1;
 
@@ -35,16 +35,20 @@ static int __get_queue_size(int size)
 * @brief Add size number of random numbers to the queue
 *
 * @param context Context information for the queue
+* @param keys Keys to be inserted
 * @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
 *
 * @return 0 if successful otherwise appropriate error codes
 */
-static int add_queue(void *context, int size)
+static int add_queue(void *context, const int *keys, int size,
+						project2_hist *hist)
 {
 	int data;
 	int ret = 0;
 	struct kfifo *my_queue = (struct kfifo *)context;
 	int tmp_size = size;
+	u64 start;
 
 	if (!context) {
 		printk(KERN_INFO "context to enqueue is NULL\n");
@@ -53,19 +57,26 @@ static int add_queue(void *context, int size)
 
 	while (tmp_size--) {
 
-		data = project2_get_next_integer(size);
+		if (project2_yield(size - tmp_size - 1))
+			return -EINTR;
+
+		data = keys[size - tmp_size - 1];
+
+		start = project2_time_start(hist);
 
 		ret = kfifo_in(my_queue, &data, sizeof(int));
 
+		project2_time_end(hist, start);
+
 		if (ret != sizeof(int)) {
 			printk(KERN_INFO "enqueue failed due to less space\n");
 			return -ENOMEM;
 		}
 
-		printk(KERN_INFO "ENQUEUE: %d\n", data);
+		PROJECT2_TRACE(tmp_size, "ENQUEUE: %d\n", data);
 	}
 
-	printk(KERN_INFO "\n");
+	PROJECT2_TRACE(0, "\n");
 
 	return 0;
 }
@@ -74,8 +85,9 @@ static int add_queue(void *context, int size)
 * @brief Prints the contents of the queue
 *
 * @param context Context of the queue
+* @param hist Histogram for per element latency, may be NULL
 */
-static void show_queue(void *context)
+static void show_queue(void *context, project2_hist *hist)
 {
 	// not implemented
 }
@@ -84,14 +96,17 @@ static void show_queue(void *context)
 * @brief Dequeues the entire queue.
 *
 * @param context Context of the queue.
+* @param hist Histogram for per element latency, may be NULL
 *
 * @return 0 for success and appropriate error codes on failure
 */
-static int remove_queue(void *context)
+static int remove_queue(void *context, project2_hist *hist)
 {
 	int data;
 	int ret = 0;
 	struct kfifo *my_queue = (struct kfifo *)context;
+	unsigned long index = 0;
+	u64 start;
 
 
 	if (!context) {
@@ -101,21 +116,78 @@ static int remove_queue(void *context)
 
 	while (!kfifo_is_empty(my_queue)) {
 
+		start = project2_time_start(hist);
+
 		ret = kfifo_out(my_queue, &data, sizeof(int));
 
+		project2_time_end(hist, start);
+
 		if (ret != sizeof(int)) {
 			printk(KERN_INFO "dequeue failed due to less space in queue\n");
 			return -ENOMEM;
 		}
 
-		printk(KERN_INFO "DEQUEUE: %d\n", data);
+		PROJECT2_TRACE(index++, "DEQUEUE: %d\n", data);
+
+		project2_yield(index);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Enqueues nr keys with a single kfifo_in
+*
+* @param context Context of the queue
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int add_batch_queue(void *context, const int *keys, int nr)
+{
+	struct kfifo *my_queue = (struct kfifo *)context;
+	unsigned int len = nr * sizeof(int);
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_queue is NULL\n");
+		return -EINVAL;
+	}
+
+	// Refuse partial batches so that the queue never splits an integer.
+	if (kfifo_avail(my_queue) < len) {
+		printk(KERN_INFO "enqueue failed due to less space\n");
+		return -ENOMEM;
 	}
 
-	printk(KERN_INFO "\n");
+	kfifo_in(my_queue, keys, len);
 
 	return 0;
 }
 
+/**
+* @brief Dequeues up to nr elements with a single kfifo_out
+*
+* @param context Context of the queue
+* @param keys Receives the dequeued values
+* @param nr Maximum number of elements to dequeue
+*
+* @return Number of dequeued elements or appropriate error codes on failure
+*/
+static int remove_batch_queue(void *context, int *keys, int nr)
+{
+	struct kfifo *my_queue = (struct kfifo *)context;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_queue is NULL\n");
+		return -EINVAL;
+	}
+
+	return kfifo_out(my_queue, keys, nr * sizeof(int)) / sizeof(int);
+}
+
 /**
 * @brief Initializes the context by adding a queue object for the test
 *
@@ -127,7 +199,7 @@ static int remove_queue(void *context)
 static int init_queue(int size, void **context)
 {
 	// Get the ceiling power 2 for the size.
-	int qsize = __get_queue_size(size);
+	int qsize = project2_queue_size(size);
 	struct kfifo *my_queue;
 
 	if (qsize < 0) {
@@ -168,7 +240,9 @@ static void deinit_queue(void *context)
 }
 
 // Generates the handles for the queue test-case
-PROJECT2_GENERATE_HANDLE(queue);
+PROJECT2_GENERATE_HANDLE(queue,
+			PROJECT2_HANDLE_OP(queue, add_batch),
+			PROJECT2_HANDLE_OP(queue, remove_batch));
 
 // Module related macros
 MODULE_LICENSE("GPL");
@@ -1,6 +1,10 @@
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/rbtree.h>
+#include <linux/rbtree_augmented.h>
+#include <linux/mm.h>
+#include <linux/log2.h>
+#include <linux/sort.h>
 #include "project2.h"
 
 
@@ -10,7 +14,10 @@
 typedef struct project2_rbtree_context_t {
 	int start; /*Start of the range (INCLUSIVE) */
 	int end;  /*End of the range (INCLUSIVE) */
-	struct rb_root root; /*Root for the Red-Black tree */
+	struct rb_root_cached root; /*Root for the Red-Black tree */
+	bool cached; /*Keeps root.rb_leftmost up to date for rb_first_cached */
+	struct my_rbnode_t *bulk; /*Nodes of the last build, one array */
+	int nr_bulk; /*Number of nodes in bulk */
 } project2_rbtree_context;
 
 
@@ -22,21 +29,99 @@ typedef struct my_rbnode_t {
 	struct rb_node rbnode; /*Holds Meta-Data for Red-Black Node */
 } my_rbnode;
 
+/**
+* @brief Helper API to release an erased node. Nodes of a build stay in
+*		their array until the whole tree is removed.
+*
+* @param rbtree_context Context of the Red-Black Tree
+* @param batch Batch of the rbtree pool
+* @param node Node which has been erased
+*/
+static void __put_rbtree_node(project2_rbtree_context *rbtree_context,
+			project2_pool_batch *batch, my_rbnode *node)
+{
+	if (node >= rbtree_context->bulk &&
+			node < rbtree_context->bulk + rbtree_context->nr_bulk)
+		return;
+
+	project2_pool_put(batch, node);
+}
+
+/**
+* @brief Allocator for the Red-Black tree nodes
+*/
+project2_pool project2_rbtree_pool = PROJECT2_POOL_INIT("project2_rbnode",
+									my_rbnode);
+
+/**
+* @brief Helper API to link and rebalance a node in Red-Black Tree.
+*
+* @param rbtree_context Context of the Red-Black Tree
+* @param node Node which has to be linked
+* @param parent Parent of the node
+* @param link Child pointer of parent receiving the node
+* @param leftmost Whether the node becomes the smallest one of the tree
+*/
+static void __link_rbtree_node(project2_rbtree_context *rbtree_context,
+				struct rb_node *node, struct rb_node *parent,
+				struct rb_node **link, bool leftmost)
+{
+	rb_link_node(node, parent, link);
+
+	if (rbtree_context->cached)
+		rb_insert_color_cached(node, &rbtree_context->root, leftmost);
+	else
+		rb_insert_color(node, &rbtree_context->root.rb_root);
+}
+
+/**
+* @brief Helper API to erase a node from Red-Black Tree.
+*
+* @param rbtree_context Context of the Red-Black Tree
+* @param node Node which has to be erased
+*/
+static void __erase_rbtree_node(project2_rbtree_context *rbtree_context,
+							struct rb_node *node)
+{
+	if (rbtree_context->cached)
+		rb_erase_cached(node, &rbtree_context->root);
+	else
+		rb_erase(node, &rbtree_context->root.rb_root);
+}
+
+/**
+* @brief Helper API to get the smallest node of Red-Black Tree, O(1) for
+*		the cached tree and a descent from the root otherwise.
+*
+* @param rbtree_context Context of the Red-Black Tree
+*
+* @return Smallest node or NULL if the tree is empty
+*/
+static struct rb_node *__first_rbtree_node(project2_rbtree_context *rbtree_context)
+{
+	if (rbtree_context->cached)
+		return rb_first_cached(&rbtree_context->root);
+
+	return rb_first(&rbtree_context->root.rb_root);
+}
+
 /**
 * @brief Helper API to perform insertion in Red-Black Tree.
 *
-* @param root Root for the Red-Black Tree
+* @param rbtree_context Context of the Red-Black Tree
 * @param entry Node which has to be inserted
 *
 * @return 0 for success and appropriate error codes for failure
 */
-static int __add_rbtree_node(struct rb_root *root, my_rbnode *entry)
+static int __add_rbtree_node(project2_rbtree_context *rbtree_context,
+							my_rbnode *entry)
 {
-	struct rb_node **link = &root->rb_node;
+	struct rb_node **link = &rbtree_context->root.rb_root.rb_node;
 	struct rb_node *parent = NULL;
 	my_rbnode *myentry;
+	bool leftmost = true;
 
-	if (root == NULL || entry == NULL) {
+	if (entry == NULL) {
 		printk("Invalid arguments passed to add helper routine\n");
 		return -EINVAL;
 	}
@@ -46,19 +131,52 @@ static int __add_rbtree_node(struct rb_root *root, my_rbnode *entry)
 		myentry = rb_entry(parent, my_rbnode, rbnode);
 		if (myentry->value > entry->value)
 			link = &(*link)->rb_left;
-		else if (myentry->value < entry->value)
+		else if (myentry->value < entry->value) {
 			link = &(*link)->rb_right;
-		else {
+			leftmost = false;
+		} else {
 			//Node with same value already exists
 			return -EEXIST;
 		}
 	}
-	rb_link_node(&entry->rbnode, parent, link);
-	rb_insert_color(&entry->rbnode, root);
+	__link_rbtree_node(rbtree_context, &entry->rbnode, parent, link,
+								leftmost);
 	return 0;
 }
 
 
+/**
+* @brief Helper API to insert a node which sorts after a known node.
+*
+* When entry falls between hint and its in-order successor and hint has no
+* right child, entry is linked there without a descent from the root.
+* Otherwise this falls back to __add_rbtree_node.
+*
+* @param rbtree_context Context of the Red-Black Tree
+* @param hint Node with a smaller value which is already in the tree, or NULL
+* @param entry Node which has to be inserted
+*
+* @return 0 for success and appropriate error codes for failure
+*/
+static int __add_rbtree_node_hint(project2_rbtree_context *rbtree_context,
+					my_rbnode *hint, my_rbnode *entry)
+{
+	struct rb_node *next;
+
+	if (hint && hint->value < entry->value && !hint->rbnode.rb_right) {
+		next = rb_next(&hint->rbnode);
+
+		if (!next || rb_entry(next, my_rbnode, rbnode)->value > entry->value) {
+			// A node right of hint is never the smallest one.
+			__link_rbtree_node(rbtree_context, &entry->rbnode,
+					&hint->rbnode, &hint->rbnode.rb_right, false);
+			return 0;
+		}
+	}
+
+	return __add_rbtree_node(rbtree_context, entry);
+}
+
 /**
 * @brief Helper function to find the node in the Red-Black Tree
 *
@@ -91,20 +209,107 @@ static struct rb_node* __find_node_rbtree (struct rb_root *root, int value)
 
 
 /**
-* @brief Add size number of Unique Random Integers to the tree
+* @brief Helper function to find the smallest node not below value
+*
+* @param root Root of the Red-Black Tree
+* @param value Lower bound of the search
+*
+* @return NULL if every node is below value, Address of the node otherwise
+*/
+static struct rb_node* __lower_bound_rbtree (struct rb_root *root, int value)
+{
+	struct rb_node *node = root->rb_node;
+	struct rb_node *bound = NULL;
+
+	while (node) {
+		if (rb_entry(node, my_rbnode, rbnode)->value >= value) {
+			bound = node;
+			node = node->rb_left;
+		} else
+			node = node->rb_right;
+	}
+	return bound;
+}
+
+/**
+* @brief Helper API to erase every node with a value in [start, end].
+*
+* Searches the lower bound once and then walks the successors, so it costs
+* O(log n + k) for k erased nodes regardless of the width of the range.
+*
+* @param rbtree_context Context of the Red-Black Tree
+* @param start Start of the range (INCLUSIVE)
+* @param end End of the range (INCLUSIVE)
+* @param batch Batch of the rbtree pool receiving the erased nodes
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return Number of erased nodes
+*/
+static int __erase_range_rbtree (project2_rbtree_context *rbtree_context,
+				int start, int end, project2_pool_batch *batch,
+				project2_hist *hist)
+{
+	struct rb_node *node;
+	struct rb_node *next;
+	my_rbnode *curr;
+	int count = 0;
+	u64 stamp;
+
+	stamp = project2_time_start(hist);
+
+	node = __lower_bound_rbtree(&rbtree_context->root.rb_root, start);
+
+	while (node) {
+		curr = rb_entry(node, my_rbnode, rbnode);
+		if (curr->value > end)
+			break;
+
+		// The successor stays valid across the erase of node.
+		next = rb_next(node);
+
+		__erase_rbtree_node(rbtree_context, node);
+
+		PROJECT2_TRACE(curr->value, "%d found and erased from rbtree\n",
+						curr->value);
+
+		__put_rbtree_node(rbtree_context, batch, curr);
+		count++;
+
+		project2_time_end(hist, stamp);
+
+		project2_yield(count);
+
+		stamp = project2_time_start(hist);
+
+		node = next;
+	}
+
+	return count;
+}
+
+/**
+* @brief Add size number of Random Integers to the tree, keys already
+*		present are skipped
 *
 * @param context Context information for the Red-Black Tree
+* @param keys Keys to be inserted
 * @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
 *
 * @return 0 if successful otherwise appropriate error codes
 */
-static int add_rbtree (void *context, int size)
+static int add_rbtree (void *context, const int *keys, int size,
+						project2_hist *hist)
 {
 	project2_rbtree_context *rbtree_context =
 							(project2_rbtree_context *) context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_rbtree_pool);
 	my_rbnode *tmp_node = NULL;
 	int tmp_size = size;
-	int ret;
+	int skipped = 0;
+	int data;
+	int ret = 0;
+	u64 start;
 
 	if (!context) {
 		printk(KERN_INFO "context to add_rbtree is NULL\n");
@@ -112,54 +317,92 @@ static int add_rbtree (void *context, int size)
 	}
 
 	while (tmp_size--) {
-		tmp_node = kmalloc(sizeof(my_rbnode), GFP_KERNEL);
+		if (project2_yield(size - tmp_size - 1)) {
+			ret = -EINTR;
+			break;
+		}
+
+		data = keys[size - tmp_size - 1];
+
+		start = project2_time_start(hist);
+
+		tmp_node = project2_pool_get(&batch, project2_gfp);
 
 		if (tmp_node == NULL) {
 			printk (KERN_INFO "memory allocation for rbtree node failed\n");
-			return -ENOMEM;
+			ret = -ENOMEM;
+			break;
 		}
 
-		// Retry if the node was already inserted earlier.
-		do {
-			tmp_node->value = project2_get_next_integer(size);
+		tmp_node->value = data;
+
+		ret = __add_rbtree_node(rbtree_context, tmp_node);
 
-			ret = __add_rbtree_node(&rbtree_context->root, tmp_node);
+		project2_time_end(hist, start);
 
-			if (ret == -EINVAL) {
-				kfree(tmp_node);
-				return -EINVAL;
-			}
-		} while (ret == -EEXIST);
+		// Skewed distributions repeat keys, the tree keeps one of each.
+		if (ret == -EEXIST) {
+			project2_pool_put(&batch, tmp_node);
+			skipped++;
+			ret = 0;
+			continue;
+		}
+
+		if (ret) {
+			project2_pool_put(&batch, tmp_node);
+			break;
+		}
 
-		printk(KERN_INFO "RBTREE_ADD: %d\n", tmp_node->value);
+		PROJECT2_TRACE(tmp_size, "RBTREE_ADD: %d\n", tmp_node->value);
 	}
-	printk(KERN_INFO "\n");
-	return 0;
+
+	// Release the nodes which were allocated in bulk but not used.
+	project2_pool_flush(&batch);
+
+	if (skipped)
+		printk(KERN_INFO "Skipped %d duplicate keys\n", skipped);
+
+	PROJECT2_TRACE(0, "\n");
+	return ret;
 }
 
 /**
 * @brief Prints the contents of the tree in INORDER
 *
 * @param context Context of the Red-Black Tree
+* @param hist Histogram for per element latency, may be NULL
 */
-static void show_rbtree (void *context)
+static void show_rbtree (void *context, project2_hist *hist)
 {
 	project2_rbtree_context *rbtree_context =
 								(project2_rbtree_context *) context;
 	struct rb_node *node;
+	unsigned long index = 0;
+	u64 start;
 
 	if (!context) {
 		printk(KERN_INFO "context to show_rbtree is NULL\n");
 		return;
 	}
 
+	start = project2_time_start(hist);
+
 	// Inorder traversal of the tree.
-	for (node = rb_first(&rbtree_context->root); node != NULL;
-			node = rb_next(node))
-		printk(KERN_INFO "RBTREE_SHOW: %d\n",
+	for (node = __first_rbtree_node(rbtree_context); node != NULL;
+			node = rb_next(node)) {
+		PROJECT2_TRACE(index++, "RBTREE_SHOW: %d\n",
 			rb_entry(node, my_rbnode, rbnode)->value);
 
-	printk(KERN_INFO "\n");
+		// Each sample covers the step to the node and its processing.
+		project2_time_end(hist, start);
+
+		if (project2_yield(index))
+			return;
+
+		start = project2_time_start(hist);
+	}
+
+	PROJECT2_TRACE(0, "\n");
 }
 
 /**
@@ -167,13 +410,16 @@ static void show_rbtree (void *context)
 *		range of the Context.
 *
 * @param context Context of the Red-Black Tree.
+* @param hist Histogram for per element latency, may be NULL
 *
 * @return 0 for success and appropriate error codes on failure
 */
-static int remove_rbtree (void *context)
+static int remove_rbtree (void *context, project2_hist *hist)
 {
-	int curr_index = 0;
-	struct rb_node *node;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_rbtree_pool);
+	int erased;
+	unsigned long index = 0;
+	u64 start;
 	my_rbnode *curr = NULL;
 	my_rbnode *next = NULL;
 	project2_rbtree_context *rbtree_context =
@@ -187,40 +433,329 @@ static int remove_rbtree (void *context)
 	printk("Search and Erase over [%d,%d]\n",
 			rbtree_context->start, rbtree_context->end);
 
-	// Traverse across the range and erase any found node.
-	for (curr_index = rbtree_context->start;
-			curr_index <= rbtree_context->end; curr_index++) {
+	// Erase only the nodes present in the range.
+	erased = __erase_range_rbtree(rbtree_context, rbtree_context->start,
+					rbtree_context->end, &batch, hist);
 
-		node = __find_node_rbtree(&rbtree_context->root, curr_index);
+	printk(KERN_INFO "Erased %d nodes in [%d,%d]\n", erased,
+			rbtree_context->start, rbtree_context->end);
 
-		if (node == NULL)
-			printk(KERN_INFO "%d not found in the rbtree\n", curr_index);
-		else {
-			curr = rb_entry(node, my_rbnode, rbnode);
+	PROJECT2_TRACE(0, "\nUpdated tree after previous erase\n");
+	// Show the updated tree.
+	show_rbtree(context, NULL);
+
+	// Remove the entire tree.
+	start = project2_time_start(hist);
+
+	rbtree_postorder_for_each_entry_safe(curr, next,
+						&rbtree_context->root.rb_root, rbnode) {
+		PROJECT2_TRACE(index++, "RBTREE_REMOVE: %d\n", curr->value);
+		__put_rbtree_node(rbtree_context, &batch, curr);
+
+		project2_time_end(hist, start);
+
+		project2_yield(index);
+
+		start = project2_time_start(hist);
+	}
+
+	project2_pool_flush(&batch);
+
+	kvfree(rbtree_context->bulk);
+	rbtree_context->bulk = NULL;
+	rbtree_context->nr_bulk = 0;
+
+	// Required so that next show_rbtree cannot traverse the tree.
+	rbtree_context->root = RB_ROOT_CACHED;
+
+	show_rbtree(context, NULL);
+
+	return 0;
+}
 
-			rb_erase(node, &rbtree_context->root);
+/**
+* @brief Inserts nr keys in ascending order, every insert starting from
+*		the previously inserted node.
+*
+* @param context Context of the Red-Black Tree
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success, -EEXIST if some keys were already present or
+*		appropriate error codes on failure
+*/
+static int add_batch_rbtree (void *context, const int *keys, int nr)
+{
+	project2_rbtree_context *rbtree_context =
+							(project2_rbtree_context *) context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_rbtree_pool);
+	my_rbnode *hint = NULL;
+	my_rbnode *tmp_node;
+	int *sorted;
+	int ret = 0;
+	int err;
+	int i;
 
-			kfree(curr);
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_rbtree is NULL\n");
+		return -EINVAL;
+	}
+
+	sorted = kmalloc_array(nr, sizeof(int), project2_gfp);
+	if (sorted == NULL) {
+		printk (KERN_INFO "memory allocation for rbtree batch failed\n");
+		return -ENOMEM;
+	}
+
+	memcpy(sorted, keys, nr * sizeof(int));
+	sort(sorted, nr, sizeof(int), project2_cmp_int, NULL);
 
-			printk(KERN_INFO "%d found and erased from rbtree\n", curr_index);
+	for (i = 0; i < nr; i++) {
+		tmp_node = project2_pool_get(&batch, project2_gfp);
+		if (tmp_node == NULL) {
+			ret = -ENOMEM;
+			break;
 		}
+
+		tmp_node->value = sorted[i];
+
+		err = __add_rbtree_node_hint(rbtree_context, hint, tmp_node);
+		if (err) {
+			project2_pool_put(&batch, tmp_node);
+			ret = err;
+			continue;
+		}
+
+		hint = tmp_node;
 	}
 
-	printk(KERN_INFO "\nUpdated tree after previous erase\n");
-	// Show the updated tree.
-	show_rbtree(context);
+	project2_pool_flush(&batch);
 
-	// Remove the entire tree.
-	rbtree_postorder_for_each_entry_safe(curr, next,
-								&rbtree_context->root, rbnode) {
-		printk(KERN_INFO "RBTREE_REMOVE: %d\n", curr->value);
-		kfree(curr);
+	kfree(sorted);
+
+	return ret;
+}
+
+/**
+* @brief Removes up to nr of the smallest keys from the tree
+*
+* @param context Context of the Red-Black Tree
+* @param keys Receives the removed keys in ascending order
+* @param nr Maximum number of keys to remove
+*
+* @return Number of removed keys or appropriate error codes on failure
+*/
+static int remove_batch_rbtree (void *context, int *keys, int nr)
+{
+	project2_rbtree_context *rbtree_context =
+							(project2_rbtree_context *) context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_rbtree_pool);
+	struct rb_node *node;
+	my_rbnode *curr;
+	int count;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_rbtree is NULL\n");
+		return -EINVAL;
 	}
 
-	// Required so that next show_rbtree cannot traverse the tree.
-	rbtree_context->root = RB_ROOT;
+	for (count = 0; count < nr; count++) {
+		node = __first_rbtree_node(rbtree_context);
+		if (node == NULL)
+			break;
+
+		curr = rb_entry(node, my_rbnode, rbnode);
+		keys[count] = curr->value;
+
+		__erase_rbtree_node(rbtree_context, node);
+		__put_rbtree_node(rbtree_context, &batch, curr);
+	}
+
+	project2_pool_flush(&batch);
 
-	show_rbtree(context);
+	return count;
+}
+
+/**
+* @brief Erases every key in [start, end] from the tree
+*
+* @param context Context of the Red-Black Tree
+* @param start Start of the range (INCLUSIVE)
+* @param end End of the range (INCLUSIVE)
+*
+* @return Number of erased keys or appropriate error codes on failure
+*/
+static int remove_range_rbtree (void *context, int start, int end)
+{
+	project2_rbtree_context *rbtree_context =
+							(project2_rbtree_context *) context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_rbtree_pool);
+	int erased;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_range_rbtree is NULL\n");
+		return -EINVAL;
+	}
+
+	erased = __erase_range_rbtree(rbtree_context, start, end, &batch, NULL);
+
+	project2_pool_flush(&batch);
+
+	return erased;
+}
+
+/**
+* @brief Searches the tree for key
+*
+* @param context Context of the Red-Black Tree
+* @param key Value to be searched
+*
+* @return true if key is present in the tree
+*/
+static bool lookup_rbtree (void *context, int key)
+{
+	project2_rbtree_context *rbtree_context =
+							(project2_rbtree_context *) context;
+
+	if (!context)
+		return false;
+
+	return __find_node_rbtree(&rbtree_context->root.rb_root, key) != NULL;
+}
+
+/**
+* @brief Reads the smallest key of the tree without removing it
+*
+* @param context Context of the Red-Black Tree
+* @param key Receives the smallest key
+*
+* @return 0 for success, -ENOENT if the tree is empty
+*/
+static int peek_min_rbtree (void *context, int *key)
+{
+	struct rb_node *node;
+
+	if (!context) {
+		printk(KERN_INFO "context to peek_min_rbtree is NULL\n");
+		return -EINVAL;
+	}
+
+	node = __first_rbtree_node(context);
+	if (node == NULL)
+		return -ENOENT;
+
+	*key = rb_entry(node, my_rbnode, rbnode)->value;
+
+	return 0;
+}
+
+/**
+* @brief Removes the smallest key of the tree
+*
+* @param context Context of the Red-Black Tree
+* @param key Receives the removed key
+*
+* @return 0 for success, -ENOENT if the tree is empty
+*/
+static int pop_min_rbtree (void *context, int *key)
+{
+	int ret = remove_batch_rbtree(context, key, 1);
+
+	if (ret < 0)
+		return ret;
+
+	return ret ? 0 : -ENOENT;
+}
+
+/**
+* @brief Helper API to link nodes[lo..hi] as a balanced subtree.
+*
+* Every subtree is split at its middle, so all the NULL links are at
+* depth h or h + 1 for h = ilog2(n). Coloring the nodes at depth h red and
+* all the others black gives every path h black nodes.
+*
+* @param nodes Nodes holding the sorted keys
+* @param lo First node of the subtree
+* @param hi Last node of the subtree (INCLUSIVE)
+* @param parent Parent of the subtree, NULL for the root
+* @param depth Depth of the root of the subtree
+* @param red_depth Depth of the red nodes, -1 for none
+*
+* @return Root of the subtree or NULL if it is empty
+*/
+static struct rb_node *__build_rbtree (my_rbnode *nodes, int lo, int hi,
+				struct rb_node *parent, int depth, int red_depth)
+{
+	struct rb_node *node;
+	int mid;
+
+	if (lo > hi)
+		return NULL;
+
+	mid = lo + (hi - lo) / 2;
+	node = &nodes[mid].rbnode;
+
+	rb_set_parent_color(node, parent,
+				depth == red_depth ? RB_RED : RB_BLACK);
+
+	node->rb_left = __build_rbtree(nodes, lo, mid - 1, node, depth + 1,
+								red_depth);
+	node->rb_right = __build_rbtree(nodes, mid + 1, hi, node, depth + 1,
+								red_depth);
+
+	return node;
+}
+
+/**
+* @brief Builds the tree from sorted keys in O(n), without any descent or
+*		rebalance. The nodes are laid out in one array in key order.
+*
+* @param context Context of the Red-Black Tree, which must be empty
+* @param keys Strictly increasing keys
+* @param nr Number of keys
+*
+* @return 0 for success, -EBUSY if the tree is not empty, -EINVAL if the
+*		keys are not strictly increasing or -ENOMEM
+*/
+static int build_rbtree (void *context, const int *keys, int nr)
+{
+	project2_rbtree_context *rbtree_context =
+							(project2_rbtree_context *) context;
+	my_rbnode *nodes;
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to build_rbtree is NULL\n");
+		return -EINVAL;
+	}
+
+	if (!RB_EMPTY_ROOT(&rbtree_context->root.rb_root) ||
+			rbtree_context->bulk)
+		return -EBUSY;
+
+	if (nr <= 0)
+		return nr ? -EINVAL : 0;
+
+	for (i = 1; i < nr; i++)
+		if (keys[i - 1] >= keys[i])
+			return -EINVAL;
+
+	// One array may not fit a kmalloc, so the build may sleep.
+	nodes = kvmalloc_array(nr, sizeof(my_rbnode), GFP_KERNEL);
+	if (nodes == NULL) {
+		printk (KERN_INFO "memory allocation for rbtree build failed\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nr; i++)
+		nodes[i].value = keys[i];
+
+	rbtree_context->root.rb_root.rb_node = __build_rbtree(nodes, 0, nr - 1,
+					NULL, 0, nr > 1 ? ilog2(nr) : -1);
+	rbtree_context->root.rb_leftmost = &nodes[0].rbnode;
+
+	rbtree_context->bulk = nodes;
+	rbtree_context->nr_bulk = nr;
 
 	return 0;
 }
@@ -232,8 +767,13 @@ static int remove_rbtree (void *context)
 */
 static void deinit_rbtree (void *context)
 {
-	if (context)
+	project2_rbtree_context *rbtree_context =
+							(project2_rbtree_context *) context;
+
+	if (context) {
+		kvfree(rbtree_context->bulk);
 		kfree(context);
+	}
 }
 
 /**
@@ -260,7 +800,10 @@ static int init_rbtree (int size, void **context)
 	rbtree_context->end = size;
 
 	// Initalizes the root.
-	rbtree_context->root = RB_ROOT;
+	rbtree_context->root = RB_ROOT_CACHED;
+	rbtree_context->cached = false;
+	rbtree_context->bulk = NULL;
+	rbtree_context->nr_bulk = 0;
 
 	*context = rbtree_context;
 
@@ -268,8 +811,56 @@ static int init_rbtree (int size, void **context)
 
 }
 
+/**
+* @brief Initializes the context of a tree which caches its leftmost node
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_rbtree_cached (int size, void **context)
+{
+	int ret = init_rbtree(size, context);
+
+	if (!ret)
+		((project2_rbtree_context *)*context)->cached = true;
+
+	return ret;
+}
+
+// The cached tree shares every other op, its context selects the caching.
+#define add_rbtree_cached add_rbtree
+#define remove_rbtree_cached remove_rbtree
+#define show_rbtree_cached show_rbtree
+#define deinit_rbtree_cached deinit_rbtree
+#define add_batch_rbtree_cached add_batch_rbtree
+#define remove_batch_rbtree_cached remove_batch_rbtree
+#define lookup_rbtree_cached lookup_rbtree
+#define remove_range_rbtree_cached remove_range_rbtree
+#define peek_min_rbtree_cached peek_min_rbtree
+#define pop_min_rbtree_cached pop_min_rbtree
+#define build_rbtree_cached build_rbtree
+
 // Generates the handles for the rbtree test-case
-PROJECT2_GENERATE_HANDLE(rbtree);
+PROJECT2_GENERATE_HANDLE(rbtree,
+			PROJECT2_HANDLE_OP(rbtree, add_batch),
+			PROJECT2_HANDLE_OP(rbtree, remove_batch),
+			PROJECT2_HANDLE_OP(rbtree, lookup),
+			PROJECT2_HANDLE_OP(rbtree, remove_range),
+			PROJECT2_HANDLE_OP(rbtree, peek_min),
+			PROJECT2_HANDLE_OP(rbtree, pop_min),
+			PROJECT2_HANDLE_OP(rbtree, build));
+
+// Generates the handles for the rbtree_cached test-case
+PROJECT2_GENERATE_HANDLE(rbtree_cached,
+			PROJECT2_HANDLE_OP(rbtree_cached, add_batch),
+			PROJECT2_HANDLE_OP(rbtree_cached, remove_batch),
+			PROJECT2_HANDLE_OP(rbtree_cached, lookup),
+			PROJECT2_HANDLE_OP(rbtree_cached, remove_range),
+			PROJECT2_HANDLE_OP(rbtree_cached, peek_min),
+			PROJECT2_HANDLE_OP(rbtree_cached, pop_min),
+			PROJECT2_HANDLE_OP(rbtree_cached, build));
 
 // Module related macros
 MODULE_LICENSE("GPL");
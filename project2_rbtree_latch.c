@@ -0,0 +1,516 @@
+#include <linux/module.h>
+#include <linux/rbtree_latch.h>
+#include <linux/rcupdate.h>
+#include <linux/spinlock.h>
+#include <linux/slab.h>
+#include "project2.h"
+
+/**
+* @brief Node of the latched Red-Black tree.
+*
+* The node is linked into both copies of the tree. A lookup may still be
+* searching the copy an erased node was taken out of, so erased nodes go
+* through kfree_rcu and are allocated with kmalloc rather than a pool.
+*/
+typedef struct project2_latch_node_t {
+	int value; /*Value to be stored */
+	struct latch_tree_node lt; /*One rb_node for each copy of the tree */
+	struct rcu_head rcu;
+} project2_latch_node;
+
+/**
+* @brief Context of the latched Red-Black tree
+*
+* Readers search whichever copy the seqcount says is stable and never
+* wait, the writer updates one copy after the other.
+*/
+typedef struct project2_rbtree_latch_context_t {
+	struct latch_tree_root root; /*seqcount and the two copies */
+	spinlock_t lock; /*Serializes the writers */
+} project2_rbtree_latch_context;
+
+/**
+* @brief Gets the node embedding a latch tree node
+*/
+static __always_inline project2_latch_node *__latch_entry(struct latch_tree_node *n)
+{
+	return container_of(n, project2_latch_node, lt);
+}
+
+/**
+* @brief Orders two nodes by value
+*/
+static __always_inline bool __latch_less(struct latch_tree_node *a,
+						struct latch_tree_node *b)
+{
+	return __latch_entry(a)->value < __latch_entry(b)->value;
+}
+
+/**
+* @brief Compares the searched key with the value of a node
+*/
+static __always_inline int __latch_comp(void *key, struct latch_tree_node *n)
+{
+	int value = *(int *)key;
+	int curr = __latch_entry(n)->value;
+
+	return (value > curr) - (value < curr);
+}
+
+/**
+* @brief Ordering of the latched Red-Black tree
+*/
+static const struct latch_tree_ops latch_ops = {
+	.less = __latch_less,
+	.comp = __latch_comp,
+};
+
+/**
+* @brief Gets the node of an rb_node of the first copy, NULL for NULL
+*
+* The writer walks the first copy in order, which the latch tree API
+* does not offer, only while it holds the writer lock.
+*/
+static project2_latch_node *__latch_rb_entry(struct rb_node *rb)
+{
+	return rb ? container_of(rb, project2_latch_node, lt.node[0]) : NULL;
+}
+
+/**
+* @brief Helper function to find the smallest node not below value in the
+*		first copy, called with the writer lock held
+*
+* @param latch_context Context of the tree
+* @param value Lower bound of the search
+*
+* @return NULL if every node is below value, Address of the node otherwise
+*/
+static project2_latch_node *__lower_bound_latch(
+			project2_rbtree_latch_context *latch_context, int value)
+{
+	struct rb_node *node = latch_context->root.tree[0].rb_node;
+	struct rb_node *bound = NULL;
+
+	while (node) {
+		if (__latch_rb_entry(node)->value >= value) {
+			bound = node;
+			node = node->rb_left;
+		} else
+			node = node->rb_right;
+	}
+
+	return __latch_rb_entry(bound);
+}
+
+/**
+* @brief Helper API to insert a value into both copies.
+*
+* Writers hold the lock across the duplicate search and both copy
+* updates, the allocation happens before it is taken.
+*
+* @param latch_context Context of the tree.
+* @param value Value which is to be inserted.
+*
+* @return 0 for success and appropriate error codes for failure
+*/
+static int __add_latch(project2_rbtree_latch_context *latch_context, int value)
+{
+	project2_latch_node *tmp;
+	int ret = 0;
+
+	tmp = kmalloc(sizeof(project2_latch_node), project2_gfp);
+
+	if (tmp == NULL) {
+		printk (KERN_INFO "memory allocation for rbtree_latch node failed\n");
+		return -ENOMEM;
+	}
+
+	tmp->value = value;
+
+	spin_lock(&latch_context->lock);
+
+	// The latch tree links duplicates, so they are refused up front.
+	if (latch_tree_find(&value, &latch_context->root, &latch_ops))
+		ret = -EEXIST;
+	else
+		latch_tree_insert(&tmp->lt, &latch_context->root, &latch_ops);
+
+	spin_unlock(&latch_context->lock);
+
+	if (ret)
+		kfree(tmp);
+
+	return ret;
+}
+
+/**
+* @brief Helper API to erase a node from both copies, called with the
+*		writer lock held. Readers may still see it until a grace period.
+*
+* @param latch_context Context of the tree.
+* @param node Node to be erased.
+*/
+static void __erase_latch(project2_rbtree_latch_context *latch_context,
+						project2_latch_node *node)
+{
+	latch_tree_erase(&node->lt, &latch_context->root, &latch_ops);
+	kfree_rcu(node, rcu);
+}
+
+/**
+* @brief Add size number of Random Integers to the tree, keys already
+*		present are skipped
+*
+* @param context Context information for the tree
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_rbtree_latch(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	int tmp_size = size;
+	int skipped = 0;
+	int data;
+	int ret = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_rbtree_latch is NULL\n");
+		return -EINVAL;
+	}
+
+	while (tmp_size--) {
+		if (project2_yield(size - tmp_size - 1)) {
+			ret = -EINTR;
+			break;
+		}
+
+		data = keys[size - tmp_size - 1];
+
+		start = project2_time_start(hist);
+
+		ret = __add_latch(context, data);
+
+		project2_time_end(hist, start);
+
+		if (ret == -EEXIST) {
+			skipped++;
+			ret = 0;
+			continue;
+		}
+
+		if (ret)
+			break;
+
+		PROJECT2_TRACE(tmp_size, "RBTREE_LATCH_ADD: %d\n", data);
+	}
+
+	if (skipped)
+		printk(KERN_INFO "Skipped %d duplicate keys\n", skipped);
+
+	PROJECT2_TRACE(0, "\n");
+
+	return ret;
+}
+
+/**
+* @brief Prints the contents of the tree in INORDER
+*
+* The first copy is walked under the writer lock, which is dropped every
+* PROJECT2_RESCHED_INTERVAL nodes to reschedule. The walk then carries on
+* from the next larger value, as the tree may have changed meanwhile.
+*
+* @param context Context of the tree
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_rbtree_latch(void *context, project2_hist *hist)
+{
+	project2_rbtree_latch_context *latch_context = context;
+	project2_latch_node *tmp;
+	struct rb_node *node;
+	unsigned long index = 0;
+	int value;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_rbtree_latch is NULL\n");
+		return;
+	}
+
+	spin_lock(&latch_context->lock);
+
+	start = project2_time_start(hist);
+
+	node = rb_first(&latch_context->root.tree[0]);
+
+	while (node != NULL) {
+		value = __latch_rb_entry(node)->value;
+
+		PROJECT2_TRACE(index++, "RBTREE_LATCH_SHOW: %d\n", value);
+
+		project2_time_end(hist, start);
+
+		if (index % PROJECT2_RESCHED_INTERVAL) {
+			node = rb_next(node);
+		} else {
+			spin_unlock(&latch_context->lock);
+
+			if (project2_yield(index))
+				return;
+
+			spin_lock(&latch_context->lock);
+
+			tmp = value < INT_MAX ?
+				__lower_bound_latch(latch_context, value + 1) : NULL;
+			node = tmp ? &tmp->lt.node[0] : NULL;
+		}
+
+		start = project2_time_start(hist);
+	}
+
+	spin_unlock(&latch_context->lock);
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Removes the entire tree, the nodes are freed after a grace period.
+*
+* @param context Context of the tree.
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_rbtree_latch(void *context, project2_hist *hist)
+{
+	project2_rbtree_latch_context *latch_context = context;
+	project2_latch_node *tmp;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_rbtree_latch is NULL\n");
+		return -EINVAL;
+	}
+
+	for (;;) {
+		start = project2_time_start(hist);
+
+		spin_lock(&latch_context->lock);
+
+		tmp = __latch_rb_entry(rb_first(&latch_context->root.tree[0]));
+		if (tmp) {
+			PROJECT2_TRACE(index++, "RBTREE_LATCH_DEL: %d\n", tmp->value);
+			__erase_latch(latch_context, tmp);
+		}
+
+		spin_unlock(&latch_context->lock);
+
+		if (tmp == NULL)
+			break;
+
+		project2_time_end(hist, start);
+
+		project2_yield(index);
+	}
+
+	show_rbtree_latch(context, NULL);
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Inserts nr keys one by one, safe against other writers and
+*		readers
+*
+* @param context Context of the tree
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success, -EEXIST if some keys were already present or
+*		appropriate error codes on failure
+*/
+static int add_batch_rbtree_latch(void *context, const int *keys, int nr)
+{
+	int ret = 0;
+	int err;
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_rbtree_latch is NULL\n");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < nr; i++) {
+		err = __add_latch(context, keys[i]);
+
+		if (err == -EEXIST) {
+			ret = err;
+			continue;
+		}
+
+		if (err)
+			return err;
+	}
+
+	return ret;
+}
+
+/**
+* @brief Removes up to nr of the smallest keys from the tree
+*
+* @param context Context of the tree
+* @param keys Receives the removed keys in ascending order
+* @param nr Maximum number of keys to remove
+*
+* @return Number of removed keys or appropriate error codes on failure
+*/
+static int remove_batch_rbtree_latch(void *context, int *keys, int nr)
+{
+	project2_rbtree_latch_context *latch_context = context;
+	project2_latch_node *tmp;
+	int count;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_rbtree_latch is NULL\n");
+		return -EINVAL;
+	}
+
+	spin_lock(&latch_context->lock);
+
+	for (count = 0; count < nr; count++) {
+		tmp = __latch_rb_entry(rb_first(&latch_context->root.tree[0]));
+		if (tmp == NULL)
+			break;
+
+		keys[count] = tmp->value;
+		__erase_latch(latch_context, tmp);
+	}
+
+	spin_unlock(&latch_context->lock);
+
+	return count;
+}
+
+/**
+* @brief Erases every key in [start, end] from the tree
+*
+* @param context Context of the tree
+* @param start Start of the range (INCLUSIVE)
+* @param end End of the range (INCLUSIVE)
+*
+* @return Number of erased keys or appropriate error codes on failure
+*/
+static int remove_range_rbtree_latch(void *context, int start, int end)
+{
+	project2_rbtree_latch_context *latch_context = context;
+	project2_latch_node *curr;
+	project2_latch_node *next;
+	int count = 0;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_range_rbtree_latch is NULL\n");
+		return -EINVAL;
+	}
+
+	spin_lock(&latch_context->lock);
+
+	curr = __lower_bound_latch(latch_context, start);
+
+	while (curr && curr->value <= end) {
+		// The successor stays valid across the erase of curr.
+		next = __latch_rb_entry(rb_next(&curr->lt.node[0]));
+
+		__erase_latch(latch_context, curr);
+		count++;
+
+		curr = next;
+	}
+
+	spin_unlock(&latch_context->lock);
+
+	return count;
+}
+
+/**
+* @brief Searches the tree for key without waiting for the writer
+*
+* @param context Context of the tree
+* @param key Value to be searched
+*
+* @return true if key is present in the tree
+*/
+static bool lookup_rbtree_latch(void *context, int key)
+{
+	project2_rbtree_latch_context *latch_context = context;
+	bool found;
+
+	if (!context)
+		return false;
+
+	// RCU keeps the erased nodes alive for the copy being searched.
+	rcu_read_lock();
+	found = latch_tree_find(&key, &latch_context->root, &latch_ops) != NULL;
+	rcu_read_unlock();
+
+	return found;
+}
+
+/**
+* @brief Initializes the context with two empty copies of the tree
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_rbtree_latch(int size, void **context)
+{
+	// Zeroed, which is an even seqcount and two empty roots.
+	project2_rbtree_latch_context *latch_context =
+		kzalloc(sizeof(project2_rbtree_latch_context), GFP_KERNEL);
+
+	if (latch_context == NULL) {
+		printk (KERN_INFO "memory allocation for rbtree_latch context failed\n");
+		return -ENOMEM;
+	}
+
+	spin_lock_init(&latch_context->lock);
+
+	*context = latch_context;
+
+	return 0;
+}
+
+/**
+* @brief Deallocates the context
+*
+* The tree is empty by now. Erased nodes still waiting for their grace
+* period do not point back into the context, so it is freed right away.
+*
+* @param context Context for the tree
+*/
+static void deinit_rbtree_latch(void *context)
+{
+	if (context)
+		kfree(context);
+}
+
+// Generates the handles for the rbtree_latch test-case
+PROJECT2_GENERATE_HANDLE(rbtree_latch,
+			PROJECT2_HANDLE_OP(rbtree_latch, add_batch),
+			PROJECT2_HANDLE_OP(rbtree_latch, remove_batch),
+			PROJECT2_HANDLE_OP(rbtree_latch, lookup),
+			PROJECT2_HANDLE_OP(rbtree_latch, remove_range),
+			PROJECT2_HANDLE_FLAGS(rbtree_latch,
+					PROJECT2_HANDLE_THREAD_SAFE));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 latched rbtree with wait-free lookups\n");
@@ -0,0 +1,427 @@
+#include <linux/module.h>
+#include <linux/rculist.h>
+#include <linux/rcupdate.h>
+#include <linux/spinlock.h>
+#include <linux/slab.h>
+#include "project2.h"
+
+/**
+* @brief Node of the RCU protected list.
+*
+* The nodes come from kmalloc as kfree_rcu can only free those.
+*/
+typedef struct project2_rculist_t {
+	int data;
+	struct list_head list;
+	struct rcu_head rcu;
+} project2_rculist;
+
+/**
+* @brief Context of the RCU protected list
+*/
+typedef struct project2_rculist_head_t {
+	struct list_head head; /*Head of the list, walked under RCU */
+	spinlock_t lock; /*Serializes the writers */
+	unsigned long nr_removed; /*Nodes unlinked so far, under lock */
+} project2_rculist_head;
+
+/**
+* @brief Helper API to publish a new node at the tail of the list.
+*
+* The node is allocated before the writer lock is taken, so the lock is
+* only held for the pointer updates.
+*
+* @param context Context of the list.
+* @param data Data which is to be inserted.
+*
+* @return 0 for success and appropriate error codes for failure
+*/
+static int __add_rculist(project2_rculist_head *context, int data)
+{
+	project2_rculist *tmp;
+
+	tmp = kmalloc(sizeof(project2_rculist), project2_gfp);
+
+	if (tmp == NULL) {
+		printk (KERN_INFO "memory allocation for rculist addition failed\n");
+		return -ENOMEM;
+	}
+
+	tmp->data = data;
+
+	spin_lock(&context->lock);
+	list_add_tail_rcu(&tmp->list, &context->head);
+	spin_unlock(&context->lock);
+
+	return 0;
+}
+
+/**
+* @brief Helper API to unlink the oldest node of the list.
+*
+* @param context Context of the list.
+*
+* @return Unlinked node, freed by the caller after a grace period, or NULL
+*		if the list is empty
+*/
+static project2_rculist *__pop_rculist(project2_rculist_head *context)
+{
+	project2_rculist *tmp;
+
+	spin_lock(&context->lock);
+
+	tmp = list_first_entry_or_null(&context->head, project2_rculist, list);
+	if (tmp) {
+		list_del_rcu(&tmp->list);
+		context->nr_removed++;
+	}
+
+	spin_unlock(&context->lock);
+
+	return tmp;
+}
+
+/**
+* @brief Add size number of random numbers to the list
+*
+* @param context Context information for the list
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_rculist(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	int data;
+	int ret = 0;
+	int tmp_size = size;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_rculist is NULL\n");
+		return -EINVAL;
+	}
+
+	while (tmp_size--) {
+
+		if (project2_yield(size - tmp_size - 1)) {
+			ret = -EINTR;
+			break;
+		}
+
+		data = keys[size - tmp_size - 1];
+
+		start = project2_time_start(hist);
+
+		ret = __add_rculist(context, data);
+
+		project2_time_end(hist, start);
+
+		if (ret)
+			break;
+
+		PROJECT2_TRACE(tmp_size, "RCULIST_ADD: %d\n", data);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+
+	return ret;
+}
+
+/**
+* @brief Helper API to get the nth node of the list, called under RCU
+*
+* @param rhead Context of the list.
+* @param n Number of nodes to skip from the head.
+*
+* @return Link of the node or the head if the list is shorter
+*/
+static struct list_head *__nth_rculist(project2_rculist_head *rhead,
+						unsigned long n)
+{
+	struct list_head *pos = rcu_dereference(list_next_rcu(&rhead->head));
+
+	while (n-- && pos != &rhead->head)
+		pos = rcu_dereference(list_next_rcu(pos));
+
+	return pos;
+}
+
+/**
+* @brief Prints the contents of the list from head
+*
+* The RCU read-side section is left every PROJECT2_RESCHED_INTERVAL nodes
+* to reschedule. The walk resumes after the last node if no node was
+* unlinked meanwhile, otherwise at the same position from the head.
+*
+* @param context Context of the list
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_rculist(void *context, project2_hist *hist)
+{
+	project2_rculist_head *rhead = context;
+	project2_rculist *tmp;
+	struct list_head *pos;
+	unsigned long index = 0;
+	unsigned long removed;
+	bool linked;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_rculist is NULL\n");
+		return;
+	}
+
+	rcu_read_lock();
+
+	start = project2_time_start(hist);
+
+	pos = __nth_rculist(rhead, 0);
+
+	while (pos != &rhead->head) {
+		tmp = list_entry(pos, project2_rculist, list);
+
+		PROJECT2_TRACE(index++, "RCULIST_SHOW: %d\n", tmp->data);
+
+		// Each sample covers the step to the node and its processing.
+		project2_time_end(hist, start);
+
+		if (index % PROJECT2_RESCHED_INTERVAL) {
+			pos = rcu_dereference(list_next_rcu(pos));
+		} else {
+			// The writers count every node they unlink, so the
+			// node is still linked if the count has not moved.
+			spin_lock(&rhead->lock);
+			linked = tmp->list.prev != LIST_POISON2;
+			removed = rhead->nr_removed;
+			spin_unlock(&rhead->lock);
+
+			rcu_read_unlock();
+
+			if (project2_yield(index))
+				return;
+
+			rcu_read_lock();
+
+			spin_lock(&rhead->lock);
+			linked &= removed == rhead->nr_removed;
+			spin_unlock(&rhead->lock);
+
+			pos = linked ? rcu_dereference(list_next_rcu(pos)) :
+					__nth_rculist(rhead, index);
+		}
+
+		start = project2_time_start(hist);
+	}
+
+	rcu_read_unlock();
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Removes the entire list, the nodes are freed after a grace period.
+*
+* @param context Context of the list.
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_rculist(void *context, project2_hist *hist)
+{
+	project2_rculist *tmp;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_rculist is NULL\n");
+		return -EINVAL;
+	}
+
+	for (;;) {
+		start = project2_time_start(hist);
+
+		tmp = __pop_rculist(context);
+		if (tmp == NULL)
+			break;
+
+		PROJECT2_TRACE(index++, "RCULIST_DEL: %d\n", tmp->data);
+		kfree_rcu(tmp, rcu);
+
+		project2_time_end(hist, start);
+
+		project2_yield(index);
+	}
+
+	show_rculist(context, NULL);
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Appends nr keys to the list under a single writer lock
+*
+* @param context Context of the list
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int add_batch_rculist(void *context, const int *keys, int nr)
+{
+	project2_rculist_head *rhead = context;
+	project2_rculist *tmp;
+	project2_rculist *next;
+	LIST_HEAD(staging);
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_rculist is NULL\n");
+		return -EINVAL;
+	}
+
+	// Allocate everything first so that the lock is not held across it.
+	for (i = 0; i < nr; i++) {
+		tmp = kmalloc(sizeof(project2_rculist), project2_gfp);
+		if (tmp == NULL)
+			break;
+
+		tmp->data = keys[i];
+		list_add_tail(&tmp->list, &staging);
+	}
+
+	// Readers may see the nodes as soon as they are linked one by one.
+	spin_lock(&rhead->lock);
+	list_for_each_entry_safe(tmp, next, &staging, list)
+		list_add_tail_rcu(&tmp->list, &rhead->head);
+	spin_unlock(&rhead->lock);
+
+	return i == nr ? 0 : -ENOMEM;
+}
+
+/**
+* @brief Removes up to nr elements from the head of the list
+*
+* @param context Context of the list
+* @param keys Receives the removed values
+* @param nr Maximum number of elements to remove
+*
+* @return Number of removed elements or appropriate error codes on failure
+*/
+static int remove_batch_rculist(void *context, int *keys, int nr)
+{
+	project2_rculist_head *rhead = context;
+	project2_rculist *curr;
+	project2_rculist *next;
+	int count = 0;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_rculist is NULL\n");
+		return -EINVAL;
+	}
+
+	spin_lock(&rhead->lock);
+
+	list_for_each_entry_safe(curr, next, &rhead->head, list) {
+		if (count == nr)
+			break;
+
+		keys[count++] = curr->data;
+		list_del_rcu(&curr->list);
+		kfree_rcu(curr, rcu);
+	}
+
+	rhead->nr_removed += count;
+
+	spin_unlock(&rhead->lock);
+
+	return count;
+}
+
+/**
+* @brief Searches the list for key without taking any lock
+*
+* @param context Context of the list
+* @param key Value to be searched
+*
+* @return true if key is present in the list
+*/
+static bool lookup_rculist(void *context, int key)
+{
+	project2_rculist_head *rhead = context;
+	project2_rculist *tmp;
+	bool found = false;
+
+	if (!context)
+		return false;
+
+	rcu_read_lock();
+
+	list_for_each_entry_rcu(tmp, &rhead->head, list) {
+		if (tmp->data == key) {
+			found = true;
+			break;
+		}
+	}
+
+	rcu_read_unlock();
+
+	return found;
+}
+
+/**
+* @brief Initializes the context by adding a head for the test
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_rculist(int size, void **context)
+{
+	project2_rculist_head *rhead = kmalloc(sizeof(project2_rculist_head),
+								GFP_KERNEL);
+
+	if (rhead == NULL) {
+		printk (KERN_INFO "memory allocation for rculist head failed\n");
+		return -ENOMEM;
+	}
+
+	INIT_LIST_HEAD(&rhead->head);
+	spin_lock_init(&rhead->lock);
+	rhead->nr_removed = 0;
+
+	*context = rhead;
+
+	return 0;
+}
+
+/**
+* @brief Deallocates the context
+*
+* The list is empty by now, kfree_rcu does not call back into the module
+* so the pending frees need no rcu_barrier.
+*
+* @param context Context for the List
+*/
+static void deinit_rculist(void *context)
+{
+	if (context)
+		kfree(context);
+}
+
+// Generates the handles for the rculist test-case
+PROJECT2_GENERATE_HANDLE(rculist,
+			PROJECT2_HANDLE_OP(rculist, add_batch),
+			PROJECT2_HANDLE_OP(rculist, remove_batch),
+			PROJECT2_HANDLE_OP(rculist, lookup),
+			PROJECT2_HANDLE_FLAGS(rculist, PROJECT2_HANDLE_THREAD_SAFE));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 RCU protected list with lockless readers\n");
@@ -0,0 +1,626 @@
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/err.h>
+#include <linux/atomic.h>
+#include <linux/rhashtable.h>
+#include "project2.h"
+
+/**
+* @brief Node of the resizable hash table.
+*
+* rhashtable_lookup_fast may still hold a node removed by another thread,
+* so removed nodes are released with kfree_rcu and come from kmalloc.
+*/
+typedef struct project2_rhash_node_t {
+	int value; /*Value to be stored, the key of the table */
+	struct rhash_head head; /*Links the node into its bucket */
+	struct rcu_head rcu;
+} project2_rhash_node;
+
+/**
+* @brief Context of the resizable hash table
+*
+* The table grows and shrinks in a worker, inserts keep going into the
+* new table while the worker moves the buckets. The resize figures are
+* atomics as the writers of the concurrent benches update them unlocked.
+*/
+typedef struct project2_rhashtable_context_t {
+	struct rhashtable ht;
+	bool ready; /*Set while ht is initialized */
+	atomic_t size; /*Buckets seen by the last insert */
+	atomic_t nr_resizes; /*Changes of the bucket count seen by inserts */
+	atomic_t nr_paused; /*Inserts which ran while a resize was going on */
+	atomic64_t max_pause_ns; /*Longest of those inserts */
+	atomic64_t pause_ns; /*Sum of those inserts */
+} project2_rhashtable_context;
+
+/**
+* @brief Layout of the node and growth policy of the table
+*/
+static const struct rhashtable_params rhash_params = {
+	.key_len = sizeof(int),
+	.key_offset = offsetof(project2_rhash_node, value),
+	.head_offset = offsetof(project2_rhash_node, head),
+	.automatic_shrinking = true,
+};
+
+/**
+* @brief Reads the bucket count of the table and whether it is being
+*		moved to a new table
+*
+* @param rhash_context Context of the table
+* @param size Receives the number of buckets
+*
+* @return true if a resize is going on
+*/
+static bool __rhash_resizing(project2_rhashtable_context *rhash_context,
+						unsigned int *size)
+{
+	struct bucket_table *tbl;
+	bool resizing;
+
+	rcu_read_lock();
+
+	tbl = rht_dereference_rcu(rhash_context->ht.tbl, &rhash_context->ht);
+	*size = tbl->size;
+	resizing = rcu_access_pointer(tbl->future_tbl) != NULL;
+
+	rcu_read_unlock();
+
+	return resizing;
+}
+
+/**
+* @brief Clears the resize figures, starting from the current bucket count
+*
+* @param rhash_context Context of the table
+*/
+static void __rhash_reset_stats(project2_rhashtable_context *rhash_context)
+{
+	unsigned int size;
+
+	__rhash_resizing(rhash_context, &size);
+
+	atomic_set(&rhash_context->size, size);
+	atomic_set(&rhash_context->nr_resizes, 0);
+	atomic_set(&rhash_context->nr_paused, 0);
+	atomic64_set(&rhash_context->pause_ns, 0);
+	atomic64_set(&rhash_context->max_pause_ns, 0);
+}
+
+/**
+* @brief Helper API to insert a value, timing the inserts which run while
+*		the table is being resized
+*
+* @param rhash_context Context of the table.
+* @param value Value which is to be inserted.
+*
+* @return 0 for success and appropriate error codes for failure
+*/
+static int __add_rhash(project2_rhashtable_context *rhash_context, int value)
+{
+	project2_rhash_node *tmp;
+	unsigned int size;
+	unsigned int seen;
+	bool resizing;
+	s64 longest;
+	s64 prev;
+	u64 start;
+	u64 delta;
+	int ret;
+
+	tmp = kmalloc(sizeof(project2_rhash_node), project2_gfp);
+	if (tmp == NULL) {
+		printk (KERN_INFO "memory allocation for rhashtable node failed\n");
+		return -ENOMEM;
+	}
+
+	tmp->value = value;
+
+	resizing = __rhash_resizing(rhash_context, &size);
+	start = ktime_get_ns();
+
+	ret = rhashtable_lookup_insert_fast(&rhash_context->ht, &tmp->head,
+							rhash_params);
+
+	delta = ktime_get_ns() - start;
+	resizing |= __rhash_resizing(rhash_context, &size);
+
+	// Only the insert which swaps the bucket count in counts the resize.
+	seen = atomic_read(&rhash_context->size);
+	if (size != seen &&
+			atomic_cmpxchg(&rhash_context->size, seen, size) == seen)
+		atomic_inc(&rhash_context->nr_resizes);
+
+	if (resizing) {
+		atomic_inc(&rhash_context->nr_paused);
+		atomic64_add(delta, &rhash_context->pause_ns);
+
+		longest = atomic64_read(&rhash_context->max_pause_ns);
+		while ((s64)delta > longest) {
+			prev = atomic64_cmpxchg(&rhash_context->max_pause_ns,
+							longest, delta);
+			if (prev == longest)
+				break;
+
+			longest = prev;
+		}
+	}
+
+	if (ret)
+		kfree(tmp);
+
+	return ret;
+}
+
+/**
+* @brief Helper API to remove the node holding value
+*
+* @param rhash_context Context of the table.
+* @param value Value which is to be removed.
+*
+* @return true if value was present
+*/
+static bool __remove_rhash(project2_rhashtable_context *rhash_context,
+						int value)
+{
+	project2_rhash_node *tmp;
+	bool removed = false;
+
+	rcu_read_lock();
+
+	tmp = rhashtable_lookup(&rhash_context->ht, &value, rhash_params);
+
+	// Another writer may win the removal, only the winner frees.
+	if (tmp && !rhashtable_remove_fast(&rhash_context->ht, &tmp->head,
+							rhash_params)) {
+		kfree_rcu(tmp, rcu);
+		removed = true;
+	}
+
+	rcu_read_unlock();
+
+	return removed;
+}
+
+/**
+* @brief Add size number of Random Integers to the table
+*
+* @param context Context information for the table
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_rhashtable(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	project2_rhashtable_context *rhash_context = context;
+	int tmp_size = size;
+	int skipped = 0;
+	int ret = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_rhashtable is NULL\n");
+		return -EINVAL;
+	}
+
+	if (!rhash_context->ready)
+		return -ENODEV;
+
+	while (tmp_size--) {
+		if (project2_yield(size - tmp_size - 1)) {
+			ret = -EINTR;
+			break;
+		}
+
+		start = project2_time_start(hist);
+
+		ret = __add_rhash(rhash_context, keys[size - tmp_size - 1]);
+
+		project2_time_end(hist, start);
+
+		if (ret == -EEXIST) {
+			skipped++;
+			ret = 0;
+			continue;
+		}
+
+		if (ret)
+			break;
+
+		PROJECT2_TRACE(tmp_size, "RHASHTABLE_ADD: %d\n",
+						keys[size - tmp_size - 1]);
+	}
+
+	if (skipped)
+		printk(KERN_INFO "Skipped %d duplicate keys\n", skipped);
+
+	PROJECT2_TRACE(0, "\n");
+	return ret;
+}
+
+/**
+* @brief Prints the contents of the table in bucket order
+*
+* The walk restarts when a resize moves the buckets under it, keys may be
+* seen twice then.
+*
+* @param context Context of the table
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_rhashtable(void *context, project2_hist *hist)
+{
+	project2_rhashtable_context *rhash_context = context;
+	struct rhashtable_iter iter;
+	project2_rhash_node *curr;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_rhashtable is NULL\n");
+		return;
+	}
+
+	if (!rhash_context->ready)
+		return;
+
+	rhashtable_walk_enter(&rhash_context->ht, &iter);
+	rhashtable_walk_start(&iter);
+
+	start = project2_time_start(hist);
+
+	while ((curr = rhashtable_walk_next(&iter)) != NULL) {
+		if (IS_ERR(curr)) {
+			if (PTR_ERR(curr) == -EAGAIN)
+				continue;
+			break;
+		}
+
+		PROJECT2_TRACE(index++, "RHASHTABLE_SHOW: %d\n", curr->value);
+
+		project2_time_end(hist, start);
+
+		// The walk holds the RCU read lock, drop it to reschedule.
+		if (!(index % PROJECT2_RESCHED_INTERVAL)) {
+			rhashtable_walk_stop(&iter);
+
+			if (project2_yield(index)) {
+				rhashtable_walk_exit(&iter);
+				return;
+			}
+
+			rhashtable_walk_start(&iter);
+		}
+
+		start = project2_time_start(hist);
+	}
+
+	rhashtable_walk_stop(&iter);
+	rhashtable_walk_exit(&iter);
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief State of remove_rhashtable passed to the free callback
+*/
+typedef struct project2_rhash_free_t {
+	project2_hist *hist; /*Histogram for per element latency, may be NULL */
+	unsigned long index; /*Number of nodes freed so far */
+} project2_rhash_free;
+
+/**
+* @brief Frees one node of the table being destroyed
+*
+* @param ptr Node to be freed
+* @param arg project2_rhash_free of the remove, NULL from deinit
+*/
+static void __free_rhash_node(void *ptr, void *arg)
+{
+	project2_rhash_node *curr = ptr;
+	project2_rhash_free *state = arg;
+	u64 start;
+
+	if (state == NULL) {
+		kfree(curr);
+		return;
+	}
+
+	start = project2_time_start(state->hist);
+
+	PROJECT2_TRACE(state->index++, "RHASHTABLE_REMOVE: %d\n", curr->value);
+	kfree(curr);
+
+	project2_time_end(state->hist, start);
+}
+
+/**
+* @brief Removes the entire table, by destroying it and initializing an
+*		empty one in its place.
+*
+* If the new table cannot be initialized, every op except remove and
+* deinit fails with -ENODEV until a later remove initializes it.
+*
+* @param context Context of the table.
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_rhashtable(void *context, project2_hist *hist)
+{
+	project2_rhashtable_context *rhash_context = context;
+	project2_rhash_free state = { .hist = hist, .index = 0 };
+	int ret;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_rhashtable is NULL\n");
+		return -EINVAL;
+	}
+
+	// No reader is left, so the nodes need no grace period.
+	if (rhash_context->ready)
+		rhashtable_free_and_destroy(&rhash_context->ht,
+						__free_rhash_node, &state);
+
+	rhash_context->ready = false;
+
+	ret = rhashtable_init(&rhash_context->ht, &rhash_params);
+	if (ret) {
+		printk (KERN_INFO "rhashtable init after remove failed %d\n", ret);
+		return ret;
+	}
+
+	__rhash_reset_stats(rhash_context);
+	rhash_context->ready = true;
+
+	return 0;
+}
+
+/**
+* @brief Inserts nr keys one by one
+*
+* @param context Context of the table
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success, -EEXIST if some keys were already present or
+*		appropriate error codes on failure
+*/
+static int add_batch_rhashtable(void *context, const int *keys, int nr)
+{
+	project2_rhashtable_context *rhash_context = context;
+	int ret = 0;
+	int err;
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_rhashtable is NULL\n");
+		return -EINVAL;
+	}
+
+	if (!rhash_context->ready)
+		return -ENODEV;
+
+	for (i = 0; i < nr; i++) {
+		err = __add_rhash(rhash_context, keys[i]);
+		if (err == -ENOMEM)
+			return err;
+
+		if (err)
+			ret = err;
+	}
+
+	return ret;
+}
+
+/**
+* @brief Removes up to nr keys in bucket order
+*
+* @param context Context of the table
+* @param keys Receives the removed keys
+* @param nr Maximum number of keys to remove
+*
+* @return Number of removed keys or appropriate error codes on failure
+*/
+static int remove_batch_rhashtable(void *context, int *keys, int nr)
+{
+	project2_rhashtable_context *rhash_context = context;
+	struct rhashtable_iter iter;
+	project2_rhash_node *curr;
+	int count = 0;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_rhashtable is NULL\n");
+		return -EINVAL;
+	}
+
+	if (!rhash_context->ready)
+		return -ENODEV;
+
+	rhashtable_walk_enter(&rhash_context->ht, &iter);
+	rhashtable_walk_start(&iter);
+
+	// A removed node keeps its link, so the walk carries on past it.
+	while (count < nr && (curr = rhashtable_walk_next(&iter)) != NULL) {
+		if (IS_ERR(curr)) {
+			if (PTR_ERR(curr) == -EAGAIN)
+				continue;
+			break;
+		}
+
+		if (rhashtable_remove_fast(&rhash_context->ht, &curr->head,
+							rhash_params))
+			continue;
+
+		keys[count++] = curr->value;
+		kfree_rcu(curr, rcu);
+	}
+
+	rhashtable_walk_stop(&iter);
+	rhashtable_walk_exit(&iter);
+
+	return count;
+}
+
+/**
+* @brief Erases every key in [start, end] from the table, one lookup per
+*		key of the range as the table keeps no order
+*
+* @param context Context of the table
+* @param start Start of the range (INCLUSIVE)
+* @param end End of the range (INCLUSIVE)
+*
+* @return Number of erased keys or appropriate error codes on failure
+*/
+static int remove_range_rhashtable(void *context, int start, int end)
+{
+	project2_rhashtable_context *rhash_context = context;
+	int count = 0;
+	long key;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_range_rhashtable is NULL\n");
+		return -EINVAL;
+	}
+
+	if (!rhash_context->ready)
+		return -ENODEV;
+
+	for (key = start; key <= end &&
+			atomic_read(&rhash_context->ht.nelems); key++) {
+		count += __remove_rhash(rhash_context, key);
+
+		project2_yield(key - start);
+	}
+
+	return count;
+}
+
+/**
+* @brief Searches the table for key, it takes the RCU read lock itself
+*
+* @param context Context of the table
+* @param key Value to be searched
+*
+* @return true if key is present in the table
+*/
+static bool lookup_rhashtable(void *context, int key)
+{
+	project2_rhashtable_context *rhash_context = context;
+
+	if (!context || !rhash_context->ready)
+		return false;
+
+	return rhashtable_lookup_fast(&rhash_context->ht, &key,
+						rhash_params) != NULL;
+}
+
+/**
+* @brief Prints the load factor and the resizes seen by the inserts
+*
+* @param context Context of the table
+*/
+static void report_rhashtable(void *context)
+{
+	project2_rhashtable_context *rhash_context = context;
+	unsigned int nelems;
+	unsigned int size;
+	unsigned int nr_paused;
+	bool resizing;
+	u64 load;
+	u32 frac;
+
+	if (!context || !rhash_context->ready)
+		return;
+
+	nelems = atomic_read(&rhash_context->ht.nelems);
+	resizing = __rhash_resizing(rhash_context, &size);
+	nr_paused = atomic_read(&rhash_context->nr_paused);
+
+	// Keys per bucket with two decimals.
+	load = div_u64((u64)nelems * 100, size);
+	load = div_u64_rem(load, 100, &frac);
+
+	project2_report("rhashtable: %u keys in %u buckets%s, load factor %llu.%02u, %u resizes, %u inserts during resize, pause avg %llu max %llu ns\n",
+			nelems, size, resizing ? " (resizing)" : "",
+			load, frac,
+			atomic_read(&rhash_context->nr_resizes), nr_paused,
+			nr_paused ?
+			div_u64(atomic64_read(&rhash_context->pause_ns),
+					nr_paused) : 0,
+			(u64)atomic64_read(&rhash_context->max_pause_ns));
+}
+
+/**
+* @brief Destroys the table and deallocates the context
+*
+* The nodes of remove_batch and remove_range may still wait in kfree_rcu.
+* They are freed by the slab allocator without touching the table or the
+* context, so there is nothing to wait for before both go away.
+*
+* @param context Context for the table
+*/
+static void deinit_rhashtable(void *context)
+{
+	project2_rhashtable_context *rhash_context = context;
+
+	if (context) {
+		if (rhash_context->ready)
+			rhashtable_free_and_destroy(&rhash_context->ht,
+						__free_rhash_node, NULL);
+
+		kfree(context);
+	}
+}
+
+/**
+* @brief Initializes the context with an empty table, it grows with the
+*		inserts instead of being sized for size keys
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_rhashtable(int size, void **context)
+{
+	project2_rhashtable_context *rhash_context =
+		kzalloc(sizeof(project2_rhashtable_context), GFP_KERNEL);
+	int ret;
+
+	if (!rhash_context) {
+		printk (KERN_INFO "memory allocation for rhashtable context failed\n");
+		return -ENOMEM;
+	}
+
+	ret = rhashtable_init(&rhash_context->ht, &rhash_params);
+	if (ret) {
+		printk (KERN_INFO "rhashtable init failed %d\n", ret);
+		kfree(rhash_context);
+		return ret;
+	}
+
+	__rhash_reset_stats(rhash_context);
+	rhash_context->ready = true;
+
+	*context = rhash_context;
+
+	return 0;
+}
+
+// Generates the handles for the resizable hash table test-case
+PROJECT2_GENERATE_HANDLE(rhashtable,
+			PROJECT2_HANDLE_OP(rhashtable, add_batch),
+			PROJECT2_HANDLE_OP(rhashtable, remove_batch),
+			PROJECT2_HANDLE_OP(rhashtable, remove_range),
+			PROJECT2_HANDLE_OP(rhashtable, lookup),
+			PROJECT2_HANDLE_OP(rhashtable, report),
+			PROJECT2_HANDLE_FLAGS(rhashtable, PROJECT2_HANDLE_THREAD_SAFE));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 for manipulation of resizable hash table data structures\n");
@@ -0,0 +1,354 @@
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/atomic.h>
+#include <linux/cache.h>
+#include "project2.h"
+
+/**
+* @brief Slot of the ring.
+*
+* seq tells whose turn the slot is: equal to the position of the enqueue
+* which may fill it, position + 1 once it holds data for the dequeue at
+* that position and position + size after it has been consumed.
+*/
+typedef struct project2_ring_slot_t {
+	atomic_t seq;
+	int data;
+} project2_ring_slot;
+
+/**
+* @brief Bounded lock-free MPMC ring, after Dmitry Vyukov's bounded queue
+*
+* Producers and consumers only contend on their own counter and on the
+* slot they claimed, the two counters live on separate cache lines.
+*/
+typedef struct project2_ring_t {
+	atomic_t head ____cacheline_aligned_in_smp; /*Next enqueue position */
+	atomic_t tail ____cacheline_aligned_in_smp; /*Next dequeue position */
+	unsigned int mask ____cacheline_aligned_in_smp; /*Number of slots - 1 */
+	project2_ring_slot *slots; /*Power of two array of slots */
+} project2_ring;
+
+/**
+* @brief Helper API to enqueue one element.
+*
+* @param ring Context of the ring.
+* @param data Data which is to be inserted.
+*
+* @return 0 for success, -ENOMEM if the ring is full
+*/
+static int __enqueue_ring(project2_ring *ring, int data)
+{
+	project2_ring_slot *slot;
+	unsigned int pos = atomic_read(&ring->head);
+	int diff;
+
+	for (;;) {
+		slot = &ring->slots[pos & ring->mask];
+		diff = (int)((unsigned int)atomic_read_acquire(&slot->seq) - pos);
+
+		if (diff == 0) {
+			// Claim the position, a failed cmpxchg reloads pos.
+			if (atomic_try_cmpxchg_relaxed(&ring->head, (int *)&pos,
+									pos + 1))
+				break;
+		} else if (diff < 0) {
+			// The slot of the previous lap has not been consumed.
+			return -ENOMEM;
+		} else {
+			pos = atomic_read(&ring->head);
+		}
+	}
+
+	slot->data = data;
+	atomic_set_release(&slot->seq, pos + 1);
+
+	return 0;
+}
+
+/**
+* @brief Helper API to dequeue one element.
+*
+* @param ring Context of the ring.
+* @param data Receives the dequeued value.
+*
+* @return true if an element was dequeued, false if the ring is empty
+*/
+static bool __dequeue_ring(project2_ring *ring, int *data)
+{
+	project2_ring_slot *slot;
+	unsigned int pos = atomic_read(&ring->tail);
+	int diff;
+
+	for (;;) {
+		slot = &ring->slots[pos & ring->mask];
+		diff = (int)((unsigned int)atomic_read_acquire(&slot->seq) -
+								(pos + 1));
+
+		if (diff == 0) {
+			if (atomic_try_cmpxchg_relaxed(&ring->tail, (int *)&pos,
+									pos + 1))
+				break;
+		} else if (diff < 0) {
+			// The enqueue of this position has not completed.
+			return false;
+		} else {
+			pos = atomic_read(&ring->tail);
+		}
+	}
+
+	*data = slot->data;
+
+	// Hand the slot over to the enqueue of the next lap.
+	atomic_set_release(&slot->seq, pos + ring->mask + 1);
+
+	return true;
+}
+
+/**
+* @brief Add size number of random numbers to the ring
+*
+* @param context Context information for the ring
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_ring(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	int data;
+	int ret = 0;
+	int tmp_size = size;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_ring is NULL\n");
+		return -EINVAL;
+	}
+
+	while (tmp_size--) {
+
+		if (project2_yield(size - tmp_size - 1))
+			return -EINTR;
+
+		data = keys[size - tmp_size - 1];
+
+		start = project2_time_start(hist);
+
+		ret = __enqueue_ring(context, data);
+
+		project2_time_end(hist, start);
+
+		if (ret) {
+			printk(KERN_INFO "enqueue failed due to less space\n");
+			return ret;
+		}
+
+		PROJECT2_TRACE(tmp_size, "RING_ENQUEUE: %d\n", data);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Prints the contents of the ring from tail to head, only valid
+*		while no other thread uses the ring
+*
+* @param context Context of the ring
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_ring(void *context, project2_hist *hist)
+{
+	project2_ring *ring = context;
+	unsigned int pos;
+	unsigned int head;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_ring is NULL\n");
+		return;
+	}
+
+	head = atomic_read(&ring->head);
+
+	start = project2_time_start(hist);
+
+	for (pos = atomic_read(&ring->tail); pos != head; pos++) {
+		PROJECT2_TRACE(index++, "RING_SHOW: %d\n",
+					ring->slots[pos & ring->mask].data);
+		project2_time_end(hist, start);
+
+		if (project2_yield(index))
+			return;
+
+		start = project2_time_start(hist);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Dequeues the entire ring.
+*
+* @param context Context of the ring.
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_ring(void *context, project2_hist *hist)
+{
+	int data;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_ring is NULL\n");
+		return -EINVAL;
+	}
+
+	for (;;) {
+		start = project2_time_start(hist);
+
+		if (!__dequeue_ring(context, &data))
+			break;
+
+		project2_time_end(hist, start);
+
+		PROJECT2_TRACE(index++, "RING_DEQUEUE: %d\n", data);
+
+		project2_yield(index);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Enqueues nr keys one slot at a time, safe against any number of
+*		producers and consumers
+*
+* @param context Context of the ring
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success, -ENOMEM if the ring filled up part way through
+*/
+static int add_batch_ring(void *context, const int *keys, int nr)
+{
+	int ret = 0;
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_ring is NULL\n");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < nr && !ret; i++)
+		ret = __enqueue_ring(context, keys[i]);
+
+	return ret;
+}
+
+/**
+* @brief Dequeues up to nr elements, safe against any number of producers
+*		and consumers
+*
+* @param context Context of the ring
+* @param keys Receives the dequeued values
+* @param nr Maximum number of elements to dequeue
+*
+* @return Number of dequeued elements or appropriate error codes on failure
+*/
+static int remove_batch_ring(void *context, int *keys, int nr)
+{
+	int count = 0;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_ring is NULL\n");
+		return -EINVAL;
+	}
+
+	while (count < nr && __dequeue_ring(context, &keys[count]))
+		count++;
+
+	return count;
+}
+
+/**
+* @brief Initializes the context by allocating the slots for the test
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_ring(int size, void **context)
+{
+	// Get the ceiling power 2 for the size.
+	int rsize = project2_queue_size(size);
+	project2_ring *ring;
+	int i;
+
+	if (rsize < 0) {
+		printk (KERN_INFO "integer overflow while getting power of 2\n");
+		return -EINVAL;
+	}
+
+	ring = kzalloc(sizeof(project2_ring), GFP_KERNEL);
+	if (ring == NULL) {
+		printk (KERN_INFO "memory allocation for ring failed\n");
+		return -ENOMEM;
+	}
+
+	ring->slots = kvmalloc_array(rsize, sizeof(project2_ring_slot),
+								GFP_KERNEL);
+	if (ring->slots == NULL) {
+		kfree(ring);
+		printk (KERN_INFO "memory allocation for ring slots failed\n");
+		return -ENOMEM;
+	}
+
+	// Slot i is first filled by the enqueue at position i.
+	for (i = 0; i < rsize; i++)
+		atomic_set(&ring->slots[i].seq, i);
+
+	ring->mask = rsize - 1;
+	atomic_set(&ring->head, 0);
+	atomic_set(&ring->tail, 0);
+
+	*context = ring;
+	return 0;
+}
+
+/**
+* @brief Deallocates the context
+*
+* @param context Context for the ring
+*/
+static void deinit_ring(void *context)
+{
+	project2_ring *ring = context;
+
+	if (ring) {
+		kvfree(ring->slots);
+		kfree(ring);
+	}
+}
+
+// Generates the handles for the ring test-case
+PROJECT2_GENERATE_HANDLE(ring,
+			PROJECT2_HANDLE_OP(ring, add_batch),
+			PROJECT2_HANDLE_OP(ring, remove_batch),
+			PROJECT2_HANDLE_FLAGS(ring, PROJECT2_HANDLE_THREAD_SAFE));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 bounded lock-free MPMC ring buffer\n");
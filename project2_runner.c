@@ -0,0 +1,130 @@
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
+#include <linux/mutex.h>
+#include <linux/cpumask.h>
+#include "project2.h"
+
+/**
+* @brief Set on module unload to cancel the run in flight
+*/
+bool project2_stop;
+
+/**
+* @brief Kthread of the last run, NULL before the first one
+*/
+static struct task_struct *runner_task;
+
+/**
+* @brief Completed by the kthread right before it exits
+*/
+static DECLARE_COMPLETION(runner_done);
+
+/**
+* @brief Serializes starting and stopping the runner
+*/
+static DEFINE_MUTEX(runner_lock);
+
+/**
+* @brief Benchmark and configuration of the run in flight
+*/
+static int (*runner_fn)(const project2_config *cfg);
+static project2_config runner_cfg;
+
+/**
+* @brief Body of the runner kthread
+*
+* @param data Unused
+*
+* @return Does not return, the kthread exits through complete_and_exit
+*		so that the module can not go away under its last instructions.
+*/
+static int __runner(void *data)
+{
+	int ret = runner_fn(&runner_cfg);
+
+	if (ret)
+		project2_report("run failed %d\n", ret);
+
+	complete_and_exit(&runner_done, ret);
+}
+
+/**
+* @brief Starts fn on the runner kthread, bound to cfg->cpu if set
+*
+* @param fn Benchmark to be run
+* @param cfg Configuration of the run, copied by the runner
+*
+* @return 0 for success, -EBUSY if a run is in flight or appropriate
+*		error code on failure.
+*/
+int project2_runner_start(int (*fn)(const project2_config *cfg),
+					const project2_config *cfg)
+{
+	struct task_struct *task;
+	int ret;
+
+	ret = project2_config_check(cfg);
+	if (ret)
+		return ret;
+
+	if (cfg->cpu >= 0 && (cfg->cpu >= nr_cpu_ids || !cpu_online(cfg->cpu)))
+		return -EINVAL;
+
+	mutex_lock(&runner_lock);
+
+	if (READ_ONCE(project2_stop)) {
+		ret = -ESHUTDOWN;
+		goto out;
+	}
+
+	if (runner_task && !completion_done(&runner_done)) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	runner_fn = fn;
+	runner_cfg = *cfg;
+	reinit_completion(&runner_done);
+
+	task = kthread_create(__runner, NULL, "project2_run");
+	if (IS_ERR(task)) {
+		ret = PTR_ERR(task);
+		runner_task = NULL;
+		goto out;
+	}
+
+	if (cfg->cpu >= 0)
+		kthread_bind(task, cfg->cpu);
+
+	runner_task = task;
+	wake_up_process(task);
+
+out:
+	mutex_unlock(&runner_lock);
+
+	return ret;
+}
+
+/**
+* @brief Cancels the run in flight and waits for the runner to exit
+*/
+void project2_runner_stop(void)
+{
+	mutex_lock(&runner_lock);
+
+	WRITE_ONCE(project2_stop, true);
+
+	if (runner_task)
+		wait_for_completion(&runner_done);
+
+	runner_task = NULL;
+
+	mutex_unlock(&runner_lock);
+}
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 kthread running the benchmarks\n");
@@ -0,0 +1,394 @@
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/sort.h>
+#include "project2.h"
+
+/**
+* @brief Context for sorted array test
+*
+* Inserts only append to the array, it is sorted again on the first read
+* after an insert. Removal of the smallest keys only advances first.
+*/
+typedef struct project2_sarray_context_t {
+	int *keys; /*Buffer holding the keys */
+	int first; /*Index of the smallest key still present */
+	int nr; /*Index one past the last key */
+	int max; /*Capacity of the buffer */
+	bool sorted; /*Set while [first, nr) is in ascending order */
+} project2_sarray_context;
+
+
+/**
+* @brief Sorts the keys appended since the last read
+*
+* @param sarray_context Context of the sorted array
+*/
+static void __settle_sarray(project2_sarray_context *sarray_context)
+{
+	if (sarray_context->sorted)
+		return;
+
+	sort(sarray_context->keys + sarray_context->first,
+			sarray_context->nr - sarray_context->first,
+			sizeof(int), project2_cmp_int, NULL);
+
+	sarray_context->sorted = true;
+}
+
+/**
+* @brief Helper API to append a key to the array
+*
+* @param sarray_context Context of the sorted array
+* @param key Key to be appended
+*
+* @return 0 for success and -ENOSPC if the array is full
+*/
+static int __add_sarray(project2_sarray_context *sarray_context, int key)
+{
+	if (sarray_context->nr >= sarray_context->max)
+		return -ENOSPC;
+
+	sarray_context->keys[sarray_context->nr++] = key;
+	sarray_context->sorted = false;
+
+	return 0;
+}
+
+/**
+* @brief Add size number of Random Integers to the array
+*
+* @param context Context information for the sorted array
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_sarray(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	project2_sarray_context *sarray_context =
+							(project2_sarray_context *) context;
+	int tmp_size = size;
+	int data;
+	int ret = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_sarray is NULL\n");
+		return -EINVAL;
+	}
+
+	while (tmp_size--) {
+
+		if (project2_yield(size - tmp_size - 1)) {
+			ret = -EINTR;
+			break;
+		}
+
+		data = keys[size - tmp_size - 1];
+
+		start = project2_time_start(hist);
+
+		ret = __add_sarray(sarray_context, data);
+
+		project2_time_end(hist, start);
+
+		if (ret) {
+			printk(KERN_INFO "sorted array is full\n");
+			break;
+		}
+
+		PROJECT2_TRACE(tmp_size, "SARRAY_ADD: %d\n", data);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+
+	return ret;
+}
+
+/**
+* @brief Prints the contents of the array in ascending order
+*
+* @param context Context of the sorted array
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_sarray(void *context, project2_hist *hist)
+{
+	project2_sarray_context *sarray_context =
+							(project2_sarray_context *) context;
+	int index;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_sarray is NULL\n");
+		return;
+	}
+
+	__settle_sarray(sarray_context);
+
+	start = project2_time_start(hist);
+
+	for (index = sarray_context->first; index < sarray_context->nr; index++) {
+		PROJECT2_TRACE(index, "SARRAY_SHOW: %d\n",
+						sarray_context->keys[index]);
+
+		project2_time_end(hist, start);
+
+		if (project2_yield(index - sarray_context->first))
+			return;
+
+		start = project2_time_start(hist);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Removes the entire array from the smallest key upwards
+*
+* @param context Context of the sorted array
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_sarray(void *context, project2_hist *hist)
+{
+	project2_sarray_context *sarray_context =
+							(project2_sarray_context *) context;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_sarray is NULL\n");
+		return -EINVAL;
+	}
+
+	__settle_sarray(sarray_context);
+
+	while (sarray_context->first < sarray_context->nr) {
+		start = project2_time_start(hist);
+
+		PROJECT2_TRACE(sarray_context->first, "SARRAY_DEL: %d\n",
+					sarray_context->keys[sarray_context->first]);
+		sarray_context->first++;
+
+		project2_time_end(hist, start);
+
+		project2_yield(sarray_context->first);
+	}
+
+	sarray_context->first = 0;
+	sarray_context->nr = 0;
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Appends nr keys to the array
+*
+* @param context Context of the sorted array
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int add_batch_sarray(void *context, const int *keys, int nr)
+{
+	project2_sarray_context *sarray_context =
+							(project2_sarray_context *) context;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_sarray is NULL\n");
+		return -EINVAL;
+	}
+
+	if (nr > sarray_context->max - sarray_context->nr)
+		return -ENOSPC;
+
+	memcpy(sarray_context->keys + sarray_context->nr, keys,
+			nr * sizeof(int));
+	sarray_context->nr += nr;
+	sarray_context->sorted = false;
+
+	return 0;
+}
+
+/**
+* @brief Removes up to nr of the smallest keys from the array
+*
+* @param context Context of the sorted array
+* @param keys Receives the removed keys in ascending order
+* @param nr Maximum number of keys to remove
+*
+* @return Number of removed keys or appropriate error codes on failure
+*/
+static int remove_batch_sarray(void *context, int *keys, int nr)
+{
+	project2_sarray_context *sarray_context =
+							(project2_sarray_context *) context;
+	int count;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_sarray is NULL\n");
+		return -EINVAL;
+	}
+
+	__settle_sarray(sarray_context);
+
+	count = min(nr, sarray_context->nr - sarray_context->first);
+
+	memcpy(keys, sarray_context->keys + sarray_context->first,
+			count * sizeof(int));
+	sarray_context->first += count;
+
+	// Reuse the buffer from the start once it has been drained.
+	if (sarray_context->first == sarray_context->nr) {
+		sarray_context->first = 0;
+		sarray_context->nr = 0;
+	}
+
+	return count;
+}
+
+/**
+* @brief Binary searches the array for key
+*
+* @param context Context of the sorted array
+* @param key Value to be searched
+*
+* @return true if key is present in the array
+*/
+static bool lookup_sarray(void *context, int key)
+{
+	project2_sarray_context *sarray_context =
+							(project2_sarray_context *) context;
+	int low;
+	int high;
+	int mid;
+
+	if (!context)
+		return false;
+
+	__settle_sarray(sarray_context);
+
+	low = sarray_context->first;
+	high = sarray_context->nr;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+
+		if (sarray_context->keys[mid] < key)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low < sarray_context->nr && sarray_context->keys[low] == key;
+}
+
+/**
+* @brief Copies sorted keys in, without the sort of the first read
+*
+* @param context Context of the sorted array, which must be empty
+* @param keys Strictly increasing keys
+* @param nr Number of keys
+*
+* @return 0 for success, -EBUSY if the array is not empty, -EINVAL if the
+*		keys are not strictly increasing or -ENOSPC
+*/
+static int build_sarray(void *context, const int *keys, int nr)
+{
+	project2_sarray_context *sarray_context =
+							(project2_sarray_context *) context;
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to build_sarray is NULL\n");
+		return -EINVAL;
+	}
+
+	if (sarray_context->nr > sarray_context->first)
+		return -EBUSY;
+
+	if (nr < 0 || nr > sarray_context->max)
+		return nr < 0 ? -EINVAL : -ENOSPC;
+
+	for (i = 1; i < nr; i++)
+		if (keys[i - 1] >= keys[i])
+			return -EINVAL;
+
+	memcpy(sarray_context->keys, keys, nr * sizeof(int));
+	sarray_context->first = 0;
+	sarray_context->nr = nr;
+	sarray_context->sorted = true;
+
+	return 0;
+}
+
+/**
+* @brief Deallocates the context
+*
+* @param context Context for the sorted array
+*/
+static void deinit_sarray(void *context)
+{
+	project2_sarray_context *sarray_context =
+							(project2_sarray_context *) context;
+
+	if (context) {
+		kvfree(sarray_context->keys);
+		kfree(context);
+	}
+}
+
+/**
+* @brief Initializes the context by allocating the key buffer
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_sarray(int size, void **context)
+{
+	project2_sarray_context *sarray_context =
+				kmalloc(sizeof(project2_sarray_context), GFP_KERNEL);
+
+	if (!sarray_context) {
+		printk (KERN_INFO "memory allocation for sarray context failed\n");
+		return -ENOMEM;
+	}
+
+	sarray_context->keys = kvmalloc_array(size, sizeof(int), GFP_KERNEL);
+
+	if (sarray_context->keys == NULL) {
+		printk (KERN_INFO "memory allocation for sarray buffer failed\n");
+		kfree(sarray_context);
+		return -ENOMEM;
+	}
+
+	sarray_context->first = 0;
+	sarray_context->nr = 0;
+	sarray_context->max = size;
+	sarray_context->sorted = true;
+
+	*context = sarray_context;
+
+	return 0;
+}
+
+// Generates the handles for the sorted array test-case
+PROJECT2_GENERATE_HANDLE(sarray,
+			PROJECT2_HANDLE_OP(sarray, add_batch),
+			PROJECT2_HANDLE_OP(sarray, remove_batch),
+			PROJECT2_HANDLE_OP(sarray, lookup),
+			PROJECT2_HANDLE_OP(sarray, build),
+			PROJECT2_HANDLE_FLAGS(sarray, PROJECT2_HANDLE_LOOKUP_WRITES));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 for manipulation of sorted array data structures\n");
@@ -0,0 +1,257 @@
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/log2.h>
+#include <linux/mutex.h>
+#include <linux/fs.h>
+#include <linux/err.h>
+#include <linux/perf_event.h>
+#include "project2.h"
+
+/**
+* @brief Report of the last run, protected by report_lock
+*/
+static char report_buf[PROJECT2_REPORT_SIZE];
+static size_t report_len;
+static DEFINE_MUTEX(report_lock);
+
+/**
+* @brief Clears all the samples of the histogram
+*
+* @param hist Histogram to be cleared
+*/
+void project2_hist_init(project2_hist *hist)
+{
+	memset(hist, 0, sizeof(project2_hist));
+}
+
+/**
+* @brief Records one latency sample in the histogram
+*
+* @param hist Histogram to be updated
+* @param ns Latency of the operation in nanoseconds
+*/
+void project2_hist_add(project2_hist *hist, u64 ns)
+{
+	int bucket = ns ? ilog2(ns) + 1 : 0;
+
+	if (bucket >= PROJECT2_HIST_BUCKETS)
+		bucket = PROJECT2_HIST_BUCKETS - 1;
+
+	hist->buckets[bucket]++;
+	hist->count++;
+	hist->sum_ns += ns;
+
+	if (ns > hist->max_ns)
+		hist->max_ns = ns;
+}
+
+/**
+* @brief Returns the latency below which permille of the samples fall
+*
+* @param hist Histogram to be queried
+* @param permille Percentile in tenths of a percent (500 for p50)
+*
+* @return Upper bound of the matching bucket in nanoseconds
+*/
+u64 project2_hist_percentile(const project2_hist *hist, int permille)
+{
+	u64 rank;
+	u64 seen = 0;
+	u64 bound;
+	int bucket;
+
+	if (!hist->count)
+		return 0;
+
+	// Rank of the sample we are looking for, rounded up.
+	rank = div_u64(hist->count * permille + 999, 1000);
+
+	for (bucket = 0; bucket < PROJECT2_HIST_BUCKETS; bucket++) {
+		seen += hist->buckets[bucket];
+		if (seen >= rank)
+			break;
+	}
+
+	if (bucket >= PROJECT2_HIST_BUCKETS)
+		return hist->max_ns;
+
+	bound = bucket ? (1ULL << bucket) - 1 : 0;
+
+	// The bucket bound can overshoot the largest sample actually seen.
+	return min(bound, hist->max_ns);
+}
+
+/**
+* @brief Adds the samples of src to dst
+*
+* @param dst Histogram receiving the samples
+* @param src Histogram to be merged
+*/
+void project2_hist_merge(project2_hist *dst, const project2_hist *src)
+{
+	int bucket;
+
+	for (bucket = 0; bucket < PROJECT2_HIST_BUCKETS; bucket++)
+		dst->buckets[bucket] += src->buckets[bucket];
+
+	dst->count += src->count;
+	dst->sum_ns += src->sum_ns;
+	dst->max_ns = max(dst->max_ns, src->max_ns);
+}
+
+/**
+* @brief Prints the column titles for project2_hist_print
+*/
+void project2_hist_print_header(void)
+{
+	project2_report("%-8s %-8s %10s %8s %10s %8s %8s %8s %10s\n",
+			"DS", "PHASE", "OPS", "NS/OP", "KOPS/S",
+			"P50", "P99", "P99.9", "MAX");
+}
+
+/**
+* @brief Prints one summary row for the histogram
+*
+* @param type Name of the data structure
+* @param phase Name of the phase which was timed
+* @param hist Per element samples of the phase
+* @param total_ns Wall time of the entire phase
+*/
+void project2_hist_print(const char *type, const char *phase,
+				const project2_hist *hist, u64 total_ns)
+{
+	u64 ns_per_op = hist->count ? div64_u64(total_ns, hist->count) : 0;
+	u64 kops = total_ns ? div64_u64(hist->count * USEC_PER_SEC, total_ns) : 0;
+
+	project2_report("%-8s %-8s %10llu %8llu %10llu %8llu %8llu %8llu %10llu\n",
+			type, phase, hist->count, ns_per_op, kops,
+			project2_hist_percentile(hist, 500),
+			project2_hist_percentile(hist, 990),
+			project2_hist_percentile(hist, 999),
+			hist->max_ns);
+}
+
+/**
+* @brief Clears the report of the previous run
+*/
+void project2_report_reset(void)
+{
+	mutex_lock(&report_lock);
+	report_len = 0;
+	mutex_unlock(&report_lock);
+}
+
+/**
+* @brief Logs one line of the report and appends it to the report buffer
+*
+* @param fmt printf style format without the log level
+*/
+void project2_report(const char *fmt, ...)
+{
+	struct va_format vaf;
+	va_list args;
+
+	va_start(args, fmt);
+	vaf.fmt = fmt;
+	vaf.va = &args;
+	printk(KERN_INFO "%pV", &vaf);
+	va_end(args);
+
+	mutex_lock(&report_lock);
+
+	// Lines which do not fit are only logged, the buffer keeps the start.
+	va_start(args, fmt);
+	report_len += vscnprintf(report_buf + report_len,
+				sizeof(report_buf) - report_len, fmt, args);
+	va_end(args);
+
+	mutex_unlock(&report_lock);
+}
+
+/**
+* @brief Copies the report of the last run to user space
+*
+* @param buf User buffer
+* @param count Size of the user buffer
+* @param ppos Position in the report
+*
+* @return Number of bytes copied or appropriate error code on failure.
+*/
+ssize_t project2_report_read(char __user *buf, size_t count, loff_t *ppos)
+{
+	ssize_t ret;
+
+	mutex_lock(&report_lock);
+	ret = simple_read_from_buffer(buf, count, ppos, report_buf, report_len);
+	mutex_unlock(&report_lock);
+
+	return ret;
+}
+
+/**
+* @brief Starts counting the last level cache misses of the calling thread
+*
+* PERF_COUNT_HW_CACHE_MISSES is the miss event of the last level cache on
+* the common PMUs. The counter follows the thread across CPUs.
+*
+* @param llc Counter to be opened
+*
+* @return 0 for success or appropriate error code if the counter is not
+*		available, project2_llc_read then returns 0.
+*/
+int project2_llc_open(project2_llc *llc)
+{
+	struct perf_event_attr attr = {
+		.type = PERF_TYPE_HARDWARE,
+		.config = PERF_COUNT_HW_CACHE_MISSES,
+		.size = sizeof(struct perf_event_attr),
+		.pinned = 1,
+	};
+	struct perf_event *event;
+
+	event = perf_event_create_kernel_counter(&attr, -1, current, NULL, NULL);
+	if (IS_ERR(event)) {
+		llc->event = NULL;
+		return PTR_ERR(event);
+	}
+
+	llc->event = event;
+
+	return 0;
+}
+
+/**
+* @brief Reads the number of misses counted since project2_llc_open
+*
+* @param llc Counter opened by project2_llc_open
+*
+* @return Number of misses, 0 without a counter
+*/
+u64 project2_llc_read(project2_llc *llc)
+{
+	u64 enabled;
+	u64 running;
+
+	if (llc->event == NULL)
+		return 0;
+
+	return perf_event_read_value(llc->event, &enabled, &running);
+}
+
+/**
+* @brief Releases the counter
+*
+* @param llc Counter opened by project2_llc_open
+*/
+void project2_llc_close(project2_llc *llc)
+{
+	if (llc->event)
+		perf_event_release_kernel(llc->event);
+
+	llc->event = NULL;
+}
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 latency statistics helpers\n");
@@ -0,0 +1,239 @@
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/kfifo.h>
+#include "project2.h"
+
+/**
+* @brief Context of the typed queue.
+*
+* The kfifo is declared with int elements, so lengths are counted in
+* elements and kfifo_put/kfifo_get move one int without the byte length
+* arithmetic of the untyped queue.
+*/
+typedef struct project2_tqueue_t {
+	DECLARE_KFIFO_PTR(fifo, int);
+} project2_tqueue;
+
+/**
+* @brief Add size number of random numbers to the queue, one kfifo_put
+*		per element
+*
+* @param context Context information for the queue
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_tqueue(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	project2_tqueue *queue = context;
+	int data;
+	int ret;
+	int tmp_size = size;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_tqueue is NULL\n");
+		return -EINVAL;
+	}
+
+	while (tmp_size--) {
+
+		if (project2_yield(size - tmp_size - 1))
+			return -EINTR;
+
+		data = keys[size - tmp_size - 1];
+
+		start = project2_time_start(hist);
+
+		ret = kfifo_put(&queue->fifo, data);
+
+		project2_time_end(hist, start);
+
+		if (!ret) {
+			printk(KERN_INFO "enqueue failed due to less space\n");
+			return -ENOMEM;
+		}
+
+		PROJECT2_TRACE(tmp_size, "TQUEUE_ENQUEUE: %d\n", data);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Prints the length and the head of the queue without consuming it
+*
+* @param context Context of the queue
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_tqueue(void *context, project2_hist *hist)
+{
+	project2_tqueue *queue = context;
+	int data;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_tqueue is NULL\n");
+		return;
+	}
+
+	if (kfifo_peek(&queue->fifo, &data))
+		PROJECT2_TRACE(0, "TQUEUE_SHOW: %u queued, head %d\n",
+				kfifo_len(&queue->fifo), data);
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Consumes the entire queue by peeking at the head and skipping it,
+*		instead of copying it out with kfifo_get
+*
+* @param context Context of the queue.
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_tqueue(void *context, project2_hist *hist)
+{
+	project2_tqueue *queue = context;
+	int data;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_tqueue is NULL\n");
+		return -EINVAL;
+	}
+
+	for (;;) {
+		start = project2_time_start(hist);
+
+		if (!kfifo_peek(&queue->fifo, &data))
+			break;
+
+		PROJECT2_TRACE(index++, "TQUEUE_DEQUEUE: %d\n", data);
+		kfifo_skip(&queue->fifo);
+
+		project2_time_end(hist, start);
+
+		project2_yield(index);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Enqueues the whole array with a single kfifo_in
+*
+* @param context Context of the queue
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int add_batch_tqueue(void *context, const int *keys, int nr)
+{
+	project2_tqueue *queue = context;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_tqueue is NULL\n");
+		return -EINVAL;
+	}
+
+	if (kfifo_avail(&queue->fifo) < (unsigned int)nr) {
+		printk(KERN_INFO "enqueue failed due to less space\n");
+		return -ENOMEM;
+	}
+
+	kfifo_in(&queue->fifo, keys, nr);
+
+	return 0;
+}
+
+/**
+* @brief Dequeues up to nr elements with a single kfifo_out
+*
+* @param context Context of the queue
+* @param keys Receives the dequeued values
+* @param nr Maximum number of elements to dequeue
+*
+* @return Number of dequeued elements or appropriate error codes on failure
+*/
+static int remove_batch_tqueue(void *context, int *keys, int nr)
+{
+	project2_tqueue *queue = context;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_tqueue is NULL\n");
+		return -EINVAL;
+	}
+
+	return kfifo_out(&queue->fifo, keys, nr);
+}
+
+/**
+* @brief Initializes the context by allocating a typed kfifo for the test
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_tqueue(int size, void **context)
+{
+	// Get the ceiling power 2 for the size.
+	int qsize = project2_queue_size(size);
+	project2_tqueue *queue;
+
+	if (qsize < 0) {
+		printk (KERN_INFO "integer overflow while getting power of 2\n");
+		return -EINVAL;
+	}
+
+	queue = kmalloc(sizeof(project2_tqueue), GFP_KERNEL);
+	if (queue == NULL) {
+		printk (KERN_INFO "memory allocation for tqueue failed\n");
+		return -ENOMEM;
+	}
+
+	// The size of a typed kfifo is counted in elements.
+	if (kfifo_alloc(&queue->fifo, qsize, GFP_KERNEL)) {
+		kfree(queue);
+		printk (KERN_INFO "memory allocation for tqueue kfifo_alloc failed\n");
+		return -ENOMEM;
+	}
+
+	*context = queue;
+	return 0;
+}
+
+/**
+* @brief Deallocates the context
+*
+* @param context Context for the queue
+*/
+static void deinit_tqueue(void *context)
+{
+	project2_tqueue *queue = context;
+
+	if (queue) {
+		kfifo_free(&queue->fifo);
+		kfree(queue);
+	}
+}
+
+// Generates the handles for the tqueue test-case
+PROJECT2_GENERATE_HANDLE(tqueue,
+			PROJECT2_HANDLE_OP(tqueue, add_batch),
+			PROJECT2_HANDLE_OP(tqueue, remove_batch));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 typed kfifo queue with bulk and peek operations\n");
@@ -0,0 +1,402 @@
+#include <linux/module.h>
+#include <linux/list.h>
+#include <linux/slab.h>
+#include <linux/cache.h>
+#include "project2.h"
+
+/**
+* @brief Number of values in a node, what is left of one cache line after
+*		the link and the count. 11 values in 64 bytes on 64-bit.
+*/
+#define PROJECT2_ULIST_SLOTS ((L1_CACHE_BYTES - sizeof(struct list_head) - \
+						sizeof(int)) / sizeof(int))
+
+/**
+* @brief Node of the unrolled list, a block of values sharing one link.
+*
+* The node is exactly one cache line and aligned to it, so walking a node
+* touches a single line. Only the last node may be partly filled, except
+* after remove_batch which takes values from the front of the first node.
+*/
+typedef struct project2_ulist_t {
+	struct list_head list;
+	int nr; /*Number of values in data */
+	int data[PROJECT2_ULIST_SLOTS]; /*Values in insertion order */
+} ____cacheline_aligned project2_ulist;
+
+/**
+* @brief Allocator for the unrolled list nodes
+*/
+project2_pool project2_ulist_pool = PROJECT2_POOL_INIT("project2_ulist",
+									project2_ulist);
+
+/**
+* @brief Helper API to get a node with a free slot at the tail of the list.
+*
+* @param head Head of the list.
+* @param batch Batch of the ulist pool to allocate the node from.
+*
+* @return Address of the node or NULL if the allocation failed
+*/
+static project2_ulist *__tail_ulist(struct list_head *head,
+						project2_pool_batch *batch)
+{
+	project2_ulist *tmp;
+
+	if (!list_empty(head)) {
+		tmp = list_last_entry(head, project2_ulist, list);
+		if (tmp->nr < PROJECT2_ULIST_SLOTS)
+			return tmp;
+	}
+
+	tmp = project2_pool_get(batch, project2_gfp);
+
+	if (tmp == NULL) {
+		printk (KERN_INFO "memory allocation for ulist addition failed\n");
+		return NULL;
+	}
+
+	tmp->nr = 0;
+
+	list_add_tail(&tmp->list, head);
+
+	return tmp;
+}
+
+/**
+* @brief Add size number of random numbers to the list
+*
+* @param context Context information for the list
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_ulist(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	int data;
+	struct list_head *head = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_ulist_pool);
+	project2_ulist *tmp;
+	int ret = 0;
+	int tmp_size = size;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_ulist is NULL\n");
+		return -EINVAL;
+	}
+
+	while (tmp_size--) {
+
+		if (project2_yield(size - tmp_size - 1)) {
+			ret = -EINTR;
+			break;
+		}
+
+		data = keys[size - tmp_size - 1];
+
+		start = project2_time_start(hist);
+
+		tmp = __tail_ulist(head, &batch);
+		if (tmp)
+			tmp->data[tmp->nr++] = data;
+
+		project2_time_end(hist, start);
+
+		if (tmp == NULL) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		PROJECT2_TRACE(tmp_size, "ULIST_ADD: %d\n", data);
+	}
+
+	// Release the nodes which were allocated in bulk but not used.
+	project2_pool_flush(&batch);
+
+	PROJECT2_TRACE(0, "\n");
+
+	return ret;
+}
+
+/**
+* @brief Prints the contents of the list from head
+*
+* @param context Context of the list
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_ulist(void *context, project2_hist *hist)
+{
+	struct list_head *head = context;
+	project2_ulist *tmp;
+	unsigned long index = 0;
+	int slot;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to show_ulist is NULL\n");
+		return;
+	}
+
+	if (list_empty(head))
+		return;
+
+	start = project2_time_start(hist);
+
+	list_for_each_entry(tmp, head, list) {
+		for (slot = 0; slot < tmp->nr; slot++) {
+			PROJECT2_TRACE(index++, "ULIST_SHOW: %d\n",
+							tmp->data[slot]);
+
+			// Each sample covers the step to the value and its processing.
+			project2_time_end(hist, start);
+
+			if (project2_yield(index))
+				return;
+
+			start = project2_time_start(hist);
+		}
+	}
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Removes the entire list, one node per block of values.
+*
+* @param context Context of the list.
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_ulist(void *context, project2_hist *hist)
+{
+	struct list_head *head = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_ulist_pool);
+	project2_ulist *curr;
+	project2_ulist *next;
+	unsigned long index = 0;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_ulist is NULL\n");
+		return -EINVAL;
+	}
+
+	if (list_empty(head))
+		return 0;
+
+	list_for_each_entry_safe(curr, next, head, list)
+	{
+		start = project2_time_start(hist);
+		list_del(&curr->list);
+		PROJECT2_TRACE(index++, "ULIST_DEL: %d values\n", curr->nr);
+		project2_pool_put(&batch, curr);
+		project2_time_end(hist, start);
+
+		project2_yield(index);
+	}
+
+	project2_pool_flush(&batch);
+
+	show_ulist(context, NULL);
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Appends nr keys to the list, a block at a time
+*
+* @param context Context of the list
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int add_batch_ulist(void *context, const int *keys, int nr)
+{
+	struct list_head *head = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_ulist_pool);
+	project2_ulist *tmp;
+	int ret = 0;
+	int count;
+	int i;
+
+	if (!context) {
+		printk(KERN_INFO "context to add_batch_ulist is NULL\n");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < nr; i += count) {
+		tmp = __tail_ulist(head, &batch);
+		if (tmp == NULL) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		count = min_t(int, nr - i, PROJECT2_ULIST_SLOTS - tmp->nr);
+
+		memcpy(tmp->data + tmp->nr, keys + i, count * sizeof(int));
+		tmp->nr += count;
+	}
+
+	project2_pool_flush(&batch);
+
+	return ret;
+}
+
+/**
+* @brief Removes up to nr elements from the head of the list
+*
+* @param context Context of the list
+* @param keys Receives the removed values
+* @param nr Maximum number of elements to remove
+*
+* @return Number of removed elements or appropriate error codes on failure
+*/
+static int remove_batch_ulist(void *context, int *keys, int nr)
+{
+	struct list_head *head = context;
+	project2_pool_batch batch = PROJECT2_POOL_BATCH_INIT(&project2_ulist_pool);
+	project2_ulist *curr;
+	project2_ulist *next;
+	int count = 0;
+	int take;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_batch_ulist is NULL\n");
+		return -EINVAL;
+	}
+
+	list_for_each_entry_safe(curr, next, head, list) {
+		if (count == nr)
+			break;
+
+		take = min(nr - count, curr->nr);
+
+		memcpy(keys + count, curr->data, take * sizeof(int));
+		count += take;
+
+		if (take == curr->nr) {
+			list_del(&curr->list);
+			project2_pool_put(&batch, curr);
+			continue;
+		}
+
+		// Keep the values of the partly drained node at its front.
+		curr->nr -= take;
+		memmove(curr->data, curr->data + take, curr->nr * sizeof(int));
+	}
+
+	project2_pool_flush(&batch);
+
+	return count;
+}
+
+/**
+* @brief Adds up the values of the list, reading every one of them
+*
+* @param context Context of the list
+*
+* @return Sum of the values, partial if the run was cancelled
+*/
+static s64 sum_ulist(void *context)
+{
+	struct list_head *head = context;
+	project2_ulist *tmp;
+	unsigned long nodes = 0;
+	s64 sum = 0;
+	int slot;
+
+	if (!context)
+		return 0;
+
+	list_for_each_entry(tmp, head, list) {
+		for (slot = 0; slot < tmp->nr; slot++)
+			sum += tmp->data[slot];
+
+		if (project2_yield(++nodes))
+			break;
+	}
+
+	return sum;
+}
+
+/**
+* @brief Searches the list for key
+*
+* @param context Context of the list
+* @param key Value to be searched
+*
+* @return true if key is present in the list
+*/
+static bool lookup_ulist(void *context, int key)
+{
+	struct list_head *head = context;
+	project2_ulist *tmp;
+	int slot;
+
+	if (!context)
+		return false;
+
+	list_for_each_entry(tmp, head, list)
+		for (slot = 0; slot < tmp->nr; slot++)
+			if (tmp->data[slot] == key)
+				return true;
+
+	return false;
+}
+
+/**
+* @brief Initializes the context by adding a head for the test
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_ulist (int size, void **context)
+{
+	struct list_head *head = kmalloc(sizeof(struct list_head), GFP_KERNEL);
+
+	BUILD_BUG_ON(sizeof(project2_ulist) != L1_CACHE_BYTES);
+
+	if (head == NULL) {
+		printk (KERN_INFO "memory allocation for ulist head failed\n");
+		return -ENOMEM;
+	}
+
+	INIT_LIST_HEAD(head);
+
+	*context = head;
+
+	return 0;
+}
+
+/**
+* @brief Deallocates the context
+*
+* @param context Context for the List
+*/
+static void deinit_ulist(void *context)
+{
+	if (context)
+		kfree(context);
+}
+
+// Generates the handles for the unrolled list test-case
+PROJECT2_GENERATE_HANDLE(ulist,
+			PROJECT2_HANDLE_OP(ulist, add_batch),
+			PROJECT2_HANDLE_OP(ulist, remove_batch),
+			PROJECT2_HANDLE_OP(ulist, lookup),
+			PROJECT2_HANDLE_OP(ulist, sum));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 for manipulation of unrolled list data structures\n");
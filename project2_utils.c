@@ -1,30 +1,95 @@
 #include <linux/module.h>
 #include <linux/random.h>
+#include <linux/log2.h>
 #include "project2.h"
 
 /**
-* @brief Returns a random integer from 0 to (size/size*4) based on size
+* @brief Every how many elements the data structures log one element.
+*		Logs every element unless the benchmark mode changes it.
+*/
+int project2_trace_interval = 1;
+
+/**
+* @brief Returns the key range used for size elements, which is
+*		size*4 unless that overflows
 *
-* @param size Seed for defining boundary conditions
+* @param size Number of elements to be inserted
 *
-* @return Random Integer
+* @return Upper bound (EXCLUSIVE) of the keys
 */
-int project2_get_next_integer(int size)
+int project2_key_range(int size)
 {
-	int retval = get_random_int();
-
-	if (retval < 0)
-		retval = -(1 + retval);
-
 	if (size <= 0)
-		return retval % 100;
+		return 100;
 
 	if (size < INT_MAX / 4)
-		retval = retval % (size * 4);
-	else
-		retval = retval % size;
+		return size * 4;
+
+	return size;
+}
+
+/**
+* @brief Starts a sequence of distinct keys in [0, range)
+*
+* @param seq Sequence to be initialized
+* @param range Upper bound (EXCLUSIVE) of the keys
+* @param rnd Random state drawing the parameters of the sequence
+*/
+void project2_keyseq_init(project2_keyseq *seq, u32 range,
+						struct rnd_state *rnd)
+{
+	u32 bits;
+
+	seq->range = range ? range : 1;
+
+	bits = seq->range > 1 ? ilog2(seq->range - 1) + 1 : 1;
+
+	seq->mask = bits < 32 ? (1U << bits) - 1 : U32_MAX;
+	seq->shift = (bits + 1) / 2;
+	seq->mult = (prandom_u32_state(rnd) & ~3U) | 1;
+	seq->inc = prandom_u32_state(rnd) | 1;
+	seq->state = prandom_u32_state(rnd) & seq->mask;
+}
+
+/**
+* @brief Returns the next key of the sequence, distinct from the previous
+*		ones until the range is exhausted
+*
+* @param seq Sequence initialized by project2_keyseq_init
+*
+* @return Key in [0, range)
+*/
+int project2_keyseq_next(project2_keyseq *seq)
+{
+	u32 value;
+
+	// Less than two steps on average as the modulus is below 2 * range.
+	do {
+		seq->state = (seq->state * seq->mult + seq->inc) & seq->mask;
+
+		// Xorshift and odd multiply are bijections on the masked bits.
+		value = seq->state ^ (seq->state >> seq->shift);
+		value = (value * 0x9E3779B1U) & seq->mask;
+		value ^= value >> seq->shift;
+	} while (value >= seq->range);
+
+	return value;
+}
+
+/**
+* @brief Comparison callback for sorting the integer keys
+*
+* @param a First key
+* @param b Second key
+*
+* @return Negative, zero or positive as a is below, equal to or above b
+*/
+int project2_cmp_int(const void *a, const void *b)
+{
+	int lhs = *(const int *)a;
+	int rhs = *(const int *)b;
 
-	return retval;
+	return (lhs > rhs) - (lhs < rhs);
 }
 
 // Module related macros
@@ -0,0 +1,500 @@
+#include <linux/module.h>
+#include <linux/random.h>
+#include <linux/mm.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include "project2.h"
+
+/**
+* @brief Fraction bits of the fixed point numbers used for the Zipfian.
+*		The kernel offers no floating point, so pow() is built from
+*		fixed point log2 and exp2.
+*/
+#define FX_SHIFT 32
+#define FX_ONE (1ULL << FX_SHIFT)
+
+/**
+* @brief Terms of the Zipfian normalization summed exactly, the rest of
+*		the sum is approximated by its integral.
+*/
+#define ZIPF_EXACT_TERMS 65536
+
+/**
+* @brief Largest 32 bit prime, it scatters hot ranks over the key range
+*/
+#define SCATTER_PRIME 4294967291ULL
+
+/**
+* @brief Default parameters of the workload generator
+*/
+project2_workload_params project2_wl_params = {
+	.dist = PROJECT2_DIST_UNIQUE,
+	.zipf_theta = 99,
+	.hot_keys_pct = 10,
+	.hot_ops_pct = 90,
+	.saw_period = 1000,
+	.op_pct = { 100, 0, 0 },
+	.seed = 0,
+};
+
+/**
+* @brief Names of the distributions indexed by project2_dist
+*/
+static const char * const dist_names[] = {
+	"unique",
+	"uniform",
+	"sequential",
+	"reverse",
+	"zipf",
+	"hotset",
+	"sawtooth"
+};
+
+/**
+* @brief 2^(2^-(i+1)) in Q31 for the fraction bits of fx_exp2
+*/
+static const u32 fx_exp2_table[] = {
+	0xb504f334, 0x9837f052, 0x8b95c1e4, 0x85aac368,
+	0x82cd8699, 0x8164d1f4, 0x80b1ed50, 0x8058d7d3,
+	0x802c6437, 0x8016302f, 0x800b179d, 0x80058baf,
+	0x8002c5d0, 0x800162e6, 0x8000b173, 0x800058b9,
+	0x80002c5d, 0x8000162e, 0x80000b17, 0x8000058c,
+	0x800002c6, 0x80000163, 0x800000b1, 0x80000059,
+	0x8000002c, 0x80000016, 0x8000000b, 0x80000006,
+	0x80000003, 0x80000001, 0x80000001,
+};
+
+/**
+* @brief State of the Zipfian generator (Gray et al., as used by YCSB)
+*/
+typedef struct project2_zipf_t {
+	u64 n; /*Number of ranks */
+	u64 zetan; /*Sum of i^-theta for i in [1, n], Q32 */
+	u64 zeta2; /*1 + 2^-theta, Q32 */
+	u64 eta; /*Scaling of the inverse CDF, Q32 */
+	s64 alpha; /*1 / (1 - theta), Q16 */
+} project2_zipf;
+
+/**
+* @brief Fixed point log2
+*
+* @param x Positive value in Q32
+*
+* @return log2(x) in Q32
+*/
+static s64 fx_log2(u64 x)
+{
+	int msb = ilog2(x);
+	s64 result = (s64)(msb - FX_SHIFT) * (s64)FX_ONE;
+	u64 mantissa;
+	int bit;
+
+	// Normalize the mantissa to [1, 2) in Q31 so that its square fits.
+	mantissa = msb >= 31 ? x >> (msb - 31) : x << (31 - msb);
+
+	for (bit = FX_SHIFT - 1; bit >= 0; bit--) {
+		mantissa = (mantissa * mantissa) >> 31;
+		if (mantissa >= (2ULL << 31)) {
+			mantissa >>= 1;
+			result += 1LL << bit;
+		}
+	}
+
+	return result;
+}
+
+/**
+* @brief Fixed point exp2
+*
+* @param y Exponent in Q32
+*
+* @return 2^y in Q32, saturated to U64_MAX
+*/
+static u64 fx_exp2(s64 y)
+{
+	s64 shift = (y >> FX_SHIFT) + 1;
+	u32 fraction = (u32)y;
+	u64 result = 1ULL << 31;
+	int bit;
+
+	for (bit = 0; bit < ARRAY_SIZE(fx_exp2_table); bit++)
+		if (fraction & (1U << (31 - bit)))
+			result = (result * fx_exp2_table[bit]) >> 31;
+
+	// result is in Q31, the extra shift converts it to Q32.
+	if (shift >= 0)
+		return shift > 31 ? U64_MAX : result << shift;
+
+	return shift <= -63 ? 0 : result >> -shift;
+}
+
+/**
+* @brief Fixed point pow
+*
+* @param x Positive base in Q32
+* @param y Exponent in Q16
+*
+* @return x^y in Q32
+*/
+static u64 fx_pow(u64 x, s64 y)
+{
+	return fx_exp2((y * fx_log2(x)) >> 16);
+}
+
+/**
+* @brief Precomputes the constants of the Zipfian over n ranks
+*
+* @param zipf State to be initialized
+* @param n Number of ranks, at least 3
+* @param theta Skew in hundredths, 1..99
+*/
+static void __zipf_init(project2_zipf *zipf, u64 n, int theta)
+{
+	s64 theta_q16 = div_s64((s64)theta << 16, 100);
+	s64 rest_q16 = (1 << 16) - theta_q16;
+	u64 exact = min_t(u64, n, ZIPF_EXACT_TERMS);
+	u64 tail;
+	u64 num;
+	u64 den;
+	u64 i;
+
+	zipf->n = n;
+	zipf->alpha = div_s64(100LL << 16, 100 - theta);
+
+	zipf->zetan = 0;
+	for (i = 1; i <= exact; i++)
+		zipf->zetan += fx_pow(i << FX_SHIFT, -theta_q16);
+
+	// Integral of x^-theta over [exact + 1/2, n + 1/2] for the tail.
+	if (n > exact) {
+		tail = fx_pow((2 * n + 1) << (FX_SHIFT - 1), rest_q16) -
+				fx_pow((2 * exact + 1) << (FX_SHIFT - 1), rest_q16);
+		zipf->zetan += mul_u64_u64_shr(tail, zipf->alpha, 16);
+	}
+
+	zipf->zeta2 = FX_ONE + fx_pow(2ULL << FX_SHIFT, -theta_q16);
+
+	num = FX_ONE - fx_pow(div64_u64(2ULL << FX_SHIFT, n), rest_q16);
+	den = FX_ONE - div64_u64(zipf->zeta2 << 16, zipf->zetan >> 16);
+	zipf->eta = div64_u64(num << 16, max_t(u64, den >> 16, 1));
+}
+
+/**
+* @brief Draws the next rank of the Zipfian, rank 0 being the hottest
+*
+* @param zipf State initialized by __zipf_init
+* @param rnd Random state
+*
+* @return Rank in [0, n)
+*/
+static u64 __zipf_next(const project2_zipf *zipf, struct rnd_state *rnd)
+{
+	u64 u = prandom_u32_state(rnd);
+	u64 uz = mul_u64_u64_shr(u, zipf->zetan, FX_SHIFT);
+	u64 scaled = mul_u64_u64_shr(zipf->eta, FX_ONE - u, FX_SHIFT);
+	u64 rank;
+
+	if (uz < FX_ONE)
+		return 0;
+
+	if (uz < zipf->zeta2)
+		return 1;
+
+	if (scaled >= FX_ONE)
+		return 0;
+
+	rank = (zipf->n * fx_pow(FX_ONE - scaled, zipf->alpha)) >> FX_SHIFT;
+
+	return min(rank, zipf->n - 1);
+}
+
+/**
+* @brief Returns a uniform value in [0, bound)
+*
+* @param rnd Random state
+* @param bound Upper bound (EXCLUSIVE), must be positive
+*
+* @return Random value
+*/
+static u32 __uniform(struct rnd_state *rnd, u32 bound)
+{
+	return ((u64)prandom_u32_state(rnd) * bound) >> 32;
+}
+
+/**
+* @brief Spreads a rank over the key range with a bijection, so that the
+*		hot keys are not all next to each other.
+*
+* @param rank Rank in [0, range)
+* @param range Upper bound (EXCLUSIVE) of the keys
+*
+* @return Key in [0, range)
+*/
+static int __scatter(u64 rank, int range)
+{
+	u32 key;
+
+	div_u64_rem(rank * SCATTER_PRIME, range, &key);
+
+	return key;
+}
+
+/**
+* @brief Looks up a distribution by name
+*
+* @param name Name of the distribution
+*
+* @return project2_dist or -EINVAL if the name is unknown
+*/
+int project2_dist_parse(const char *name)
+{
+	int dist;
+
+	for (dist = 0; dist < PROJECT2_NR_DISTS; dist++)
+		if (sysfs_streq(name, dist_names[dist]))
+			return dist;
+
+	return -EINVAL;
+}
+
+/**
+* @brief Returns the name of a distribution
+*
+* @param dist Distribution
+*
+* @return Name of the distribution
+*/
+const char *project2_dist_name(project2_dist dist)
+{
+	if (dist < 0 || dist >= PROJECT2_NR_DISTS)
+		return "invalid";
+
+	return dist_names[dist];
+}
+
+/**
+* @brief State of the key distributions carried across chunks
+*/
+typedef struct project2_keygen_t {
+	project2_keyseq seq; /*Distinct keys for the unique distribution */
+	project2_zipf zipf; /*Ranks of the Zipfian distribution */
+	int hot_keys; /*Number of hot keys of the hot-set distribution */
+	int period; /*Keys per tooth of the sawtooth distribution */
+	int step; /*Distance between two keys of a tooth */
+} project2_keygen;
+
+/**
+* @brief Prepares the distribution of the workload
+*
+* @param gen State to be initialized
+* @param wl Workload whose random state is seeded
+* @param params Parameters of the generator
+*
+* @return 0 for success or -EINVAL if the parameters do not fit the range
+*/
+static int __keygen_init(project2_keygen *gen, project2_workload *wl,
+				const project2_workload_params *params)
+{
+	switch (params->dist) {
+	case PROJECT2_DIST_UNIQUE:
+		project2_keyseq_init(&gen->seq, wl->range, &wl->rnd);
+		break;
+
+	case PROJECT2_DIST_ZIPF:
+		if (params->zipf_theta < 1 || params->zipf_theta > 99 ||
+				wl->range < 3)
+			return -EINVAL;
+
+		__zipf_init(&gen->zipf, wl->range, params->zipf_theta);
+		break;
+
+	case PROJECT2_DIST_HOTSET:
+		gen->hot_keys = max(1, (int)div_s64((s64)wl->range *
+						params->hot_keys_pct, 100));
+		break;
+
+	case PROJECT2_DIST_SAWTOOTH:
+		// Every tooth climbs the range, the next one starts one higher.
+		gen->period = max(1, params->saw_period);
+		gen->step = max(1, wl->range / gen->period);
+		break;
+
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+/**
+* @brief Fills the keys and ops in [from, to) of the workload
+*
+* @param gen State of the distribution
+* @param wl Workload to be filled
+* @param params Parameters of the generator
+* @param from First index to be filled
+* @param to Index one past the last one to be filled
+*/
+static void __keygen_fill(project2_keygen *gen, project2_workload *wl,
+			const project2_workload_params *params, int from, int to)
+{
+	int range = wl->range;
+	u32 tooth;
+	int roll;
+	int op;
+	int i;
+
+	for (i = from; i < to; i++) {
+		switch (params->dist) {
+		case PROJECT2_DIST_UNIQUE:
+			wl->keys[i] = project2_keyseq_next(&gen->seq);
+			break;
+
+		case PROJECT2_DIST_UNIFORM:
+			wl->keys[i] = __uniform(&wl->rnd, range);
+			break;
+
+		case PROJECT2_DIST_SEQUENTIAL:
+			wl->keys[i] = i % range;
+			break;
+
+		case PROJECT2_DIST_REVERSE:
+			wl->keys[i] = range - 1 - i % range;
+			break;
+
+		case PROJECT2_DIST_ZIPF:
+			wl->keys[i] = __scatter(__zipf_next(&gen->zipf, &wl->rnd),
+							range);
+			break;
+
+		case PROJECT2_DIST_HOTSET:
+			if (gen->hot_keys >= range ||
+					__uniform(&wl->rnd, 100) < params->hot_ops_pct)
+				roll = __uniform(&wl->rnd, gen->hot_keys);
+			else
+				roll = gen->hot_keys +
+					__uniform(&wl->rnd, range - gen->hot_keys);
+
+			wl->keys[i] = __scatter(roll, range);
+			break;
+
+		case PROJECT2_DIST_SAWTOOTH:
+			div_u64_rem((u64)(i % gen->period) * gen->step +
+					i / gen->period, range, &tooth);
+			wl->keys[i] = tooth;
+			break;
+
+		default:
+			break;
+		}
+
+		roll = __uniform(&wl->rnd, 100);
+
+		for (op = PROJECT2_OP_INSERT; op < PROJECT2_OP_DELETE; op++) {
+			if (roll < params->op_pct[op])
+				break;
+			roll -= params->op_pct[op];
+		}
+
+		wl->ops[i] = op;
+	}
+}
+
+/**
+* @brief Pre-generates nr keys in [0, range) and their ops
+*
+* @param wl Workload to be filled, released with project2_workload_free
+* @param params Parameters of the generator
+* @param nr Number of keys
+* @param range Upper bound (EXCLUSIVE) of the keys
+*
+* @return 0 for success or appropriate error code on failure.
+*/
+int project2_workload_generate(project2_workload *wl,
+			const project2_workload_params *params, int nr, int range)
+{
+	project2_keygen gen;
+	int ret;
+	int i;
+
+	if (nr <= 0 || range <= 0 || params->dist < 0 ||
+			params->dist >= PROJECT2_NR_DISTS)
+		return -EINVAL;
+
+	if (params->op_pct[PROJECT2_OP_INSERT] + params->op_pct[PROJECT2_OP_LOOKUP] +
+			params->op_pct[PROJECT2_OP_DELETE] != 100)
+		return -EINVAL;
+
+	wl->keys = kvmalloc_array(nr, sizeof(int), GFP_KERNEL);
+	wl->ops = kvmalloc_array(nr, sizeof(u8), GFP_KERNEL);
+
+	if (wl->keys == NULL || wl->ops == NULL) {
+		printk (KERN_INFO "memory allocation for workload failed\n");
+		project2_workload_free(wl);
+		return -ENOMEM;
+	}
+
+	wl->nr = nr;
+	wl->range = range;
+	wl->seed = params->seed ? params->seed : get_random_u64();
+
+	prandom_seed_state(&wl->rnd, wl->seed);
+
+	ret = __keygen_init(&gen, wl, params);
+	if (ret) {
+		project2_workload_free(wl);
+		return ret;
+	}
+
+	// Generated in chunks so that huge workloads reach a resched point.
+	for (i = 0; i < nr; i += PROJECT2_RESCHED_INTERVAL) {
+		if (project2_yield(i)) {
+			project2_workload_free(wl);
+			return -EINTR;
+		}
+
+		__keygen_fill(&gen, wl, params, i,
+				min(nr, i + PROJECT2_RESCHED_INTERVAL));
+	}
+
+	return 0;
+}
+
+/**
+* @brief Releases the buffers of the workload
+*
+* @param wl Workload to be released
+*/
+void project2_workload_free(project2_workload *wl)
+{
+	kvfree(wl->keys);
+	kvfree(wl->ops);
+
+	wl->keys = NULL;
+	wl->ops = NULL;
+	wl->nr = 0;
+}
+
+/**
+* @brief Prints the parameters which reproduce the workload
+*
+* @param wl Workload generated by project2_workload_generate
+* @param params Parameters it was generated with
+*/
+void project2_workload_print(const project2_workload *wl,
+			const project2_workload_params *params)
+{
+	project2_report("Workload: %d keys in [0, %d) dist %s theta 0.%02d "
+			"hot %d%% keys/%d%% ops period %d mix %d/%d/%d seed %llu\n",
+			wl->nr, wl->range, project2_dist_name(params->dist),
+			params->zipf_theta, params->hot_keys_pct,
+			params->hot_ops_pct, params->saw_period,
+			params->op_pct[PROJECT2_OP_INSERT],
+			params->op_pct[PROJECT2_OP_LOOKUP],
+			params->op_pct[PROJECT2_OP_DELETE], wl->seed);
+}
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 workload generator for the data structures\n");
@@ -0,0 +1,471 @@
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/xarray.h>
+#include <linux/rcupdate.h>
+#include "project2.h"
+
+/**
+* @brief Context for xarray test
+*
+* The integers are stored inline as value entries, so unlike the IDR of
+* the map no side buffer holds the data.
+*/
+typedef struct project2_xarray_context_t {
+	struct xarray xa; /*Allocating XArray, locked internally */
+	u32 limit; /*Ids handed out by add are below limit */
+	u32 next; /*Next id tried by the cyclic mode */
+	project2_id_mode mode; /*How add picks the ids */
+} project2_xarray_context;
+
+/**
+* @brief Stores key under an id selected by the mode of the xarray
+*
+* @param xa_context Context of the xarray
+* @param id Receives the id
+* @param key Key to be inserted, the id itself in the sparse mode
+*
+* @return 0 for success or appropriate error codes on failure
+*/
+static int __alloc_xarray_id(project2_xarray_context *xa_context, u32 *id,
+								int key)
+{
+	int ret;
+
+	switch (xa_context->mode) {
+	case PROJECT2_ID_CYCLIC:
+		ret = xa_alloc_cyclic(&xa_context->xa, id, xa_mk_value(key),
+				XA_LIMIT(0, xa_context->limit - 1),
+				&xa_context->next, project2_gfp);
+
+		// 1 tells that the ids wrapped around, which is still a success.
+		return ret < 0 ? ret : 0;
+
+	case PROJECT2_ID_SPARSE:
+		*id = key;
+		return xa_insert(&xa_context->xa, key, xa_mk_value(key),
+							project2_gfp);
+
+	default:
+		return xa_alloc(&xa_context->xa, id, xa_mk_value(key),
+				XA_LIMIT(0, xa_context->limit - 1), project2_gfp);
+	}
+}
+
+/**
+* @brief Drops the xa_lock every PROJECT2_RESCHED_INTERVAL elements of a
+*		walk, the walk resumes after the current index.
+*
+* @param xas State of the walk, paused before the lock is dropped
+* @param index Number of elements walked
+*
+* @return true if the run has been cancelled
+*/
+static bool __xas_yield_locked(struct xa_state *xas, unsigned long index)
+{
+	bool stop;
+
+	if (!index || (index % PROJECT2_RESCHED_INTERVAL))
+		return false;
+
+	xas_pause(xas);
+	xas_unlock(xas);
+	stop = project2_yield(index);
+	xas_lock(xas);
+
+	return stop;
+}
+
+/**
+* @brief Add size number of Random Integers to the xarray under freshly
+*		allocated ids
+*
+* @param context Context information for the xarray
+* @param keys Keys to be inserted
+* @param size Number of Random Integers to be inserted
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 if successful otherwise appropriate error codes
+*/
+static int add_xarray(void *context, const int *keys, int size,
+						project2_hist *hist)
+{
+	project2_xarray_context *xa_context = context;
+	int tmp_size = size;
+	int data;
+	int ret;
+	u32 id;
+	u64 start;
+
+	if (!xa_context) {
+		printk(KERN_INFO "context to add_xarray is NULL\n");
+		return -EINVAL;
+	}
+
+	while (size--) {
+
+		if (project2_yield(tmp_size - size - 1))
+			return -EINTR;
+
+		data = keys[tmp_size - size - 1];
+
+		// Value entries hold non-negative integers only.
+		if (data < 0)
+			return -EINVAL;
+
+		start = project2_time_start(hist);
+
+		ret = __alloc_xarray_id(xa_context, &id, data);
+
+		project2_time_end(hist, start);
+
+		if (ret) {
+			if (ret == -EBUSY)
+				printk(KERN_INFO "No space in the range\n");
+			else
+				printk(KERN_INFO "Memory allocation failure for the UID\n");
+			return ret;
+		}
+
+		PROJECT2_TRACE(size, "XARRAY_ADD<id,value>: <%u, %d>\n", id, data);
+	}
+
+	PROJECT2_TRACE(0, "\n");
+
+	return 0;
+}
+
+/**
+* @brief Prints the contents of the xarray with an RCU walk
+*
+* @param context Context of the xarray
+* @param hist Histogram for per element latency, may be NULL
+*/
+static void show_xarray(void *context, project2_hist *hist)
+{
+	project2_xarray_context *xa_context = context;
+	XA_STATE(xas, NULL, 0);
+	unsigned long index = 0;
+	bool stop = false;
+	void *entry;
+	u64 start;
+
+	if (!xa_context) {
+		printk(KERN_INFO "context to show_xarray is NULL\n");
+		return;
+	}
+
+	xas.xa = &xa_context->xa;
+
+	rcu_read_lock();
+
+	start = project2_time_start(hist);
+
+	xas_for_each(&xas, entry, ULONG_MAX) {
+		if (xas_retry(&xas, entry))
+			continue;
+
+		PROJECT2_TRACE(index, "XARRAY_SHOW<id,value>: <%lu, %lu>\n",
+					xas.xa_index, xa_to_value(entry));
+
+		// Each sample covers the step to the next entry and its processing.
+		project2_time_end(hist, start);
+
+		// RCU readers must not sleep, so pause the walk to yield.
+		if (!(++index % PROJECT2_RESCHED_INTERVAL)) {
+			xas_pause(&xas);
+			rcu_read_unlock();
+			stop = project2_yield(index);
+			rcu_read_lock();
+
+			if (stop)
+				break;
+		}
+
+		start = project2_time_start(hist);
+	}
+
+	rcu_read_unlock();
+
+	PROJECT2_TRACE(0, "\n");
+}
+
+/**
+* @brief Destroys the entire xarray
+*
+* @param context Context of the xarray
+* @param hist Histogram for per element latency, may be NULL
+*
+* @return 0 for success and appropriate error codes on failure
+*/
+static int remove_xarray(void *context, project2_hist *hist)
+{
+	project2_xarray_context *xa_context = context;
+	XA_STATE(xas, NULL, 0);
+	unsigned long index = 0;
+	void *entry;
+	u64 start;
+
+	if (!context) {
+		printk(KERN_INFO "context to remove_xarray is NULL\n");
+		return -EINVAL;
+	}
+
+	xas.xa = &xa_context->xa;
+
+	xas_lock(&xas);
+
+	// Erase the entries one by one so that every element gets timed.
+	xas_for_each(&xas, entry, ULONG_MAX) {
+		start = project2_time_start(hist);
+		xas_store(&xas, NULL);
+		project2_time_end(hist, start);
+
+		__xas_yield_locked(&xas, ++index);
+	}
+
+	xas_unlock(&xas);
+
+	xa_destroy(&xa_context->xa);
+	printk(KERN_INFO "Destroyed entire xarray\n");
+
+	show_xarray(context, NULL);
+
+	return 0;
+}
+
+/**
+* @brief Inserts nr keys, using every key as its own index
+*
+* xa_store_range would store one entry over a range of indices, the
+* values differ per index here, so the whole batch is stored in a single
+* locked xas walk instead. The lock is only dropped to allocate nodes.
+*
+* @param context Context of the xarray
+* @param keys Keys to be inserted
+* @param nr Number of keys
+*
+* @return 0 for success, -EEXIST if some keys were already present or
+*		appropriate error codes on failure
+*/
+static int add_batch_xarray(void *context, const int *keys, int nr)
+{
+	project2_xarray_context *xa_context = context;
+	XA_STATE(xas, NULL, 0);
+	int ret = 0;
+	int i = 0;
+
+	if (!xa_context) {
+		printk(KERN_INFO "context to add_batch_xarray is NULL\n");
+		return -EINVAL;
+	}
+
+	xas.xa = &xa_context->xa;
+
+	xas_lock(&xas);
+
+	while (i < nr) {
+		if (keys[i] < 0) {
+			ret = -EINVAL;
+			break;
+		}
+
+		xas_set(&xas, keys[i]);
+
+		if (xas_load(&xas)) {
+			// The key is already present.
+			ret = -EEXIST;
+			i++;
+			continue;
+		}
+
+		xas_store(&xas, xa_mk_value(keys[i]));
+
+		if (xas_error(&xas) == -ENOMEM) {
+			// Allocate outside of the lock and retry the same key.
+			xas_unlock(&xas);
+			if (xas_nomem(&xas, project2_gfp)) {
+				xas_lock(&xas);
+				continue;
+			}
+			xas_lock(&xas);
+		}
+
+		if (xas_error(&xas)) {
+			ret = xas_error(&xas);
+			break;
+		}
+
+		// The slot was empty, so it stops being free for xa_alloc.
+		xas_clear_mark(&xas, XA_FREE_MARK);
+
+		i++;
+	}
+
+	xas_unlock(&xas);
+
+	// Releases a node which was allocated but not used.
+	xas_destroy(&xas);
+
+	return ret;
+}
+
+/**
+* @brief Removes up to nr elements with the smallest indices
+*
+* @param context Context of the xarray
+* @param keys Receives the removed values
+* @param nr Maximum number of elements to remove
+*
+* @return Number of removed elements or appropriate error codes on failure
+*/
+static int remove_batch_xarray(void *context, int *keys, int nr)
+{
+	project2_xarray_context *xa_context = context;
+	XA_STATE(xas, NULL, 0);
+	void *entry;
+	int count = 0;
+
+	if (!xa_context) {
+		printk(KERN_INFO "context to remove_batch_xarray is NULL\n");
+		return -EINVAL;
+	}
+
+	xas.xa = &xa_context->xa;
+
+	xas_lock(&xas);
+
+	xas_for_each(&xas, entry, ULONG_MAX) {
+		if (count == nr)
+			break;
+
+		keys[count++] = xa_to_value(entry);
+		xas_store(&xas, NULL);
+		xas_set_mark(&xas, XA_FREE_MARK);
+	}
+
+	xas_unlock(&xas);
+
+	return count;
+}
+
+/**
+* @brief Checks whether the index holds an element, without a lock
+*
+* @param context Context of the xarray
+* @param key Index to be searched
+*
+* @return true if an element is stored under the index
+*/
+static bool lookup_xarray(void *context, int key)
+{
+	project2_xarray_context *xa_context = context;
+
+	if (!xa_context || key < 0)
+		return false;
+
+	return xa_load(&xa_context->xa, key) != NULL;
+}
+
+/**
+* @brief Erases every index in [start, end]
+*
+* @param context Context of the xarray
+* @param start First index to be erased
+* @param end Last index to be erased (INCLUSIVE)
+*
+* @return Number of erased elements or appropriate error codes on failure
+*/
+static int remove_range_xarray(void *context, int start, int end)
+{
+	project2_xarray_context *xa_context = context;
+	XA_STATE(xas, NULL, 0);
+	unsigned long index = 0;
+	void *entry;
+	int count = 0;
+
+	if (!xa_context || start < 0 || end < start)
+		return -EINVAL;
+
+	xas.xa = &xa_context->xa;
+	xas_set(&xas, start);
+
+	xas_lock(&xas);
+
+	xas_for_each(&xas, entry, end) {
+		xas_store(&xas, NULL);
+		xas_set_mark(&xas, XA_FREE_MARK);
+		count++;
+
+		if (__xas_yield_locked(&xas, ++index))
+			break;
+	}
+
+	xas_unlock(&xas);
+
+	return count;
+}
+
+/**
+* @brief Deallocates the context
+*
+* @param context Context for the xarray
+*/
+static void deinit_xarray(void *context)
+{
+	project2_xarray_context *xa_context = context;
+
+	if (xa_context) {
+		xa_destroy(&xa_context->xa);
+		kfree(xa_context);
+	}
+}
+
+/**
+* @brief Initializes the context with an allocating xarray
+*
+* @param size Numbers of the random Integers to be inserted.
+* @param context Context to be initialized.
+*
+* @return 0 for success, otherwise appropriate error code.
+*/
+static int init_xarray(int size, void **context)
+{
+	project2_xarray_context *xa_context =
+			kmalloc(sizeof(project2_xarray_context), GFP_KERNEL);
+
+	if (!xa_context) {
+		printk (KERN_INFO "memory allocation for xarray head failed\n");
+		return -ENOMEM;
+	}
+
+	xa_init_flags(&xa_context->xa, XA_FLAGS_ALLOC);
+	xa_context->mode = project2_id_alloc;
+	xa_context->next = 0;
+
+	// Cyclic ids keep climbing past size, up to INT_MAX.
+	xa_context->limit = xa_context->mode == PROJECT2_ID_CYCLIC ?
+							INT_MAX : size;
+
+	if (xa_context->mode == PROJECT2_ID_SPARSE)
+		printk(KERN_INFO "Using the keys as ids");
+	else
+		printk(KERN_INFO "Using range for id as [%d, %u)", 0,
+							xa_context->limit);
+
+	*context = xa_context;
+
+	return 0;
+}
+
+// Generates the handles for the xarray test-case
+PROJECT2_GENERATE_HANDLE(xarray,
+			PROJECT2_HANDLE_OP(xarray, add_batch),
+			PROJECT2_HANDLE_OP(xarray, remove_batch),
+			PROJECT2_HANDLE_OP(xarray, lookup),
+			PROJECT2_HANDLE_OP(xarray, remove_range),
+			PROJECT2_HANDLE_FLAGS(xarray, PROJECT2_HANDLE_THREAD_SAFE));
+
+// Module related macros
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Abhishek Chauhan <zxcve@vt.edu>");
+MODULE_DESCRIPTION("Project2 for manipulation of xarray data structures\n");